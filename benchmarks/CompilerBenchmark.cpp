@@ -0,0 +1,226 @@
+// Compiler scalability benchmark. Synthesizes a corpus of schema files -- chains of files which include their
+// predecessor, every file includes a file with a wide union and declares tables referencing tables of the same and of
+// the included file -- and measures how long the compiler takes for it: parsing alone, compiling (parsing, type
+// resolution and verification) and generating code. The peak memory (maximum resident set size) is reported after
+// every phase. The time report of the compiler breaks compiling and generating down into its phases (parse, resolve,
+// verify, layout and emit).
+//
+// With --scale the corpus is compiled at 1/8, 1/4, 1/2 and the full number of files. The growth column is the time
+// relative to the previous (half as large) corpus, linear phases stay close to 2.
+//
+// Usage: flowflat_compiler_bench [--files N] [--tables N] [--fields N] [--chain N] [--union N] [--scale] [--keep]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+
+#include "flatbuffers/Compiler.h"
+#include "flatbuffers/MappedFile.h"
+#include "flatbuffers/Parser.h"
+
+using namespace std::string_view_literals;
+
+namespace {
+
+struct Corpus {
+	// number of schema files (without the file declaring the union)
+	int files = 2000;
+	// tables per file
+	int tables = 10;
+	// scalar fields per table (on top of the fields referencing other types)
+	int fields = 8;
+	// the length of the include chains
+	int chain = 50;
+	// the number of tables in the union
+	int unionWidth = 256;
+};
+
+void writeUnionFile(boost::filesystem::path const& dir, Corpus const& corpus) {
+	std::string res = "namespace Corpus.Wide;\n\n";
+	for (int m = 0; m < corpus.unionWidth; ++m) {
+		fmt::format_to(std::back_inserter(res), "table Member{} {{ id: ulong; name: string; }}\n", m);
+	}
+	res += "\nunion Any {\n";
+	for (int m = 0; m < corpus.unionWidth; ++m) {
+		fmt::format_to(std::back_inserter(res), "  Member{},\n", m);
+	}
+	res += "}\n";
+	std::ofstream((dir / "wide.fbs").c_str()) << res;
+}
+
+void writeFile(boost::filesystem::path const& dir, Corpus const& corpus, int f) {
+	static constexpr std::string_view scalarTypes[] = { "int", "ulong", "double", "bool", "short", "float", "Kind" };
+	bool includesPrevious = f % corpus.chain != 0;
+	std::string res = "include \"wide.fbs\";\n";
+	if (includesPrevious) {
+		fmt::format_to(std::back_inserter(res), "include \"file{}.fbs\";\n", f - 1);
+	}
+	fmt::format_to(std::back_inserter(res), "\nnamespace Corpus.F{};\n\n", f);
+	res += "enum Kind : ubyte { A, B, C }\n\n";
+	res += "struct Position {\n  x: double;\n  y: double;\n  kind: Kind;\n}\n\n";
+	// tables are declared in reverse, so every table only references tables which were declared before it
+	for (int t = corpus.tables - 1; t >= 0; --t) {
+		fmt::format_to(std::back_inserter(res), "table Table{} {{\n  id: ulong;\n  name: string;\n", t);
+		res += "  position: Position;\n  values: [int];\n  any: Corpus.Wide.Any;\n";
+		if (t + 1 < corpus.tables) {
+			fmt::format_to(std::back_inserter(res), "  next: Table{};\n  more: [Table{}];\n", t + 1, t + 1);
+		}
+		if (includesPrevious) {
+			fmt::format_to(std::back_inserter(res), "  previous: Corpus.F{}.Table{};\n", f - 1, t);
+		}
+		for (int i = 0; i < corpus.fields; ++i) {
+			auto type = scalarTypes[(t + i) % std::size(scalarTypes)];
+			fmt::format_to(std::back_inserter(res), "  field{}: {};\n", i, type);
+		}
+		res += "}\n\n";
+	}
+	res += "root_type Table0;\n";
+	std::ofstream((dir / fmt::format("file{}.fbs", f)).c_str()) << res;
+}
+
+// the maximum resident set size of the process so far
+double peakMegabytes() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return double(usage.ru_maxrss) / 1024.0;
+}
+
+template <class Fun>
+double measure(Fun fun) {
+	auto start = std::chrono::steady_clock::now();
+	fun();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+struct Phase {
+	std::string name;
+	double seconds;
+	// not measured for the phases of the time report
+	std::optional<double> peakMegabytes;
+};
+
+std::vector<Phase> run(boost::filesystem::path const& dir, Corpus const& corpus) {
+	namespace fs = boost::filesystem;
+	fs::create_directories(dir / "out");
+	writeUnionFile(dir, corpus);
+	std::vector<std::string> paths;
+	for (int f = 0; f < corpus.files; ++f) {
+		writeFile(dir, corpus, f);
+		paths.push_back((dir / fmt::format("file{}.fbs", f)).string());
+	}
+
+	std::vector<Phase> res;
+	res.push_back({ "parse",
+	                measure([&]() {
+		                flatbuffers::StringPool symbols;
+		                for (auto const& path : paths) {
+			                flatbuffers::MappedFile file(path);
+			                (void)flatbuffers::parseSchema(file.contents(), symbols);
+		                }
+	                }),
+	                peakMegabytes() });
+	flatbuffers::Compiler compiler({});
+	compiler.timeReport().enable();
+	res.push_back({ "compile",
+	                measure([&]() {
+		                for (auto const& path : paths) {
+			                compiler.compile(path);
+		                }
+	                }),
+	                peakMegabytes() });
+	auto out = (dir / "out").string();
+	res.push_back({ "generate", measure([&]() { compiler.generateCode(out, out); }), peakMegabytes() });
+	for (auto const& [phase, m] : compiler.timeReport().totals()) {
+		res.push_back({ fmt::format("  {}", flatbuffers::phaseName(phase)), m.wall, {} });
+	}
+	return res;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+	Corpus corpus;
+	bool scale = false;
+	bool keep = false;
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && argv[i] == "--files"sv) {
+			corpus.files = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--tables"sv) {
+			corpus.tables = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--fields"sv) {
+			corpus.fields = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--chain"sv) {
+			corpus.chain = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--union"sv) {
+			corpus.unionWidth = std::atoi(argv[++i]);
+		} else if (argv[i] == "--scale"sv) {
+			scale = true;
+		} else if (argv[i] == "--keep"sv) {
+			keep = true;
+		} else {
+			fmt::print(stderr,
+			           "Usage: {} [--files N] [--tables N] [--fields N] [--chain N] [--union N] [--scale] [--keep]\n",
+			           argv[0]);
+			return 1;
+		}
+	}
+	if (corpus.files < 1 || corpus.tables < 1 || corpus.fields < 0 || corpus.chain < 1 || corpus.unionWidth < 1) {
+		fmt::print(stderr, "--files, --tables, --chain and --union must be positive\n");
+		return 1;
+	}
+
+	std::vector<int> sizes{ corpus.files };
+	if (scale) {
+		sizes.clear();
+		for (int divisor : { 8, 4, 2, 1 }) {
+			sizes.push_back(std::max(1, corpus.files / divisor));
+		}
+	}
+	std::vector<Phase> previous;
+	for (auto files : sizes) {
+		Corpus current = corpus;
+		current.files = files;
+		auto tables = current.files * current.tables + current.unionWidth;
+		auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("corpus-%%%%%%");
+		fmt::print("Corpus: {} files, {} tables, include chains of {}, union of {} tables\n",
+		           current.files,
+		           tables,
+		           std::min(current.chain, current.files),
+		           current.unionWidth);
+		auto phases = run(dir, current);
+		for (std::size_t p = 0; p < phases.size(); ++p) {
+			fmt::print("  {:<10} {:>10.3f} s {:>10.2f} us/table",
+			           phases[p].name,
+			           phases[p].seconds,
+			           phases[p].seconds * 1e6 / tables);
+			if (phases[p].peakMegabytes) {
+				fmt::print(" {:>10.1f} MB peak", *phases[p].peakMegabytes);
+			} else {
+				fmt::print(" {:>18}", "");
+			}
+			if (p < previous.size() && previous[p].name == phases[p].name) {
+				fmt::print(" {:>8.2f} growth", phases[p].seconds / previous[p].seconds);
+			}
+			fmt::print("\n");
+		}
+		previous = phases;
+		if (keep) {
+			fmt::print("  kept in {}\n", dir.string());
+		} else {
+			boost::filesystem::remove_all(dir);
+		}
+	}
+	return 0;
+}
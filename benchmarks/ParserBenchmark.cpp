@@ -0,0 +1,127 @@
+// Parse throughput benchmark. Generates a large schema (tables, structs, enums, unions and comments) and measures how
+// fast parseSchema gets through it -- once from memory and once through a memory mapped file. The throughput of the
+// lexer alone is reported as well, the difference to the full parse is the cost of building the AST.
+//
+// Usage: flowflat_parser_bench [--tables N] [--fields N] [--iterations N]
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+
+#include "flatbuffers/Lexer.h"
+#include "flatbuffers/MappedFile.h"
+#include "flatbuffers/Parser.h"
+
+using namespace std::string_view_literals;
+
+namespace {
+
+std::string generateSchema(int tables, int fields) {
+	static constexpr std::string_view fieldTypes[] = { "int", "ulong", "string", "[ubyte]", "double", "bool", "Vec3" };
+	std::string res;
+	res.reserve(std::size_t(tables) * fields * 32);
+	res += "// generated schema for the parser benchmark\nnamespace Bench.Generated;\n\n";
+	res += "struct Vec3 {\n  x: float;\n  y: float;\n  z: float;\n}\n\n";
+	for (int t = 0; t < tables; ++t) {
+		if (t % 10 == 0) {
+			fmt::format_to(std::back_inserter(res), "enum Kind{} : ubyte {{ A = 1, B, C, D }}\n\n", t);
+		}
+		fmt::format_to(std::back_inserter(res), "/* table number {} */\ntable Table{} {{\n", t, t);
+		for (int f = 0; f < fields; ++f) {
+			auto type = fieldTypes[(t + f) % std::size(fieldTypes)];
+			fmt::format_to(std::back_inserter(res), "  field_{}: {}", f, type);
+			if (type == "int"sv) {
+				fmt::format_to(std::back_inserter(res), " = {}", f);
+			}
+			if (f % 7 == 3) {
+				res += " (deprecated)";
+			}
+			res += "; // a field\n";
+		}
+		res += "}\n\n";
+		if (t % 10 == 9) {
+			fmt::format_to(std::back_inserter(res), "union Any{} {{ Table{}, Table{} }}\n\n", t, t - 1, t);
+		}
+	}
+	res += "root_type Table0;\n";
+	return res;
+}
+
+template <class Fun>
+double measure(int iterations, Fun fun) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		fun();
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+void report(std::string_view name, std::size_t bytes, int iterations, double seconds) {
+	fmt::print("{:<16} {:>10.3f} ms/iteration {:>10.2f} MB/s\n",
+	           name,
+	           seconds * 1000.0 / iterations,
+	           double(bytes) * iterations / seconds / (1024.0 * 1024.0));
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+	int tables = 10000;
+	int fields = 20;
+	int iterations = 5;
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && argv[i] == "--tables"sv) {
+			tables = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--fields"sv) {
+			fields = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--iterations"sv) {
+			iterations = std::atoi(argv[++i]);
+		} else {
+			fmt::print(stderr, "Usage: {} [--tables N] [--fields N] [--iterations N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	auto schema = generateSchema(tables, fields);
+	fmt::print("Schema: {} tables, {} fields per table, {:.2f} MB\n",
+	           tables,
+	           fields,
+	           double(schema.size()) / (1024.0 * 1024.0));
+
+	std::size_t tokens = 0;
+	auto lexer = measure(iterations, [&]() {
+		flatbuffers::Lexer lexer(schema);
+		tokens = 0;
+		while (lexer.next().kind != flatbuffers::TokenKind::End) {
+			++tokens;
+		}
+	});
+	report("lexer", schema.size(), iterations, lexer);
+
+	std::size_t declarations = 0;
+	// every iteration simulates a new compilation, so it also pays for interning all identifiers
+	auto inMemory = measure(iterations, [&]() {
+		flatbuffers::StringPool symbols;
+		declarations = flatbuffers::parseSchema(schema, symbols).declarations.size();
+	});
+	report("memory", schema.size(), iterations, inMemory);
+
+	auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("bench-%%%%%%.fbs");
+	std::ofstream(path.c_str()) << schema;
+	auto mapped = measure(iterations, [&]() {
+		flatbuffers::StringPool symbols;
+		flatbuffers::MappedFile file(path);
+		declarations = flatbuffers::parseSchema(file.contents(), symbols).declarations.size();
+	});
+	report("mmap", schema.size(), iterations, mapped);
+	boost::filesystem::remove(path);
+
+	fmt::print("{} tokens and {} declarations per iteration\n", tokens, declarations);
+	return 0;
+}
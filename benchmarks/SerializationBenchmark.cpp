@@ -0,0 +1,419 @@
+// Serialization benchmark. Generates random messages of a configurable shape for the schema in serialization.fbs and
+// measures the generated code: encoding (write), decoding into native objects (read), walking the buffer through views,
+// verification and a round trip (read followed by write). Every operation reports ns/op, throughput, the size of the
+// buffer and how many allocations it needs.
+//
+// Results can be saved and later compared against, the benchmark then fails if an operation got slower by more than
+// the threshold (in percent):
+//
+//   flowflat_serialization_bench --save baseline.txt
+//   flowflat_serialization_bench --baseline baseline.txt [--threshold 10]
+//
+// Usage: flowflat_serialization_bench [--depth N] [--fanout N] [--records N] [--wide] [--strings N] [--vectors N]
+//                                     [--seed N] [--iterations N] [--save FILE] [--baseline FILE] [--threshold N]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "serialization.h"
+
+using namespace std::string_view_literals;
+
+namespace {
+
+std::atomic<std::size_t> allocations{ 0 };
+
+} // namespace
+
+void* operator new(std::size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (auto res = std::malloc(size ? size : 1)) {
+		return res;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+
+// The shape of the generated messages. Sizes are averages, the generator picks every size from [n/2, n + n/2].
+struct Shape {
+	// the number of levels of the message tree (1 to 4)
+	int depth = 3;
+	// children per table
+	int fanout = 4;
+	// records per table
+	int records = 8;
+	// whether records are Wide or Narrow tables
+	bool wide = false;
+	int stringLength = 16;
+	int vectorSize = 32;
+};
+
+class Generator {
+	Shape const& shape;
+	std::mt19937_64 random;
+
+	template <class T, class = void>
+	struct HasChildren : std::false_type {};
+	template <class T>
+	struct HasChildren<T, std::void_t<decltype(std::declval<T&>().children)>> : std::true_type {};
+
+public:
+	Generator(Shape const& shape, uint64_t seed) : shape(shape), random(seed) {}
+
+	std::size_t size(int average) {
+		return std::uniform_int_distribution<std::size_t>(average / 2, average + average / 2)(random);
+	}
+
+	template <class T>
+	T scalar() {
+		return T(random());
+	}
+
+	double real() { return std::uniform_real_distribution<double>(-1e6, 1e6)(random); }
+
+	std::string string() {
+		std::string res(size(shape.stringLength), ' ');
+		for (auto& c : res) {
+			c = char('a' + random() % 26);
+		}
+		return res;
+	}
+
+	template <class T, class Fun>
+	std::vector<T> vector(int average, Fun element) {
+		std::vector<T> res(size(average));
+		for (auto& e : res) {
+			e = element();
+		}
+		return res;
+	}
+
+	Bench::Point point() { return Bench::Point{ real(), real(), real() }; }
+
+	Bench::Narrow narrow() {
+		Bench::Narrow res;
+		res.id = random();
+		res.name = string();
+		res.value = real();
+		res.flag = random() % 2;
+		return res;
+	}
+
+	Bench::Wide wide() {
+		Bench::Wide res;
+		res.id = random();
+		res.name = string();
+		res.description = string();
+		res.a = scalar<char>();
+		res.b = scalar<unsigned char>();
+		res.c = scalar<short>();
+		res.d = scalar<unsigned short>();
+		res.e = scalar<int>();
+		res.f = scalar<unsigned>();
+		res.g = scalar<long>();
+		res.h = float(real());
+		res.i = real();
+		res.flag = random() % 2;
+		res.color = Bench::Color(random() % 3);
+		res.position = point();
+		res.velocity = point();
+		res.ints = vector<int>(shape.vectorSize, [this]() { return scalar<int>(); });
+		res.doubles = vector<double>(shape.vectorSize, [this]() { return real(); });
+		res.bytes = vector<unsigned char>(shape.vectorSize, [this]() { return scalar<unsigned char>(); });
+		res.names = vector<std::string>(shape.records, [this]() { return string(); });
+		res.points = vector<Bench::Point>(shape.records, [this]() { return point(); });
+		res.colors = vector<Bench::Color>(shape.vectorSize, [this]() { return Bench::Color(random() % 3); });
+		res.note = string();
+		return res;
+	}
+
+	template <class T>
+	void level(T& res, int depth) {
+		res.id = random();
+		res.label = string();
+		res.tags = vector<std::string>(shape.records, [this]() { return string(); });
+		res.payload = vector<unsigned char>(shape.vectorSize, [this]() { return scalar<unsigned char>(); });
+		if (shape.wide) {
+			res.wide = vector<Bench::Wide>(shape.records, [this]() { return wide(); });
+		} else {
+			res.narrow = vector<Bench::Narrow>(shape.records, [this]() { return narrow(); });
+		}
+		if constexpr (HasChildren<T>::value) {
+			if (depth + 1 < shape.depth) {
+				res.children.resize(size(shape.fanout));
+				for (auto& child : res.children) {
+					level(child, depth + 1);
+				}
+			}
+		}
+	}
+
+	Bench::Level0 message() {
+		Bench::Level0 res;
+		level(res, 0);
+		return res;
+	}
+};
+
+// Reads every field through views, the result only exists so the compiler can't drop the accesses
+struct Walker {
+	template <class V, class = void>
+	struct HasChildren : std::false_type {};
+	template <class V>
+	struct HasChildren<V, std::void_t<decltype(std::declval<V const&>().children())>> : std::true_type {};
+
+	uint64_t sum = 0;
+
+	void point(Bench::Point const& p) { sum += uint64_t(p.x + p.y + p.z); }
+
+	template <class Vector>
+	void strings(Vector const& v) {
+		for (auto s : v) {
+			sum += s.size();
+		}
+	}
+
+	template <class Vector>
+	void scalars(Vector const& v) {
+		for (auto e : v) {
+			sum += uint64_t(e);
+		}
+	}
+
+	void narrow(Bench::Narrow::View v) {
+		sum += v.id() + v.name().size() + uint64_t(v.value()) + v.flag();
+	}
+
+	void wide(Bench::Wide::View v) {
+		sum += v.id() + v.name().size() + v.description().size();
+		sum += uint64_t(v.a() + v.b() + v.c() + v.d() + v.e() + v.f() + v.g() + v.h() + v.i()) + v.flag();
+		sum += uint64_t(v.color());
+		point(v.position());
+		point(v.velocity());
+		scalars(v.ints());
+		scalars(v.doubles());
+		scalars(v.bytes());
+		strings(v.names());
+		for (auto p : v.points()) {
+			point(p);
+		}
+		scalars(v.colors());
+		sum += v.note().size();
+	}
+
+	template <class V>
+	void level(V v) {
+		sum += v.id() + v.label().size();
+		strings(v.tags());
+		scalars(v.payload());
+		for (auto r : v.narrow()) {
+			narrow(r);
+		}
+		for (auto r : v.wide()) {
+			wide(r);
+		}
+		if constexpr (HasChildren<V>::value) {
+			for (auto child : v.children()) {
+				level(child);
+			}
+		}
+	}
+};
+
+struct Result {
+	double nsPerOp = 0;
+	double bytesPerOp = 0;
+	double allocationsPerOp = 0;
+};
+
+template <class Fun>
+Result measure(int iterations, std::size_t bytes, Fun fun) {
+	auto allocated = allocations.load();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		fun();
+	}
+	std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+	return Result{ elapsed.count() / iterations,
+		           double(bytes),
+		           double(allocations.load() - allocated) / iterations };
+}
+
+void report(std::string_view name, Result const& r, Result const* baseline) {
+	fmt::print("{:<10} {:>14.0f} ns/op {:>10.2f} MB/s {:>10.0f} bytes/op {:>10.1f} allocs/op",
+	           name,
+	           r.nsPerOp,
+	           r.bytesPerOp / r.nsPerOp * 1e9 / (1024.0 * 1024.0),
+	           r.bytesPerOp,
+	           r.allocationsPerOp);
+	if (baseline) {
+		fmt::print(" {:>+8.1f}% time {:>+8.1f} allocs/op",
+		           (r.nsPerOp / baseline->nsPerOp - 1.0) * 100.0,
+		           r.allocationsPerOp - baseline->allocationsPerOp);
+	}
+	fmt::print("\n");
+}
+
+// baseline files have one line per operation: name ns/op bytes/op allocs/op
+std::map<std::string, Result> loadBaseline(char const* path) {
+	std::map<std::string, Result> res;
+	std::ifstream in(path);
+	if (!in) {
+		fmt::print(stderr, "Can't read baseline {}\n", path);
+		std::exit(1);
+	}
+	std::string name;
+	Result r;
+	while (in >> name >> r.nsPerOp >> r.bytesPerOp >> r.allocationsPerOp) {
+		res[name] = r;
+	}
+	return res;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+	Shape shape;
+	uint64_t seed = 42;
+	int iterations = 100;
+	char const* save = nullptr;
+	char const* baselinePath = nullptr;
+	double threshold = 10.0;
+	for (int i = 1; i < argc; ++i) {
+		if (i + 1 < argc && argv[i] == "--depth"sv) {
+			shape.depth = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--fanout"sv) {
+			shape.fanout = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--records"sv) {
+			shape.records = std::atoi(argv[++i]);
+		} else if (argv[i] == "--wide"sv) {
+			shape.wide = true;
+		} else if (i + 1 < argc && argv[i] == "--strings"sv) {
+			shape.stringLength = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--vectors"sv) {
+			shape.vectorSize = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--seed"sv) {
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		} else if (i + 1 < argc && argv[i] == "--iterations"sv) {
+			iterations = std::atoi(argv[++i]);
+		} else if (i + 1 < argc && argv[i] == "--save"sv) {
+			save = argv[++i];
+		} else if (i + 1 < argc && argv[i] == "--baseline"sv) {
+			baselinePath = argv[++i];
+		} else if (i + 1 < argc && argv[i] == "--threshold"sv) {
+			threshold = std::atof(argv[++i]);
+		} else {
+			fmt::print(stderr,
+			           "Usage: {} [--depth N] [--fanout N] [--records N] [--wide] [--strings N] [--vectors N] "
+			           "[--seed N] [--iterations N] [--save FILE] [--baseline FILE] [--threshold N]\n",
+			           argv[0]);
+			return 1;
+		}
+	}
+	if (shape.depth < 1 || shape.depth > 4 || iterations < 1) {
+		fmt::print(stderr, "--depth must be between 1 and 4 and --iterations positive\n");
+		return 1;
+	}
+
+	auto message = Generator(shape, seed).message();
+	flowflat::NewWriter encoded;
+	message.write(encoded);
+	auto buffer = encoded.data();
+	std::size_t size = encoded.size();
+	fmt::print("Message: depth {}, fanout {}, {} {} records per table, {:.2f} KB\n",
+	           shape.depth,
+	           shape.fanout,
+	           shape.records,
+	           shape.wide ? "wide" : "narrow",
+	           double(size) / 1024.0);
+
+	// the round trip has to reproduce the buffer, otherwise the numbers are meaningless
+	flowflat::NewWriter again;
+	Bench::Level0::read(buffer).write(again);
+	if (!Bench::Level0::verify(buffer, size) || std::size_t(again.size()) != size ||
+	    std::memcmp(again.data(), buffer, size) != 0) {
+		fmt::print(stderr, "Round trip doesn't reproduce the buffer\n");
+		return 1;
+	}
+
+	uint64_t sink = 0;
+	std::vector<std::pair<std::string_view, Result>> results;
+	results.emplace_back("encode", measure(iterations, size, [&]() {
+		                     flowflat::NewWriter w;
+		                     message.write(w);
+		                     sink += w.size();
+	                     }));
+	results.emplace_back("decode", measure(iterations, size, [&]() {
+		                     auto decoded = Bench::Level0::read(buffer);
+		                     sink += decoded.id;
+	                     }));
+	results.emplace_back("view", measure(iterations, size, [&]() {
+		                     Walker walker;
+		                     walker.level(Bench::Level0::view(buffer));
+		                     sink += walker.sum;
+	                     }));
+	results.emplace_back("verify", measure(iterations, size, [&]() { sink += Bench::Level0::verify(buffer, size); }));
+	results.emplace_back("roundtrip", measure(iterations, size, [&]() {
+		                     flowflat::NewWriter w;
+		                     Bench::Level0::read(buffer).write(w);
+		                     sink += w.size();
+	                     }));
+
+	std::map<std::string, Result> baseline;
+	if (baselinePath) {
+		baseline = loadBaseline(baselinePath);
+	}
+	bool regressed = false;
+	for (auto const& [name, result] : results) {
+		auto iter = baseline.find(std::string(name));
+		auto previous = iter == baseline.end() ? nullptr : &iter->second;
+		report(name, result, previous);
+		regressed = regressed || (previous && result.nsPerOp > previous->nsPerOp * (1.0 + threshold / 100.0));
+	}
+	if (save) {
+		std::ofstream out(save);
+		for (auto const& [name, result] : results) {
+			out << fmt::format("{} {} {} {}\n", name, result.nsPerOp, result.bytesPerOp, result.allocationsPerOp);
+		}
+	}
+	fmt::print("(checksum {})\n", sink);
+	if (regressed) {
+		fmt::print(stderr, "Slower than the baseline by more than {}%\n", threshold);
+		return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,253 @@
+#include "flowflat/container.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace flowflat::container {
+
+namespace {
+
+constexpr std::array<uint32_t, 256> crcTable = []() {
+	std::array<uint32_t, 256> res{};
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; ++bit) {
+			crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78 : 0);
+		}
+		res[i] = crc;
+	}
+	return res;
+}();
+
+constexpr std::size_t alignUp(std::size_t value, std::size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+struct Trailer {
+	uint64_t indexPosition = 0;
+	uint64_t count = 0;
+	uint32_t flags = 0;
+};
+
+// checks the header and the trailer of a container. Arithmetic is done in 64 bits, so a corrupt trailer can't wrap
+// around.
+Trailer readTrailer(char const* data, std::size_t size, char const* path) {
+	auto invalid = [path]() { return std::runtime_error(std::string("invalid container ") + path); };
+	if (size < headerSize + trailerSize || load<uint32_t>(data) != magic) {
+		throw invalid();
+	}
+	if (load<uint32_t>(data + 4) != version) {
+		throw std::runtime_error(std::string("unsupported container version in ") + path);
+	}
+	auto trailer = data + size - trailerSize;
+	Trailer res{ load<uint64_t>(trailer), load<uint64_t>(trailer + 8), load<uint32_t>(trailer + 16) };
+	if (load<uint32_t>(trailer + 20) != indexMagic || res.flags != load<uint32_t>(data + 8) ||
+	    res.indexPosition < headerSize || res.indexPosition % recordAlignment != 0 ||
+	    res.count > (size - trailerSize - res.indexPosition) / sizeof(uint64_t) ||
+	    res.indexPosition + res.count * sizeof(uint64_t) != size - trailerSize) {
+		throw invalid();
+	}
+	return res;
+}
+
+} // namespace
+
+uint32_t crc32c(char const* data, std::size_t size) {
+	uint32_t crc = ~uint32_t(0);
+	for (std::size_t i = 0; i < size; ++i) {
+		crc = (crc >> 8) ^ crcTable[(crc ^ uint8_t(data[i])) & 0xff];
+	}
+	return ~crc;
+}
+
+Writer::Writer(char const* path, bool checksums) : checksums(checksums) {
+	fd = ::open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		throw std::runtime_error(std::string("can't open container ") + path);
+	}
+	struct stat st {};
+	if (::fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error(std::string("can't read container ") + path);
+	}
+	try {
+		if (st.st_size == 0) {
+			reserve(headerSize);
+			store(mapping, magic);
+			store(mapping + 4, version);
+			store(mapping + 8, checksums ? checksumFlag : 0u);
+			store(mapping + 12, uint32_t(0));
+			return;
+		}
+		// append: the index is loaded and new records overwrite it. The file is only grown after it was found to be
+		// a container.
+		auto existing = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (existing == MAP_FAILED) {
+			throw std::runtime_error(std::string("can't map container ") + path);
+		}
+		try {
+			auto data = static_cast<char const*>(existing);
+			auto trailer = readTrailer(data, st.st_size, path);
+			this->checksums = (trailer.flags & checksumFlag) != 0;
+			index.resize(trailer.count);
+			std::memcpy(index.data(), data + trailer.indexPosition, trailer.count * sizeof(uint64_t));
+			used = trailer.indexPosition;
+		} catch (...) {
+			::munmap(existing, st.st_size);
+			throw;
+		}
+		::munmap(existing, st.st_size);
+		reserve(st.st_size);
+	} catch (...) {
+		if (mapping) {
+			::munmap(mapping, capacity);
+		}
+		::close(fd);
+		throw;
+	}
+}
+
+Writer::~Writer() {
+	try {
+		close();
+	} catch (std::runtime_error&) {
+	}
+}
+
+void Writer::reserve(std::size_t size) {
+	if (size <= capacity) {
+		return;
+	}
+	// grow geometrically, so appending n records maps the file O(log n) times
+	auto newCapacity = alignUp(std::max({ size, 2 * capacity, std::size_t(1) << 20 }), 1 << 12);
+	if (mapping) {
+		::munmap(mapping, capacity);
+		mapping = nullptr;
+	}
+	struct stat st {};
+	if (::fstat(fd, &st) != 0 || (std::size_t(st.st_size) < newCapacity && ::ftruncate(fd, off_t(newCapacity)) != 0)) {
+		throw std::runtime_error("can't grow container");
+	}
+	auto res = ::mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (res == MAP_FAILED) {
+		throw std::runtime_error("can't map container");
+	}
+	mapping = static_cast<char*>(res);
+	capacity = newCapacity;
+}
+
+void Writer::seal() {
+	if (unsealed && checksums) {
+		auto record = mapping + *unsealed;
+		store(record + 4, crc32c(record + recordHeaderSize, load<uint32_t>(record)));
+	}
+	unsealed.reset();
+}
+
+char* Writer::allocateBuffer(int bytes) {
+	if (fd < 0) {
+		throw std::runtime_error("container is closed");
+	}
+	seal();
+	auto position = alignUp(used, recordAlignment);
+	reserve(position + recordHeaderSize + bytes);
+	std::memset(mapping + used, 0, position - used);
+	store(mapping + position, uint32_t(bytes));
+	store(mapping + position + 4, uint32_t(0));
+	index.push_back(position);
+	unsealed = position;
+	used = position + recordHeaderSize + bytes;
+	return mapping + position + recordHeaderSize;
+}
+
+void Writer::close() {
+	if (fd < 0) {
+		return;
+	}
+	seal();
+	auto indexPosition = alignUp(used, recordAlignment);
+	auto size = indexPosition + index.size() * sizeof(uint64_t) + trailerSize;
+	reserve(size);
+	std::memset(mapping + used, 0, indexPosition - used);
+	std::memcpy(mapping + indexPosition, index.data(), index.size() * sizeof(uint64_t));
+	auto trailer = mapping + size - trailerSize;
+	store(trailer, uint64_t(indexPosition));
+	store(trailer + 8, uint64_t(index.size()));
+	store(trailer + 16, checksums ? checksumFlag : 0u);
+	store(trailer + 20, indexMagic);
+	::munmap(mapping, capacity);
+	mapping = nullptr;
+	auto truncated = ::ftruncate(fd, off_t(size)) == 0;
+	::close(fd);
+	fd = -1;
+	if (!truncated) {
+		throw std::runtime_error("can't truncate container");
+	}
+}
+
+Reader::Reader(char const* path) {
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error(std::string("can't open container ") + path);
+	}
+	struct stat st {};
+	if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		throw std::runtime_error(std::string("can't read container ") + path);
+	}
+	length = st.st_size;
+	mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		throw std::runtime_error(std::string("can't map container ") + path);
+	}
+	try {
+		auto trailer = readTrailer(static_cast<char const*>(mapping), length, path);
+		index = static_cast<char const*>(mapping) + trailer.indexPosition;
+		indexPosition = trailer.indexPosition;
+		count = trailer.count;
+		checksums = (trailer.flags & checksumFlag) != 0;
+	} catch (...) {
+		::munmap(mapping, length);
+		mapping = nullptr;
+		throw;
+	}
+}
+
+Reader::~Reader() {
+	if (mapping) {
+		::munmap(mapping, length);
+	}
+}
+
+std::string_view Reader::record(std::size_t i) const {
+	auto position = load<uint64_t>(index + i * sizeof(uint64_t));
+	// indexPosition >= headerSize, so the right hand side can't wrap around (unlike position + recordHeaderSize)
+	if (position < headerSize || position % recordAlignment != 0 || position > indexPosition - recordHeaderSize) {
+		throw std::runtime_error("invalid container record");
+	}
+	auto record = static_cast<char const*>(mapping) + position;
+	auto size = load<uint32_t>(record);
+	if (size > indexPosition - position - recordHeaderSize) {
+		throw std::runtime_error("invalid container record");
+	}
+	return { record + recordHeaderSize, size };
+}
+
+bool Reader::checksumMatches(std::size_t i) const {
+	if (!checksums) {
+		return true;
+	}
+	auto buffer = record(i);
+	return load<uint32_t>(buffer.data() - recordHeaderSize + 4) == crc32c(buffer.data(), buffer.size());
+}
+
+} // namespace flowflat::container
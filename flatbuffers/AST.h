@@ -10,6 +10,8 @@
 
 #include <fmt/format.h>
 
+#include "StringPool.h"
+
 namespace flatbuffers::ast {
 
 class Visitor {
@@ -45,7 +47,7 @@ public:
 	virtual void endVisit(struct TableDeclaration const&) {}
 };
 
-using EnumValue = std::pair<std::string, std::optional<int>>;
+using EnumValue = std::pair<Symbol, std::optional<int>>;
 
 template <class Base>
 struct DefaultAccept : boost::spirit::x3::position_tagged {
@@ -59,18 +61,18 @@ struct IncludeDeclaration : DefaultAccept<IncludeDeclaration> {
 	std::string path;
 };
 
-using NamespacePath = std::vector<std::string>;
+using NamespacePath = std::vector<Symbol>;
 
 struct NamespaceDeclaration : DefaultAccept<NamespaceDeclaration> {
-	std::vector<std::string> name;
+	NamespacePath name;
 };
 
 struct AttributeDeclaration : DefaultAccept<AttributeDeclaration> {
-	std::string attribute;
+	Symbol attribute;
 };
 
 struct RootDeclaration : DefaultAccept<RootDeclaration> {
-	std::string rootType;
+	Symbol rootType;
 };
 
 struct FileExtensionDeclaration : DefaultAccept<FileExtensionDeclaration> {
@@ -82,24 +84,24 @@ struct FileIdentifierDeclaration : DefaultAccept<FileIdentifierDeclaration> {
 };
 
 struct ArrayType : DefaultAccept<ArrayType> {
-	std::string type;
+	Symbol type;
 };
 
-struct Type : boost::spirit::x3::variant<std::string, ArrayType>, DefaultAccept<Type> {
+struct Type : boost::spirit::x3::variant<Symbol, ArrayType>, DefaultAccept<Type> {
 	using base_type::base_type;
 	using base_type::operator=;
 
-	struct type_visitor : boost::static_visitor<std::string const&> {
-		std::string const& operator()(ArrayType const& t) const { return t.type; }
-		std::string const& operator()(std::string const& s) const { return s; }
+	struct type_visitor : boost::static_visitor<Symbol> {
+		Symbol operator()(ArrayType const& t) const { return t.type; }
+		Symbol operator()(Symbol s) const { return s; }
 	};
 
 	struct is_array_visitor : boost::static_visitor<bool> {
 		bool operator()(ArrayType const& t) const { return true; }
-		bool operator()(std::string const& s) const { return false; }
+		bool operator()(Symbol s) const { return false; }
 	};
 
-	[[nodiscard]] std::string const& type() const { return boost::apply_visitor(type_visitor(), *this); }
+	[[nodiscard]] Symbol type() const { return boost::apply_visitor(type_visitor(), *this); }
 
 	[[nodiscard]] bool isArray() const { return boost::apply_visitor(is_array_visitor(), *this); }
 };
@@ -131,30 +133,32 @@ struct SingleValue : boost::spirit::x3::variant<Scalar, std::string>, boost::spi
 	}
 };
 
-using Metadata = std::map<std::string, std::optional<SingleValue>>;
+// metadata lists are short (usually zero or one entry), so a flat list in declaration order is cheaper than a map
+using MetadataEntry = std::pair<Symbol, std::optional<SingleValue>>;
+using Metadata = std::vector<MetadataEntry>;
 
 struct EnumDeclaration : DefaultAccept<EnumDeclaration> {
-	std::string identifier;
-	std::string type;
+	Symbol identifier;
+	Symbol type;
 	Metadata metadata;
 	std::vector<EnumValue> enumerations;
 };
 
 struct UnionDeclaration : DefaultAccept<UnionDeclaration> {
-	std::string identifier;
+	Symbol identifier;
 	Metadata metadata;
 	std::vector<EnumValue> enumerations;
 };
 
 struct FieldDeclaration : DefaultAccept<FieldDeclaration> {
-	std::string identifier;
+	Symbol identifier;
 	Type type;
 	std::optional<SingleValue> value;
 	Metadata metadata;
 };
 
 struct StructDeclaration : boost::spirit::x3::position_tagged {
-	std::string identifier;
+	Symbol identifier;
 	Metadata metadata;
 	std::vector<FieldDeclaration> fields;
 
@@ -168,7 +172,7 @@ struct StructDeclaration : boost::spirit::x3::position_tagged {
 };
 
 struct TableDeclaration : boost::spirit::x3::position_tagged {
-	std::string identifier;
+	Symbol identifier;
 	Metadata metadata;
 	std::vector<FieldDeclaration> fields;
 
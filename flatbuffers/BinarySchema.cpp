@@ -0,0 +1,393 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+#include <flowflat/schema.h>
+
+#include "Compiler.h"
+#include "StaticContext.h"
+#include "MappedFile.h"
+#include "Error.h"
+
+namespace flatbuffers {
+
+namespace {
+
+namespace schema = flowflat::schema;
+using Path = boost::filesystem::path;
+
+schema::BaseType baseType(Symbol primitive) {
+	using schema::BaseType;
+	static boost::unordered_map<std::string_view, BaseType> const baseTypes{
+		{ "bool", BaseType::Bool },     { "byte", BaseType::Byte },       { "ubyte", BaseType::UByte },
+		{ "short", BaseType::Short },   { "ushort", BaseType::UShort },   { "int", BaseType::Int },
+		{ "uint", BaseType::UInt },     { "float", BaseType::Float },     { "long", BaseType::Long },
+		{ "ulong", BaseType::ULong },   { "double", BaseType::Double },   { "int8", BaseType::Byte },
+		{ "uint8", BaseType::UByte },   { "int16", BaseType::Short },     { "uint16", BaseType::UShort },
+		{ "int32", BaseType::Int },     { "uint32", BaseType::UInt },     { "int64", BaseType::Long },
+		{ "uint64", BaseType::ULong },  { "float32", BaseType::Float },   { "float64", BaseType::Double },
+		{ "string", BaseType::String },
+	};
+	auto iter = baseTypes.find(primitive.view());
+	assertTrue(iter != baseTypes.end());
+	return iter->second;
+}
+
+// Appends records to a buffer. Records are written in the order they are needed: a record which references an array
+// gets written after the array, so all offsets are known when a record is written.
+class SchemaBuilder {
+	std::string buffer = std::string(sizeof(schema::Header), '\0');
+	// the first string is the empty string, so a default constructed StringRef is valid
+	std::string stringTable = std::string(1, '\0');
+	boost::unordered_map<std::string, uint32_t> stringOffsets;
+
+	void align(std::size_t alignment) { buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, '\0'); }
+
+public:
+	template <class T>
+	schema::ArrayRef<T> append(std::vector<T> const& records) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		align(alignof(T));
+		schema::ArrayRef<T> res{ .offset = uint32_t(buffer.size()), .size = uint32_t(records.size()) };
+		buffer.append(reinterpret_cast<char const*>(records.data()), records.size() * sizeof(T));
+		return res;
+	}
+
+	schema::StringRef string(std::string_view str) {
+		if (str.empty()) {
+			return {};
+		}
+		auto [iter, inserted] = stringOffsets.emplace(std::string(str), uint32_t(stringTable.size()));
+		if (inserted) {
+			stringTable.append(str);
+			stringTable.push_back('\0');
+		}
+		return schema::StringRef{ .offset = iter->second, .size = uint32_t(str.size()) };
+	}
+
+	template <class Range>
+	schema::ArrayRef<schema::StringRef> strings(Range const& range) {
+		std::vector<schema::StringRef> refs;
+		for (auto const& s : range) {
+			refs.push_back(string(fmt::format("{}", s)));
+		}
+		return append(refs);
+	}
+
+	std::string finish(schema::Header header) {
+		header.strings =
+		    schema::ArrayRef<char>{ .offset = uint32_t(buffer.size()), .size = uint32_t(stringTable.size()) };
+		buffer.append(stringTable);
+		align(alignof(schema::EnumValue));
+		header.magic = schema::magic;
+		header.version = schema::version;
+		header.size = uint32_t(buffer.size());
+		std::copy_n(reinterpret_cast<char const*>(&header), sizeof(header), buffer.begin());
+		return std::move(buffer);
+	}
+};
+
+// the files in a binary schema are ordered such that every file comes after everything it includes
+std::vector<Path> dependencyOrder(boost::unordered_map<Path, std::shared_ptr<StaticContext>> const& files,
+                                  Path const& root) {
+	std::vector<Path> res;
+	boost::unordered_set<Path> visited{ root };
+	std::vector<std::pair<Path, std::size_t>> stack{ { root, 0 } };
+	while (!stack.empty()) {
+		auto& [current, next] = stack.back();
+		auto const& includes = files.at(current)->includes;
+		if (next < includes.size()) {
+			auto const& dep = includes[next++];
+			if (visited.insert(dep).second) {
+				stack.emplace_back(dep, 0);
+			}
+			continue;
+		}
+		res.push_back(current);
+		stack.pop_back();
+	}
+	return res;
+}
+
+std::string serialize(boost::unordered_map<Path, std::shared_ptr<StaticContext>> const& files, Path const& root) {
+	auto order = dependencyOrder(files, root);
+	boost::unordered_map<Path, uint32_t> fileIndexes;
+	boost::unordered_map<TypeName, uint32_t> typeIndexes;
+	for (auto const& path : order) {
+		fileIndexes[path] = fileIndexes.size();
+		auto const& tree = *files.at(path)->currentFile;
+		for (auto name : tree.declarationOrder) {
+			typeIndexes[TypeName{ .name = name, .path = tree.namespacePath.value_or(std::vector<Symbol>()) }] =
+			    typeIndexes.size();
+		}
+	}
+
+	SchemaBuilder builder;
+	// shared by all files, the layout of every type is computed once
+	boost::unordered_map<TypeName, SerializationInfo> serInfos;
+	std::vector<schema::File> fileRecords;
+	std::vector<schema::Type> typeRecords;
+	for (auto const& path : order) {
+		auto const& context = *files.at(path);
+		auto const& tree = *context.currentFile;
+		auto scope = tree.namespacePath.value_or(std::vector<Symbol>());
+		auto typeRef = [&](Symbol name) {
+			auto t = *assertTrue(context.resolveInScope(name, scope));
+			if (t.second->typeType() == expression::TypeType::Primitive) {
+				return schema::TypeRef::primitive(baseType(t.first.name));
+			}
+			return schema::TypeRef::type(typeIndexes.at(t.first));
+		};
+
+		std::vector<uint32_t> types;
+		for (auto name : tree.declarationOrder) {
+			types.push_back(uint32_t(typeRecords.size()));
+			auto const* type = *assertTrue(tree.findType(name));
+			schema::Type record{};
+			record.name = builder.string(name.view());
+			record.file = uint32_t(fileRecords.size());
+			switch (type->typeType()) {
+			case expression::TypeType::Enum: {
+				auto const& e = dynamic_cast<expression::Enum const&>(*type);
+				std::vector<schema::EnumValue> values;
+				for (auto const& [n, v] : e.values) {
+					values.push_back(schema::EnumValue{ .value = v, .name = builder.string(n.view()) });
+				}
+				record.kind = schema::Kind::Enum;
+				record.underlyingType = baseType(e.type);
+				record.underlyingTypeName = builder.string(e.type.view());
+				record.values = builder.append(values);
+				break;
+			}
+			case expression::TypeType::Union: {
+				auto const& u = dynamic_cast<expression::Union const&>(*type);
+				std::vector<schema::UnionMember> members;
+				for (auto member : u.types) {
+					members.push_back(
+					    schema::UnionMember{ .name = builder.string(member.view()), .type = typeRef(member) });
+				}
+				record.kind = schema::Kind::Union;
+				record.members = builder.append(members);
+				break;
+			}
+			case expression::TypeType::Struct:
+			case expression::TypeType::Table: {
+				auto const& s = dynamic_cast<expression::StructOrTable const&>(*type);
+				std::vector<schema::Field> fields;
+				for (auto const& field : s.fields) {
+					schema::Field f{};
+					f.name = builder.string(field.name.view());
+					f.typeName = builder.string(field.type.view());
+					f.type = typeRef(field.type);
+					f.flags = field.isArrayType ? schema::Field::IsArray : 0;
+					for (auto const& m : field.metadata) {
+						if (m.type == expression::MetadataType::deprecated) {
+							f.flags |= schema::Field::IsDeprecated;
+						} else if (m.type == expression::MetadataType::borrowed) {
+							f.flags |= schema::Field::IsBorrowed;
+						} else if (m.type == expression::MetadataType::hot) {
+							f.flags |= schema::Field::IsHot;
+						} else if (m.type == expression::MetadataType::nestedFlatbuffer) {
+							f.nestedFlatbuffer = builder.string(m.value.view());
+						}
+					}
+					if (field.defaultValue) {
+						f.flags |= schema::Field::HasDefault;
+						f.defaultValue = builder.string(field.defaultValue->view());
+					}
+					fields.push_back(f);
+				}
+				record.kind =
+				    type->typeType() == expression::TypeType::Table ? schema::Kind::Table : schema::Kind::Struct;
+				record.fields = builder.append(fields);
+				break;
+			}
+			case expression::TypeType::Primitive:
+				throw InternalError();
+			}
+			context.serializationInformation(serInfos, name);
+			auto const& info = serInfos.at(TypeName{ .name = name, .path = scope });
+			record.alignment = info.alignment;
+			record.staticSize = info.staticSize;
+			if (info.vtable) {
+				record.vtable = builder.append(*info.vtable);
+			}
+			typeRecords.push_back(record);
+		}
+
+		schema::File file{};
+		file.path = builder.string(path.string());
+		if (tree.namespacePath) {
+			file.flags |= schema::File::HasNamespace;
+			file.namespacePath = builder.strings(*tree.namespacePath);
+		}
+		if (tree.fileIdentifier) {
+			file.flags |= schema::File::HasIdentifier;
+			file.fileIdentifier = builder.string(*tree.fileIdentifier);
+		}
+		if (tree.fileExtension) {
+			file.flags |= schema::File::HasExtension;
+			file.fileExtension = builder.string(*tree.fileExtension);
+		}
+		// these are hash sets -- sort them so the output is deterministic
+		std::vector<Symbol> attributes(tree.attributes.begin(), tree.attributes.end());
+		std::sort(attributes.begin(), attributes.end());
+		file.attributes = builder.strings(attributes);
+		std::vector<Symbol> rootTypes(tree.rootTypes.begin(), tree.rootTypes.end());
+		std::sort(rootTypes.begin(), rootTypes.end());
+		file.rootTypes = builder.strings(rootTypes);
+		file.types = builder.append(types);
+		std::vector<uint32_t> includes;
+		for (auto const& incl : context.includes) {
+			includes.push_back(fileIndexes.at(incl));
+		}
+		file.includes = builder.append(includes);
+		fileRecords.push_back(file);
+	}
+
+	schema::Header header{};
+	header.root = uint32_t(fileRecords.size() - 1);
+	header.types = builder.append(typeRecords);
+	header.files = builder.append(fileRecords);
+	return builder.finish(header);
+}
+
+} // namespace
+
+void Compiler::writeBinarySchemas(std::string const& dir) const {
+	namespace fs = boost::filesystem;
+	for (auto const& [path, context] : compiledFiles) {
+		auto out = fs::path(dir) / (path.stem().string() + ".bfbs");
+		TimeReport::Scope scope(report, Phase::Emit, path.string());
+		auto contents = serialize(files, path);
+		std::ofstream stream(out.string(), std::ios::binary | std::ios::trunc);
+		stream.write(contents.data(), std::streamsize(contents.size()));
+		if (!stream) {
+			fmt::print(stderr, "Error: Can't write binary schema {}\n", out.string());
+			throw Error("Can't write binary schema");
+		}
+	}
+}
+
+// Loading a binary schema doesn't run the parser or the verifier: the schema was verified before it was written. Files
+// which are already known (because they were compiled or loaded before) are skipped.
+boost::filesystem::path Compiler::loadBinarySchema(boost::filesystem::path const& path) {
+	MappedFile file(path);
+	auto loaded = schema::Schema::open(file.contents().data(), file.size());
+	if (!loaded) {
+		fmt::print(stderr, "Error: {} is not a valid binary schema\n", path.string());
+		throw Error("Invalid binary schema");
+	}
+	auto const& s = *loaded;
+	auto intern = [this, &s](schema::StringRef ref) { return symbols.intern(s[ref]); };
+
+	std::vector<Path> paths;
+	for (auto const& f : s.files()) {
+		paths.emplace_back(std::string(s[f.path]));
+		if (files.contains(paths.back())) {
+			continue;
+		}
+		auto res = std::make_shared<StaticContext>(*this);
+		auto& tree = *res->currentFile;
+		for (auto incl : s[f.includes]) {
+			res->includes.push_back(paths[incl]);
+		}
+		if (f.flags & schema::File::HasNamespace) {
+			tree.namespacePath.emplace();
+			for (auto part : s[f.namespacePath]) {
+				tree.namespacePath->push_back(intern(part));
+			}
+		}
+		if (f.flags & schema::File::HasIdentifier) {
+			tree.fileIdentifier = std::string(s[f.fileIdentifier]);
+		}
+		if (f.flags & schema::File::HasExtension) {
+			tree.fileExtension = std::string(s[f.fileExtension]);
+		}
+		for (auto attr : s[f.attributes]) {
+			tree.attributes.insert(intern(attr));
+		}
+		for (auto root : s[f.rootTypes]) {
+			tree.rootTypes.insert(intern(root));
+		}
+		for (auto idx : s[f.types]) {
+			auto const& t = s.types()[idx];
+			auto name = intern(t.name);
+			tree.declarationOrder.push_back(name);
+			switch (t.kind) {
+			case schema::Kind::Enum: {
+				expression::Enum e(tree.arena);
+				e.name = name;
+				e.type = intern(t.underlyingTypeName);
+				for (auto const& v : s[t.values]) {
+					e.values.emplace_back(intern(v.name), v.value);
+				}
+				tree.enums.emplace(name, std::move(e));
+				break;
+			}
+			case schema::Kind::Union: {
+				expression::Union u(tree.arena);
+				u.name = name;
+				for (auto const& m : s[t.members]) {
+					u.types.push_back(intern(m.name));
+				}
+				tree.unions.emplace(name, std::move(u));
+				break;
+			}
+			case schema::Kind::Struct:
+			case schema::Kind::Table: {
+				auto fill = [&](expression::StructOrTable& res) {
+					res.name = name;
+					res.fields.reserve(t.fields.size);
+					for (auto const& field : s[t.fields]) {
+						expression::Field f(tree.arena);
+						f.name = intern(field.name);
+						f.type = intern(field.typeName);
+						f.isArrayType = field.isArray();
+						if (field.hasDefault()) {
+							f.defaultValue = intern(field.defaultValue);
+						}
+						if (field.isDeprecated()) {
+							f.metadata.push_back(
+							    expression::MetadataEntry{ .type = expression::MetadataType::deprecated, .value = {} });
+						}
+						if (field.isBorrowed()) {
+							f.metadata.push_back(
+							    expression::MetadataEntry{ .type = expression::MetadataType::borrowed, .value = {} });
+						}
+						if (field.isHot()) {
+							f.metadata.push_back(
+							    expression::MetadataEntry{ .type = expression::MetadataType::hot, .value = {} });
+						}
+						if (field.nestedFlatbuffer.size > 0) {
+							f.metadata.push_back(expression::MetadataEntry{
+							    .type = expression::MetadataType::nestedFlatbuffer,
+							    .value = intern(field.nestedFlatbuffer) });
+						}
+						res.fields.push_back(std::move(f));
+					}
+				};
+				if (t.kind == schema::Kind::Struct) {
+					expression::Struct res(tree.arena);
+					fill(res);
+					tree.structs.emplace(name, std::move(res));
+				} else {
+					expression::Table res(tree.arena);
+					fill(res);
+					// the stored layout might have been computed with a layout profile, so it isn't recomputed
+					auto vtable = s[t.vtable];
+					res.vtable.assign(vtable.begin(), vtable.end());
+					tree.tables.emplace(name, std::move(res));
+				}
+				break;
+			}
+			}
+		}
+		files[paths.back()] = std::move(res);
+	}
+	return paths[s.header().root];
+}
+
+} // namespace flatbuffers
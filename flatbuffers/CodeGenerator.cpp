@@ -4,7 +4,6 @@
 
 #include <fstream>
 #include <string>
-#include <any>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
@@ -35,18 +34,18 @@ struct Defer {
 	void operator()(std::function<void()> fun) { functions.push_back(std::move(fun)); }
 };
 
-std::string convertType(std::string const& t) {
+std::string convertType(Symbol t) {
 	if (auto iter = expression::primitiveTypes.find(t); iter != expression::primitiveTypes.end()) {
 		return std::string(iter->second.nativeName);
 	}
 	std::vector<std::string> path;
-	boost::split(path, t, boost::is_any_of("."));
+	boost::split(path, t.view(), boost::is_any_of("."));
 	return fmt::format("{}", fmt::join(path, "::"));
 }
 
-using DependencyMap = boost::unordered_map<std::string, boost::unordered_set<std::string>>;
+using DependencyMap = boost::unordered_map<Symbol, std::vector<Symbol>>;
 
-bool isInternalDependency(std::string const& type, expression::ExpressionTree const& tree) {
+bool isInternalDependency(Symbol type, expression::ExpressionTree const& tree) {
 	return tree.unions.contains(type) || tree.tables.contains(type) || tree.structs.contains(type);
 }
 
@@ -58,7 +57,7 @@ DependencyMap buildDependencyMap(expression::ExpressionTree const& tree) {
 		auto [iter, _] = res.emplace(n, DependencyMap::mapped_type());
 		for (auto const& t : u.types) {
 			if (isInternalDependency(t, tree)) {
-				iter->second.insert(t);
+				iter->second.push_back(t);
 			}
 		}
 	}
@@ -66,7 +65,11 @@ DependencyMap buildDependencyMap(expression::ExpressionTree const& tree) {
 		auto [iter, _] = res.emplace(s.name, DependencyMap::mapped_type());
 		for (auto const& f : s.fields) {
 			if (isInternalDependency(f.type, tree)) {
-				iter->second.insert(f.type);
+				iter->second.push_back(f.type);
+			}
+			// the view of a table exposes the view of its nested buffers
+			if (auto nested = f.nestedFlatbuffer(); nested && isInternalDependency(*nested, tree)) {
+				iter->second.push_back(*nested);
 			}
 		}
 	};
@@ -83,35 +86,47 @@ DependencyMap buildDependencyMap(expression::ExpressionTree const& tree) {
  * C++ doesn't allow us to use a type before it is declared. This function goes through all available types
  * and orders them by their dependencies. It will throw an error if this is not possible.
  *
+ * This is a depth first search that emits a type after all its dependencies were emitted. Roots are visited in
+ * declaration order and dependencies in field order, so the result only depends on the schema and the generated
+ * code is reproducible. Each type and each dependency edge is visited exactly once.
+ *
  * @param tree
  * @return A list of types in a conflict-free order
  */
-std::vector<std::string> establishEmitOrder(expression::ExpressionTree const& tree) {
-	std::vector<std::string> res;
-	boost::unordered_set<std::string> resolvedTypes;
+std::vector<Symbol> establishEmitOrder(expression::ExpressionTree const& tree) {
+	enum class Mark { Unvisited, InProgress, Done };
 	DependencyMap dependencies = buildDependencyMap(tree);
-	while (!dependencies.empty()) {
-		auto before = res.size();
-		// 0. remove all resolved types from all dependencies
-		for (auto& [name, deps] : dependencies) {
-			for (auto const& t : resolvedTypes) {
-				deps.erase(t);
-			}
+	boost::unordered_map<Symbol, Mark> marks;
+	std::vector<Symbol> res;
+	res.reserve(dependencies.size());
+	// we use an explicit stack (type, index of the next dependency to visit) as dependency chains can be very long
+	std::vector<std::pair<DependencyMap::const_iterator, std::size_t>> stack;
+	for (auto name : tree.declarationOrder) {
+		auto root = dependencies.find(name);
+		// enums are not part of the dependency map
+		if (root == dependencies.end() || marks[root->first] != Mark::Unvisited) {
+			continue;
 		}
-		// 1. collect all types with no dependencies
-		for (auto const& [name, deps] : dependencies) {
-			if (deps.empty()) {
-				res.push_back(name);
-				resolvedTypes.insert(name);
+		marks[root->first] = Mark::InProgress;
+		stack.emplace_back(root, 0);
+		while (!stack.empty()) {
+			auto& [iter, next] = stack.back();
+			if (next < iter->second.size()) {
+				auto dep = iter->second[next++];
+				auto& mark = marks[dep];
+				if (mark == Mark::InProgress) {
+					fmt::print(stderr, "Error: Cyclic dependency between {} and {}\n", iter->first, dep);
+					throw Error("Cyclic dependencies");
+				} else if (mark == Mark::Unvisited) {
+					mark = Mark::InProgress;
+					stack.emplace_back(dependencies.find(dep), 0);
+				}
+			} else {
+				marks[iter->first] = Mark::Done;
+				res.push_back(iter->first);
+				stack.pop_back();
 			}
 		}
-		if (res.size() - before == 0) {
-			throw Error("Cyclic dependencies");
-		}
-		// 2, Delete types with no dependencies from the map
-		for (auto i = before; i < res.size(); ++i) {
-			dependencies.erase(res[i]);
-		}
 	}
 	return res;
 }
@@ -125,6 +140,882 @@ std::string headerGuard(std::string const& stem) {
 	return res;
 }
 
+enum class FieldKind { Scalar, String, Struct, Table, Union };
+
+// everything generated serialization and verification code needs to know about a field
+struct FieldLayout {
+	expression::Field const* field = nullptr;
+	FieldKind kind = FieldKind::Scalar;
+	// fully qualified C++ type of the field (for vectors: of an element)
+	std::string nativeType;
+	// size and alignment of the inline representation (for vectors: of an element)
+	unsigned size = 0;
+	unsigned alignment = 1;
+	// structs: the offset of the field within the struct. Tables: the offset of the field in the static vtable
+	unsigned offset = 0;
+	bool isEnum = false;
+	// strings and vectors of scalars use non-owning native types (std::string_view and flowflat::Span)
+	bool borrowed = false;
+	// strings and vectors are std::pmr containers
+	bool pmr = false;
+	// tables only
+	flowflat::voffset_t slot = 0;
+	// unions: fully qualified C++ types of the members
+	std::vector<std::string> members;
+	// nested flatbuffers: fully qualified C++ type of the root table. The alignment of the bytes is the largest
+	// alignment of a type in the nested buffer.
+	std::string nested;
+};
+
+std::string qualifiedName(TypeName const& name) {
+	if (name.path.empty()) {
+		return fmt::format("::{}", name.name);
+	}
+	return fmt::format("::{}::{}", fmt::join(name.path, "::"), name.name);
+}
+
+// my_schema-v2 -> MySchemaV2
+std::string camelCase(std::string const& stem) {
+	std::string res;
+	bool upper = true;
+	for (auto c : stem) {
+		if (!std::isalnum(static_cast<unsigned char>(c))) {
+			upper = true;
+			continue;
+		}
+		res.push_back(upper ? char(std::toupper(static_cast<unsigned char>(c))) : c);
+		upper = false;
+	}
+	if (res.empty() || std::isdigit(static_cast<unsigned char>(res.front()))) {
+		res.insert(res.begin(), '_');
+	}
+	return res;
+}
+
+// One case per root type. check is the condition under which a buffer gets dispatched (may be empty), view is the
+// expression of the view which is passed to the visitor. {0} is replaced by the type.
+void emitDispatchCases(std::ostream& out,
+                       std::vector<std::string> const& types,
+                       std::string const& check,
+                       std::string const& view) {
+	for (auto const& t : types) {
+		out << fmt::format("\t\tcase {}::flowFlatIdentifier:\n", t);
+		if (!check.empty()) {
+			out << fmt::format(fmt::runtime(fmt::format("\t\t\tif (!({})) {{{{\n", check)), t);
+			out << "\t\t\t\treturn false;\n";
+			out << "\t\t\t}\n";
+		}
+		out << fmt::format(fmt::runtime(fmt::format("\t\t\tvisitor({});\n", view)), t);
+		out << "\t\t\treturn true;\n";
+	}
+	out << "\t\t}\n";
+	out << "\t\treturn false;\n";
+	out << "\t}\n";
+}
+
+// Dispatches buffers to the root types of a file and all files it includes by their file identifier. Root types which
+// share an identifier can't be told apart and are left out.
+void emitDispatcher(std::ostream& out, StaticContext const& context, std::string const& stem) {
+	auto roots = context.identifiedRootTypes();
+	std::vector<std::string> types;
+	for (auto const& [name, identifier] : roots) {
+		auto count = std::count_if(
+		    roots.begin(), roots.end(), [identifier = identifier](auto const& r) { return r.second == identifier; });
+		if (count > 1) {
+			fmt::print(stderr,
+			           "Warning: {} shares its file identifier with another root type and can't be dispatched by {}\n",
+			           qualifiedName(name),
+			           stem);
+			continue;
+		}
+		types.push_back(qualifiedName(name));
+	}
+	if (types.empty()) {
+		return;
+	}
+	out << "// dispatches buffers to the view of their root type by file identifier\n";
+	out << fmt::format("struct {}Roots {{\n", camelCase(stem));
+	out << "\t// calls visitor with the view of the root table if the identifier of buffer is known\n";
+	out << "\ttemplate <class Visitor>\n";
+	out << "\tstatic bool dispatch(char const* buffer, Visitor&& visitor) {\n";
+	out << "\t\tswitch (flowflat::bufferIdentifier(buffer)) {\n";
+	emitDispatchCases(out, types, "", "{}::view(buffer)");
+	out << "\t// same as dispatch, but buffers which fail verification are rejected\n";
+	out << "\ttemplate <class Visitor>\n";
+	out << "\tstatic bool dispatchVerified(char const* buffer, std::size_t size, Visitor&& visitor) {\n";
+	out << "\t\tif (size < 2 * sizeof(uint32_t)) {\n";
+	out << "\t\t\treturn false;\n";
+	out << "\t\t}\n";
+	out << "\t\tswitch (flowflat::bufferIdentifier(buffer)) {\n";
+	emitDispatchCases(out, types, "{}::verify(buffer, size)", "{}::view(buffer)");
+	out << "\t// dispatchVerified for size prefixed buffers\n";
+	out << "\ttemplate <class Visitor>\n";
+	out << "\tstatic bool dispatchSizePrefixed(char const* frame, std::size_t size, Visitor&& visitor) {\n";
+	out << "\t\tif (size < 3 * sizeof(uint32_t)) {\n";
+	out << "\t\t\treturn false;\n";
+	out << "\t\t}\n";
+	out << "\t\tswitch (flowflat::bufferIdentifier(flowflat::skipSizePrefix(frame))) {\n";
+	emitDispatchCases(out, types, "{}::verifySizePrefixed(frame, size)", "{}::sizePrefixedView(frame)");
+	out << "};\n\n";
+}
+
+std::vector<FieldLayout> fieldLayouts(StaticContext const& context, expression::StructOrTable const& type) {
+	auto self = assertTrue(context.resolve(type.name))->first;
+	auto serInfos = context.serializationInformation(type.name);
+	bool isTable = type.typeType() == expression::TypeType::Table;
+	std::vector<FieldLayout> res;
+	res.reserve(type.fields.size());
+	unsigned structSize = 0;
+	for (auto const& field : type.fields) {
+		auto [typeName, fieldType] = *assertTrue(context.resolveInScope(field.type, self.path));
+		auto const& info = serInfos[typeName];
+		auto& layout = res.emplace_back();
+		layout.field = &field;
+		layout.nativeType = qualifiedName(typeName);
+		layout.borrowed = context.options.borrowed || field.hasMetadata(expression::MetadataType::borrowed);
+		layout.pmr = context.options.pmr;
+		layout.size = info.staticSize;
+		layout.alignment = info.alignment;
+		switch (fieldType->typeType()) {
+		case expression::TypeType::Primitive: {
+			auto primitive = dynamic_cast<expression::PrimitiveType const*>(fieldType);
+			layout.kind = primitive->typeClass == expression::PrimitiveTypeClass::StringType ? FieldKind::String
+			                                                                                    : FieldKind::Scalar;
+			layout.nativeType = std::string(primitive->nativeName);
+			break;
+		}
+		case expression::TypeType::Enum:
+			layout.kind = FieldKind::Scalar;
+			layout.isEnum = true;
+			break;
+		case expression::TypeType::Struct:
+			layout.kind = FieldKind::Struct;
+			break;
+		case expression::TypeType::Table:
+			layout.kind = FieldKind::Table;
+			layout.size = layout.alignment = sizeof(flowflat::uoffset_t);
+			break;
+		case expression::TypeType::Union:
+			layout.kind = FieldKind::Union;
+			if (field.isArrayType) {
+				fmt::print(stderr, "Error: {}.{}: vectors of unions are not supported\n", type.name, field.name);
+				throw Error("Vector of unions");
+			}
+			for (auto member : dynamic_cast<expression::Union const*>(fieldType)->types) {
+				auto memberType = assertTrue(context.resolveInScope(member, typeName.path))->first;
+				layout.members.push_back(qualifiedName(memberType));
+			}
+			break;
+		}
+		if (auto nested = field.nestedFlatbuffer()) {
+			layout.nested = qualifiedName(assertTrue(context.resolve(*nested))->first);
+			for (auto const& [_, nestedInfo] : context.serializationInformation(*nested)) {
+				layout.alignment = std::max(layout.alignment, nestedInfo.alignment);
+			}
+		}
+		if (isTable) {
+			layout.slot = flowflat::vtableSlot(res.size() - 1);
+			layout.offset = (*serInfos[self].vtable)[res.size() + 1];
+		} else {
+			structSize += (layout.alignment - structSize % layout.alignment) % layout.alignment;
+			layout.offset = structSize;
+			structSize += layout.size;
+		}
+	}
+	return res;
+}
+
+// inline size of a vector field or element
+unsigned inlineSize(FieldLayout const& f) {
+	return f.field->isArrayType ? sizeof(flowflat::uoffset_t) : f.size;
+}
+
+unsigned inlineAlignment(FieldLayout const& f) {
+	return f.field->isArrayType ? sizeof(flowflat::uoffset_t) : f.alignment;
+}
+
+// code which appends the vector of field `f` and links it to the table at t
+void emitVectorWriter(std::ostream& out, FieldLayout const& f) {
+	auto name = f.field->name;
+	out << fmt::format("\tif (!this->{}.empty()) {{\n", name);
+	if (!f.nested.empty()) {
+		out << fmt::format("\t\ts.link(t + {0}, s.scalars(this->{1}.data(), this->{1}.size(), {2}));\n",
+		                   f.offset,
+		                   name,
+		                   f.alignment);
+		out << "\t}\n";
+		return;
+	} else if (f.kind == FieldKind::Scalar && f.nativeType != "bool") {
+		out << fmt::format("\t\ts.link(t + {0}, s.scalars(this->{1}.data(), this->{1}.size()));\n", f.offset, name);
+		out << "\t}\n";
+		return;
+	}
+	auto elementSize = f.kind == FieldKind::Scalar || f.kind == FieldKind::Struct ? f.size : 4;
+	auto alignment = f.kind == FieldKind::Struct ? f.alignment : elementSize;
+	out << fmt::format("\t\tauto v = s.vector(this->{}.size(), {}, {});\n", name, elementSize, alignment);
+	// the serializer writes the elements, so it can split large vectors (see flowflat::Serializer)
+	switch (f.kind) {
+	case FieldKind::Scalar:
+		out << fmt::format("\t\ts.bools(v, this->{});\n", name);
+		break;
+	case FieldKind::Struct:
+		out << fmt::format("\t\ts.structs(v, this->{0}.data(), this->{0}.size(), {1});\n", name, elementSize);
+		break;
+	case FieldKind::String:
+		out << fmt::format("\t\ts.strings(v, this->{0}.data(), this->{0}.size());\n", name);
+		break;
+	case FieldKind::Table:
+		out << fmt::format("\t\ts.tables(v, this->{0}.data(), this->{0}.size());\n", name);
+		break;
+	case FieldKind::Union:
+		throw Error("BUG");
+	}
+	out << fmt::format("\t\ts.link(t + {}, v);\n", f.offset);
+	out << "\t}\n";
+}
+
+void emitTableWriter(std::ostream& out, expression::Table const& table, std::vector<FieldLayout> const& fields) {
+	out << fmt::format("std::size_t {}::writeTo(flowflat::Serializer& s) const {{\n", table.name);
+	out << "\tauto t = s.table(flowFlatVTable, flowFlatAlignment);\n";
+	for (auto const& f : fields) {
+		auto name = f.field->name;
+		if (f.field->isArrayType) {
+			emitVectorWriter(out, f);
+			continue;
+		}
+		switch (f.kind) {
+		case FieldKind::Scalar:
+			out << fmt::format("\ts.store(t + {}, this->{});\n", f.offset, name);
+			break;
+		case FieldKind::Struct:
+			out << fmt::format("\tthis->{}.writeTo(s, t + {});\n", name, f.offset);
+			break;
+		case FieldKind::String:
+			if (f.field->defaultValue && !f.field->defaultValue->empty()) {
+				// an absent string reads as the default
+				out << fmt::format("\ts.link(t + {}, s.string(this->{}));\n", f.offset, name);
+				break;
+			}
+			// empty strings are written as null references
+			out << fmt::format("\tif (!this->{}.empty()) {{\n", name);
+			out << fmt::format("\t\ts.link(t + {}, s.string(this->{}));\n", f.offset, name);
+			out << "\t}\n";
+			break;
+		case FieldKind::Table:
+			out << fmt::format("\ts.link(t + {}, this->{}.writeTo(s));\n", f.offset, name);
+			break;
+		case FieldKind::Union:
+			// a valueless variant is written as an empty union
+			out << fmt::format("\ts.store(t + {}, uint32_t(this->{}.index() + 1));\n", f.offset, name);
+			out << fmt::format("\tswitch (this->{}.index()) {{\n", name);
+			for (std::size_t i = 0; i < f.members.size(); ++i) {
+				out << fmt::format("\tcase {}:\n", i);
+				out << fmt::format("\t\ts.link(t + {}, std::get<{}>(this->{}).writeTo(s));\n", f.offset + 4, i, name);
+				out << "\t\tbreak;\n";
+			}
+			out << "\t}\n";
+			break;
+		}
+	}
+	out << "\treturn t;\n";
+	out << "}\n\n";
+}
+
+void emitStructWriter(std::ostream& out,
+                      expression::Struct const& st,
+                      std::vector<FieldLayout> const& fields,
+                      unsigned staticSize) {
+	out << fmt::format("void {}::writeTo(flowflat::Serializer& s, std::size_t position) const {{\n", st.name);
+	out << "\tif (!s.sizing()) {\n";
+	out << "\t\tstoreTo(s.at(position));\n";
+	out << "\t}\n";
+	out << "}\n\n";
+	out << fmt::format("void {}::storeTo(char* p) const {{\n", st.name);
+	unsigned payload = 0;
+	for (auto const& f : fields) {
+		payload += f.size;
+	}
+	if (payload != staticSize) {
+		// the padding between fields has to be zeroed
+		out << "\tstd::memset(p, 0, flowFlatSize);\n";
+	}
+	for (auto const& f : fields) {
+		if (f.kind == FieldKind::Struct) {
+			out << fmt::format("\tthis->{}.storeTo(p + {});\n", f.field->name, f.offset);
+		} else {
+			out << fmt::format("\tflowflat::store(p + {}, this->{});\n", f.offset, f.field->name);
+		}
+	}
+	out << "}\n\n";
+}
+
+// the type returned by the view accessor of a field
+std::string viewType(FieldLayout const& f) {
+	if (f.field->isArrayType) {
+		switch (f.kind) {
+		case FieldKind::Scalar:
+			if (f.nativeType == "bool") {
+				return "flowflat::BoolVector";
+			}
+			return fmt::format("flowflat::ScalarVector<{}>", f.nativeType);
+		case FieldKind::String:
+			return "flowflat::StringVector";
+		case FieldKind::Struct:
+			return fmt::format("flowflat::StructVector<{}>", f.nativeType);
+		case FieldKind::Table:
+			return fmt::format("flowflat::TableVector<{}>", f.nativeType);
+		case FieldKind::Union:
+			break;
+		}
+		throw Error("BUG");
+	}
+	switch (f.kind) {
+	case FieldKind::Scalar:
+	case FieldKind::Struct:
+		return f.nativeType;
+	case FieldKind::String:
+		return "std::string_view";
+	case FieldKind::Table:
+		return f.nativeType + "::View";
+	case FieldKind::Union:
+		break;
+	}
+	throw Error("BUG");
+}
+
+// borrowed vectors of scalars are spans of the elements, all other vectors own their elements
+bool isSpan(FieldLayout const& f) {
+	return f.borrowed && f.field->isArrayType && f.kind == FieldKind::Scalar && f.nativeType != "bool";
+}
+
+// the native type of a vector element or of a field which isn't a vector
+std::string nativeType(FieldLayout const& f) {
+	if (f.kind == FieldKind::String) {
+		if (f.borrowed) {
+			return std::string(config::stringViewType);
+		}
+		return std::string(f.pmr ? config::pmrStringType : config::stringType);
+	}
+	return f.nativeType;
+}
+
+// the type of an owning vector of element
+std::string vectorType(FieldLayout const& f, std::string const& element) {
+	return fmt::format("{}<{}>", f.pmr ? config::pmrVectorType : config::vectorType, element);
+}
+
+// the type of the member which holds field f
+std::string memberType(FieldLayout const& f) {
+	auto element = f.kind == FieldKind::String ? nativeType(f) : convertType(f.field->type);
+	if (!f.field->isArrayType) {
+		return element;
+	}
+	return isSpan(f) ? fmt::format("flowflat::Span<{} const>", element) : vectorType(f, element);
+}
+
+// the unqualified name of a union member
+std::string_view memberName(std::string_view qualified) {
+	auto pos = qualified.rfind(':');
+	return pos == std::string_view::npos ? qualified : qualified.substr(pos + 1);
+}
+
+// profile: accessors count the accesses of their field (see flowflat/profile.h)
+void emitView(std::ostream& out,
+              expression::Table const& table,
+              std::vector<FieldLayout> const& fields,
+              bool profile) {
+	out << fmt::format("\t// zero-copy access to a {} in a buffer\n", table.name);
+	out << "\tclass View {\n";
+	out << "\t\tchar const* flowFlatTable = nullptr;\n\n";
+	// the statement counting an access of the current field
+	std::string count;
+	// accessors which fit on one line
+	auto accessor = [&out, &count](auto const& type, auto const& name, std::string const& body) {
+		out << fmt::format("\t\t[[nodiscard]] {} {}() const {{ {}return {}; }}\n", type, name, count, body);
+	};
+	// the first line of the body of accessors which don't fit on one line
+	auto counter = [&out, &count]() {
+		if (!count.empty()) {
+			out << fmt::format("\t\t\t{}\n", count.substr(0, count.size() - 1));
+		}
+	};
+	out << "\tpublic:\n";
+	out << "\t\tView() = default;\n";
+	out << "\t\texplicit View(char const* table) : flowFlatTable(table) {}\n";
+	out << "\t\t// p points to a reference to the table\n";
+	out << "\t\t[[nodiscard]] static View follow(char const* p) { return View(flowflat::followOrNull(p)); }\n\n";
+	out << "\t\t// false for absent tables\n";
+	out << "\t\t[[nodiscard]] explicit operator bool() const { return flowFlatTable != nullptr; }\n";
+	out << "\t\t[[nodiscard]] char const* data() const { return flowFlatTable; }\n\n";
+	for (std::size_t index = 0; index < fields.size(); ++index) {
+		auto const& f = fields[index];
+		auto name = f.field->name;
+		auto const& defaultValue = f.field->defaultValue;
+		if (profile) {
+			count = fmt::format("flowflat::profile::access<{}>({}); ", table.name, index);
+		}
+		if (f.field->isArrayType) {
+			accessor(viewType(f), name, fmt::format("{}(flowflat::reference(flowFlatTable, {}))", viewType(f), f.slot));
+			if (!f.nested.empty()) {
+				out << "\t\t// the root of the nested buffer, a null view if the field is absent\n";
+				out << fmt::format("\t\t[[nodiscard]] {}::View {}_nested_root() const {{\n", f.nested, name);
+				out << fmt::format("\t\t\tauto bytes = {}();\n", name);
+				out << fmt::format("\t\t\treturn bytes.empty() ? {0}::View() : {0}::view(bytes.data());\n", f.nested);
+				out << "\t\t}\n";
+			}
+			continue;
+		}
+		switch (f.kind) {
+		case FieldKind::Scalar: {
+			std::string value;
+			if (!defaultValue) {
+				value = "{}";
+			} else if (f.isEnum) {
+				value = fmt::format("{}::{}", f.nativeType, *defaultValue);
+			} else {
+				value = fmt::format("static_cast<{}>({})", f.nativeType, *defaultValue);
+			}
+			if (f.nativeType == "bool") {
+				out << fmt::format("\t\t[[nodiscard]] bool {}() const {{\n", name);
+				counter();
+				out << fmt::format("\t\t\tauto at = flowflat::field(flowFlatTable, {});\n", f.slot);
+				out << fmt::format("\t\t\treturn at ? flowflat::loadBool(at) : {};\n", defaultValue ? value : "false");
+				out << "\t\t}\n";
+			} else {
+				accessor(f.nativeType,
+				         name,
+				         fmt::format("flowflat::scalar<{}>(flowFlatTable, {}, {})", f.nativeType, f.slot, value));
+			}
+			break;
+		}
+		case FieldKind::Struct:
+			out << fmt::format("\t\t[[nodiscard]] {} {}() const {{\n", f.nativeType, name);
+			counter();
+			out << fmt::format("\t\t\tauto at = flowflat::field(flowFlatTable, {});\n", f.slot);
+			out << fmt::format("\t\t\treturn at ? {0}::readFrom(at) : {0}();\n", f.nativeType);
+			out << "\t\t}\n";
+			break;
+		case FieldKind::String:
+			if (defaultValue) {
+				out << fmt::format("\t\t[[nodiscard]] std::string_view {}() const {{\n", name);
+				counter();
+				out << fmt::format("\t\t\treturn flowflat::string(flowFlatTable, {}, std::string_view(\"{}\"));\n",
+				                   f.slot,
+				                   *defaultValue);
+				out << "\t\t}\n";
+			} else {
+				accessor("std::string_view", name, fmt::format("flowflat::string(flowFlatTable, {})", f.slot));
+			}
+			break;
+		case FieldKind::Table:
+			accessor(viewType(f), name, fmt::format("{}(flowflat::reference(flowFlatTable, {}))", viewType(f), f.slot));
+			break;
+		case FieldKind::Union:
+			out << "\t\t// 0 if the union is empty, otherwise the index of the member type + 1\n";
+			accessor("uint32_t",
+			         fmt::format("{}_type", name),
+			         fmt::format("flowflat::scalar<uint32_t>(flowFlatTable, {}, 0)", f.slot));
+			for (std::size_t i = 0; i < f.members.size(); ++i) {
+				auto const& member = f.members[i];
+				out << fmt::format(
+				    "\t\t[[nodiscard]] {}::View {}_as_{}() const {{\n", member, name, memberName(member));
+				counter();
+				out << fmt::format(
+				    "\t\t\treturn {}::View(flowflat::unionTable(flowFlatTable, {}, {}));\n", member, f.slot, i + 1);
+				out << "\t\t}\n";
+			}
+			break;
+		}
+	}
+	out << "\t};\n\n";
+}
+
+void emitMutableView(std::ostream& out, expression::Table const& table, std::vector<FieldLayout> const& fields) {
+	out << fmt::format("\t// in-place modification of the fixed-size fields of a {} in a buffer\n", table.name);
+	out << "\tclass MutableView : public View {\n";
+	out << "\tpublic:\n";
+	out << "\t\tMutableView() = default;\n";
+	out << "\t\texplicit MutableView(char* table) : View(table) {}\n\n";
+	out << "\t\t[[nodiscard]] char* data() const { return const_cast<char*>(View::data()); }\n\n";
+	out << "\t\t// setters return false if the field is absent in the buffer\n";
+	for (auto const& f : fields) {
+		if (f.field->isArrayType) {
+			continue;
+		}
+		auto name = f.field->name;
+		switch (f.kind) {
+		case FieldKind::Scalar:
+			out << fmt::format("\t\tbool mutate_{}({} value) const {{ return flowflat::mutate(data(), {}, value); }}\n",
+			                   name,
+			                   f.nativeType,
+			                   f.slot);
+			break;
+		case FieldKind::Struct:
+			out << fmt::format("\t\tbool mutate_{}({} const& value) const {{\n", name, f.nativeType);
+			out << fmt::format("\t\t\tauto at = const_cast<char*>(flowflat::field(data(), {}));\n", f.slot);
+			out << "\t\t\tif (at) {\n";
+			out << "\t\t\t\tvalue.storeTo(at);\n";
+			out << "\t\t\t}\n";
+			out << "\t\t\treturn at != nullptr;\n";
+			out << "\t\t}\n";
+			break;
+		case FieldKind::Table:
+			out << fmt::format("\t\t[[nodiscard]] {}::MutableView mutable_{}() const {{\n", f.nativeType, name);
+			out << fmt::format("\t\t\treturn {}::MutableView(const_cast<char*>(flowflat::reference(data(), {})));\n",
+			                   f.nativeType,
+			                   f.slot);
+			out << "\t\t}\n";
+			break;
+		case FieldKind::String:
+		case FieldKind::Union:
+			break;
+		}
+	}
+	out << "\t};\n\n";
+}
+
+// code which decodes the union field f of `view` into `target`. allocator is empty or ", <allocator>".
+void emitUnionReader(std::ostream& out,
+                     std::string_view indent,
+                     FieldLayout const& f,
+                     std::string_view target,
+                     std::string_view allocator) {
+	auto name = f.field->name;
+	out << fmt::format("{}switch (view.{}_type()) {{\n", indent, name);
+	for (std::size_t i = 0; i < f.members.size(); ++i) {
+		out << fmt::format("{}case {}:\n", indent, i + 1);
+		auto const& member = f.members[i];
+		out << fmt::format("{}\t{}.emplace<{}>({}::read(view.{}_as_{}(){}));\n",
+		                   indent,
+		                   target,
+		                   i,
+		                   member,
+		                   name,
+		                   memberName(member),
+		                   allocator);
+		out << fmt::format("{}\tbreak;\n", indent);
+	}
+	out << fmt::format("{}}}\n", indent);
+}
+
+void emitReader(std::ostream& out,
+                expression::Table const& table,
+                std::vector<FieldLayout> const& fields,
+                GeneratorOptions const& options) {
+	std::string allocator;
+	if (options.pmr) {
+		// the allocator is passed down to all nested tables
+		allocator = ", alloc";
+		out << fmt::format("{0} {0}::read(View view, allocator_type alloc) {{\n", table.name);
+		out << fmt::format("\t{} res(alloc);\n", table.name);
+	} else {
+		out << fmt::format("{0} {0}::read(View view) {{\n", table.name);
+		out << fmt::format("\t{} res;\n", table.name);
+	}
+	if (options.profileAccess && !fields.empty()) {
+		out << fmt::format("\tflowflat::profile::DecodeScope<{}> decode;\n", table.name);
+	}
+	for (auto const& f : fields) {
+		auto name = f.field->name;
+		if (isSpan(f)) {
+			out << fmt::format("\tres.{0} = flowflat::borrow(view.{0}());\n", name);
+			continue;
+		}
+		if (f.field->isArrayType) {
+			out << "\t{\n";
+			out << fmt::format("\t\tauto v = view.{}();\n", name);
+			out << fmt::format("\t\tres.{}.reserve(v.size());\n", name);
+			out << "\t\tfor (auto e : v) {\n";
+			if (f.kind == FieldKind::Table) {
+				out << fmt::format("\t\t\tres.{}.push_back({}::read(e{}));\n", name, f.nativeType, allocator);
+			} else {
+				out << fmt::format("\t\t\tres.{}.emplace_back(e);\n", name);
+			}
+			out << "\t\t}\n";
+			out << "\t}\n";
+			continue;
+		}
+		switch (f.kind) {
+		case FieldKind::Scalar:
+		case FieldKind::Struct:
+		case FieldKind::String:
+			out << fmt::format("\tres.{0} = view.{0}();\n", name);
+			break;
+		case FieldKind::Table:
+			out << fmt::format("\tres.{0} = {1}::read(view.{0}(){2});\n", name, f.nativeType, allocator);
+			break;
+		case FieldKind::Union:
+			emitUnionReader(out, "\t", f, fmt::format("res.{}", name), allocator);
+			break;
+		}
+	}
+	out << "\treturn res;\n";
+	out << "}\n\n";
+}
+
+void emitStructReader(std::ostream& out, expression::Struct const& st, std::vector<FieldLayout> const& fields) {
+	out << fmt::format("{0} {0}::readFrom(char const* p) {{\n", st.name);
+	out << fmt::format("\t{} res;\n", st.name);
+	for (auto const& f : fields) {
+		if (f.kind == FieldKind::Struct) {
+			out << fmt::format("\tres.{} = {}::readFrom(p + {});\n", f.field->name, f.nativeType, f.offset);
+		} else if (f.nativeType == "bool") {
+			out << fmt::format("\tres.{} = flowflat::loadBool(p + {});\n", f.field->name, f.offset);
+		} else {
+			out << fmt::format("\tres.{} = flowflat::load<{}>(p + {});\n", f.field->name, f.nativeType, f.offset);
+		}
+	}
+	out << "\treturn res;\n";
+	out << "}\n\n";
+}
+
+// fields which are decoded on first access by the lazy object. Scalars, structs, borrowed strings and spans are read
+// from the buffer every time.
+bool isCached(FieldLayout const& f) {
+	if (isSpan(f) || (f.borrowed && f.kind == FieldKind::String && !f.field->isArrayType)) {
+		return false;
+	}
+	return f.field->isArrayType || (f.kind != FieldKind::Scalar && f.kind != FieldKind::Struct);
+}
+
+// the type of the value a lazy object keeps for a cached field
+std::string cachedType(FieldLayout const& f) {
+	auto element = f.kind == FieldKind::Table ? f.nativeType + "::Lazy" : nativeType(f);
+	return f.field->isArrayType ? vectorType(f, element) : element;
+}
+
+void emitLazy(Streams& out,
+              expression::Table const& table,
+              std::vector<FieldLayout> const& fields,
+              GeneratorOptions const& options) {
+	// decoded values are allocated with the allocator of the lazy object
+	std::string allocator = options.pmr ? ", flowFlatAllocator" : "";
+	out.header << "\t// decodes strings, vectors, tables and unions on first access and keeps the decoded values\n";
+	out.header << "\t// (not thread safe)\n";
+	out.header << "\tclass Lazy {\n";
+	out.header << "\t\tView flowFlatView;\n";
+	if (options.pmr) {
+		out.header << "\t\tallocator_type flowFlatAllocator;\n";
+	}
+	out.header << "\t\tmutable struct {\n";
+	for (auto const& f : fields) {
+		if (isCached(f)) {
+			out.header << fmt::format("\t\t\tstd::optional<{}> {};\n", cachedType(f), f.field->name);
+		}
+	}
+	out.header << "\t\t} flowFlatCache;\n\n";
+	out.header << "\tpublic:\n";
+	out.header << "\t\tLazy() = default;\n";
+	if (options.pmr) {
+		out.header << "\t\texplicit Lazy(View view, allocator_type alloc = {})\n";
+		out.header << "\t\t  : flowFlatView(view), flowFlatAllocator(alloc) {}\n\n";
+	} else {
+		out.header << "\t\texplicit Lazy(View view) : flowFlatView(view) {}\n\n";
+	}
+	out.header << "\t\t// decodes the whole table\n";
+	out.header << fmt::format("\t\t[[nodiscard]] {} materialize() const;\n\n", table.name);
+	for (auto const& f : fields) {
+		auto name = f.field->name;
+		if (!f.nested.empty()) {
+			out.header << fmt::format("\t\t[[nodiscard]] {0}::View {1}_nested_root() const {{\n", f.nested, name);
+			out.header << fmt::format("\t\t\treturn flowFlatView.{}_nested_root();\n", name);
+			out.header << "\t\t}\n";
+		}
+		if (!isCached(f)) {
+			auto type = f.kind == FieldKind::String || isSpan(f) ? memberType(f) : f.nativeType;
+			auto value = fmt::format("flowFlatView.{}()", name);
+			if (isSpan(f)) {
+				value = fmt::format("flowflat::borrow({})", value);
+			}
+			out.header << fmt::format("\t\t[[nodiscard]] {} {}() const {{ return {}; }}\n", type, name, value);
+			continue;
+		}
+		auto type = cachedType(f);
+		out.header << fmt::format("\t\t[[nodiscard]] {} const& {}() const;\n", type, name);
+		out.source << fmt::format("{} const& {}::Lazy::{}() const {{\n", type, table.name, name);
+		out.source << fmt::format("\tauto& cache = flowFlatCache.{};\n", name);
+		out.source << "\tif (!cache) {\n";
+		if (f.field->isArrayType) {
+			out.source << fmt::format("\t\tauto v = flowFlatView.{}();\n", name);
+			out.source << fmt::format("\t\tcache.emplace({}).reserve(v.size());\n",
+			                          options.pmr ? "flowFlatAllocator" : "");
+			out.source << "\t\tfor (auto e : v) {\n";
+			// pmr containers pass their allocator to pmr strings, lazy tables have to get it explicitly
+			auto elementAllocator = f.kind == FieldKind::Table ? allocator : "";
+			out.source << fmt::format("\t\t\tcache->emplace_back(e{});\n", elementAllocator);
+			out.source << "\t\t}\n";
+		} else if (f.kind == FieldKind::Union) {
+			out.source << "\t\tauto const& view = flowFlatView;\n";
+			out.source << "\t\tauto& value = cache.emplace();\n";
+			emitUnionReader(out.source, "\t\t", f, "value", allocator);
+		} else {
+			out.source << fmt::format("\t\tcache.emplace(flowFlatView.{}(){});\n", name, allocator);
+		}
+		out.source << "\t}\n";
+		out.source << "\treturn *cache;\n";
+		out.source << "}\n\n";
+	}
+	out.header << "\t};\n\n";
+	out.source << fmt::format("{0} {0}::Lazy::materialize() const {{\n", table.name);
+	out.source << fmt::format("\treturn read(flowFlatView{});\n", allocator);
+	out.source << "}\n\n";
+}
+
+// strings, vectors and tables which are constructed with the allocator of their table
+bool usesAllocator(FieldLayout const& f) {
+	if (!f.pmr) {
+		return false;
+	}
+	if (f.field->isArrayType) {
+		return !isSpan(f);
+	}
+	return (f.kind == FieldKind::String && !f.borrowed) || f.kind == FieldKind::Table;
+}
+
+// the constructors which make a table allocator aware (std::uses_allocator): pmr containers of tables and tables
+// which contain other tables pass their allocator down
+void emitAllocatorConstructors(Streams& out, expression::Table const& table, std::vector<FieldLayout> const& fields) {
+	auto const& name = table.name;
+	out.header << "\t// allocator aware construction, the allocator is passed to all strings, vectors and tables\n";
+	out.header << fmt::format("\tusing allocator_type = {};\n", config::allocatorType);
+	out.header << fmt::format("\t{}() = default;\n", name);
+	out.header << fmt::format("\texplicit {}(allocator_type alloc);\n", name);
+	out.header << fmt::format("\t{0}({0} const& other, allocator_type alloc);\n", name);
+	out.header << fmt::format("\t{0}({0}&& other, allocator_type alloc);\n", name);
+	out.header << fmt::format("\t{0}({0} const&) = default;\n", name);
+	out.header << fmt::format("\t{0}({0}&&) = default;\n", name);
+	out.header << fmt::format("\t{0}& operator=({0} const&) = default;\n", name);
+	out.header << fmt::format("\t{0}& operator=({0}&&) = default;\n\n", name);
+
+	std::vector<std::string> initializers;
+	for (auto const& f : fields) {
+		if (f.kind == FieldKind::Union) {
+			// the empty member of a native union is its first type
+			initializers.push_back(fmt::format("{}(std::in_place_index<0>, alloc)", f.field->name));
+			continue;
+		} else if (!usesAllocator(f)) {
+			continue;
+		}
+		if (f.kind == FieldKind::String && f.field->defaultValue && !f.field->isArrayType) {
+			initializers.push_back(fmt::format("{}(\"{}\", alloc)", f.field->name, *f.field->defaultValue));
+		} else {
+			initializers.push_back(fmt::format("{}(alloc)", f.field->name));
+		}
+	}
+	if (initializers.empty()) {
+		out.source << fmt::format("{0}::{0}(allocator_type) {{}}\n\n", name);
+	} else {
+		out.source << fmt::format(
+		    "{0}::{0}(allocator_type alloc)\n  : {1} {{}}\n\n", name, fmt::join(initializers, ",\n    "));
+	}
+	// copies (move = false) or moves all members of other
+	auto copy = [&](bool move) {
+		std::vector<std::string> initializers;
+		bool allocator = false;
+		for (auto const& f : fields) {
+			auto member = fmt::format("other.{}", f.field->name);
+			if (move) {
+				member = fmt::format("std::move({})", member);
+			}
+			if (usesAllocator(f)) {
+				initializers.push_back(fmt::format("{}({}, alloc)", f.field->name, member));
+				allocator = true;
+			} else if (f.kind == FieldKind::Union) {
+				initializers.push_back(fmt::format("{}(flowflat::withAllocator({}, alloc))", f.field->name, member));
+				allocator = true;
+			} else {
+				initializers.push_back(fmt::format("{}({})", f.field->name, member));
+			}
+		}
+		out.source << fmt::format("{0}::{0}({0}{1}{2}, allocator_type{3})",
+		                          name,
+		                          move ? "&&" : " const&",
+		                          fields.empty() ? "" : " other",
+		                          allocator ? " alloc" : "");
+		if (initializers.empty()) {
+			out.source << " {}\n\n";
+		} else {
+			out.source << fmt::format("\n  : {} {{}}\n\n", fmt::join(initializers, ",\n    "));
+		}
+	};
+	copy(false);
+	copy(true);
+}
+
+void emitVerifier(std::ostream& out, expression::Table const& table, std::vector<FieldLayout> const& fields) {
+	out << fmt::format("bool {}::verify(char const* buffer, std::size_t size) {{\n", table.name);
+	out << "\tflowflat::Verifier v(buffer, size);\n";
+	out << fmt::format("\treturn flowflat::stats::verified<{}>(verify(v, v.root()));\n", table.name);
+	out << "}\n\n";
+	out << fmt::format("bool {}::verifySizePrefixed(char const* frame, std::size_t size) {{\n", table.name);
+	out << "\tflowflat::Verifier v(frame, size);\n";
+	out << fmt::format("\treturn flowflat::stats::verified<{}>(verify(v, v.sizePrefixedRoot()));\n", table.name);
+	out << "}\n\n";
+	out << fmt::format("bool {}::verify(flowflat::Verifier& v, std::size_t position) {{\n", table.name);
+	out << "\tflowflat::Verifier::Table t;\n";
+	out << "\tif (!v.enterTable(position, flowFlatAlignment, flowFlatVTable, t)) {\n";
+	out << "\t\treturn false;\n";
+	out << "\t}\n";
+	for (auto const& f : fields) {
+		auto field = fmt::format("v.field(t, {}, {}, {}, {})", f.slot, f.offset, inlineSize(f), inlineAlignment(f));
+		out << fmt::format("\t// {}\n", f.field->name);
+		if (f.field->isArrayType) {
+			switch (f.kind) {
+			case FieldKind::Scalar:
+				if (!f.nested.empty()) {
+					out << fmt::format(
+					    "\tv.nested<{}>(v.vector(v.reference({}), 1, {}));\n", f.nested, field, f.alignment);
+					break;
+				}
+				[[fallthrough]];
+			case FieldKind::Struct:
+				out << fmt::format("\tv.vector(v.reference({}), {}, {});\n", field, f.size, f.alignment);
+				break;
+			case FieldKind::String:
+				out << fmt::format("\tv.strings(v.references(v.reference({})));\n", field);
+				break;
+			case FieldKind::Table:
+				out << fmt::format("\tif (auto vec = v.references(v.reference({}))) {{\n", field);
+				out << "\t\tfor (uint32_t i = 0, n = v.count(vec); i < n && v.ok(); ++i) {\n";
+				out << fmt::format("\t\t\t{}::verify(v, v.element(vec, i));\n", f.nativeType);
+				out << "\t\t}\n";
+				out << "\t}\n";
+				break;
+			case FieldKind::Union:
+				throw Error("BUG");
+			}
+			continue;
+		}
+		switch (f.kind) {
+		case FieldKind::Scalar:
+		case FieldKind::Struct:
+			out << fmt::format("\t{};\n", field);
+			break;
+		case FieldKind::String:
+			out << fmt::format("\tv.string(v.reference({}));\n", field);
+			break;
+		case FieldKind::Table:
+			out << fmt::format("\tif (auto p = v.reference({})) {{\n", field);
+			out << fmt::format("\t\t{}::verify(v, p);\n", f.nativeType);
+			out << "\t}\n";
+			break;
+		case FieldKind::Union:
+			out << fmt::format("\tif (auto p = {}) {{\n", field);
+			out << fmt::format("\t\tswitch (v.unionTag(p, {})) {{\n", f.members.size());
+			for (std::size_t i = 0; i < f.members.size(); ++i) {
+				out << fmt::format("\t\tcase {}:\n", i + 1);
+				out << fmt::format("\t\t\t{}::verify(v, v.reference(p + 4));\n", f.members[i]);
+				out << "\t\t\tbreak;\n";
+			}
+			out << "\t\t}\n";
+			out << "\t}\n";
+			break;
+		}
+	}
+	out << "\treturn v.leaveTable();\n";
+	out << "}\n\n";
+}
+
 } // namespace
 
 CodeGenerator::CodeGenerator(StaticContext* context) : context(context) {}
@@ -154,6 +1045,7 @@ void CodeGenerator::emit(Streams& out, expression::Enum const& f) const {
 			out.source << fmt::format("\t\treturn \"{0}\"{1};\n", k, config::stringLiteral);
 		}
 		out.source << "\t}\n";
+		out.source << "\treturn std::to_string(static_cast<long long>(e));\n";
 		out.source << "}\n\n";
 		// fromString and fromStringView
 
@@ -164,7 +1056,7 @@ void CodeGenerator::emit(Streams& out, expression::Enum const& f) const {
 			for (auto const& [k, _] : f.values) {
 				out.source << fmt::format(
 				    "\t{0} (str == \"{1}\"{2}) {{\n", first ? "if" : "} else if", k, stringLiteral);
-				out.source << fmt::format("\t\treturn {}::{};\n", f.name, k);
+				out.source << fmt::format("\t\tout = {}::{};\n", f.name, k);
 				first = false;
 			}
 			out.source << "\t} else {\n";
@@ -180,100 +1072,214 @@ void CodeGenerator::emit(Streams& out, expression::Enum const& f) const {
 }
 
 void CodeGenerator::emit(Streams& out, expression::Union const& u) const {
-	std::vector<std::string_view> types;
+	std::vector<std::string> types;
 	types.reserve(u.types.size());
 	std::transform(
 	    u.types.begin(), u.types.end(), std::back_inserter(types), [](auto const& t) { return convertType(t); });
 	out.header << fmt::format("using {} = std::variant<{}>;\n", u.name, fmt::join(types, ", "));
 }
 
-void CodeGenerator::emit(Streams& out, expression::Field const& f) const {
+void CodeGenerator::emit(Streams& out, expression::Field const& f, std::string const& type) const {
 	std::string assignment;
-	auto type = std::string(convertType(f.type));
-	if (f.isArrayType) {
-		type = fmt::format("std::vector<{}>", type);
-	}
 	if (f.defaultValue) {
-		if (expression::primitiveTypes.contains(type)) {
-			if (expression::primitiveTypes[type].typeClass == expression::PrimitiveTypeClass::StringType) {
+		if (auto primitive = expression::primitiveTypes.find(f.type); primitive != expression::primitiveTypes.end()) {
+			if (primitive->second.typeClass == expression::PrimitiveTypeClass::StringType) {
 				assignment = fmt::format(" = \"{}\"", f.defaultValue.value());
 			} else {
 				assignment = fmt::format(" = {}", f.defaultValue.value());
 			}
 		} else {
 			// at this point we know this is an enum type
-			assignment = fmt::format(" = {}::{}", type, f.defaultValue.value());
+			assignment = fmt::format(" = {}::{}", convertType(f.type), f.defaultValue.value());
 		}
+	} else if (!f.isArrayType) {
+		// scalars would be left uninitialized otherwise
+		assignment = " = {}";
 	}
 	out.header << fmt::format("\t{} {}{};\n", type, f.name, assignment);
 }
 
 void CodeGenerator::emit(Streams& out, expression::Struct const& st) const {
 	Defer defer;
+	auto fields = fieldLayouts(*context, st);
+	auto serInfos = context->serializationInformation(st.name);
+	auto const& info = serInfos[assertTrue(context->resolve(st.name))->first];
 	out.header << fmt::format("struct {} {{\n", st.name);
 	out.header << fmt::format(
 	    "\t[[nodiscard]] flowflat::Type flowFlatType() const {{ return flowflat::Type::Struct; }};\n\n");
+	out.header << "\t// layout of the serialized struct\n";
+	out.header << fmt::format("\tstatic constexpr std::size_t flowFlatSize = {};\n", info.staticSize);
+	out.header << fmt::format("\tstatic constexpr std::size_t flowFlatAlignment = {};\n\n", info.alignment);
+	out.header << "\t// writes the struct at position\n";
+	out.header << "\tvoid writeTo(flowflat::Serializer& s, std::size_t position) const;\n";
+	out.header << "\t// writes the struct to p, which has to point to flowFlatSize bytes\n";
+	out.header << "\tvoid storeTo(char* p) const;\n";
+	out.header << "\t// decodes the struct at p\n";
+	out.header << fmt::format("\t[[nodiscard]] static {} readFrom(char const* p);\n\n", st.name);
 	defer([&out]() { out.header << "};\n"; });
-	for (auto const& f : st.fields) {
-		emit(out, f);
+	for (auto const& f : fields) {
+		emit(out, *f.field, memberType(f));
 	}
+	emitStructWriter(out.source, st, fields, info.staticSize);
+	emitStructReader(out.source, st, fields);
 }
 
 void CodeGenerator::emit(Streams& out, expression::Table const& table) const {
 	Defer defer;
+	auto fields = fieldLayouts(*context, table);
+	auto serInfos = context->sortedSerializationInformation(table.name);
+	auto self = assertTrue(context->resolve(table.name))->first;
+	auto const& info =
+	    std::find_if(serInfos.begin(), serInfos.end(), [&self](auto const& p) { return p.first == self; })->second;
 	out.header << fmt::format("struct {} {{\n", table.name);
 	out.header << fmt::format(
 	    "\t[[nodiscard]] flowflat::Type flowFlatType() const {{ return flowflat::Type::Table; }};\n\n");
-	out.header << fmt::format("\tvoid write(flowflat::Writer& w) const;");
-
-	defer([&out]() { out.header << "};\n"; });
-	for (auto const& f : table.fields) {
-		emit(out, f);
-	}
-	// write serialization code
-	out.source << fmt::format("void {}::write(flowflat::Writer& w) {{", table.name);
-	// the code to allocate the memory has to be called first, but we can already generate code to write the statically
-	// known data
-	std::stringstream writer;
-	auto serMap = context->serializationInformation(table.name);
-	boost::unordered_map<TypeName, int> vtableOffsets;
-	int curr = 8;
-	// 0. write all vtables
-	for (auto const& [typeName, serInfo] : serMap) {
-		if (serInfo.vtable->empty()) {
-			continue;
+	out.header << "\t// layout of the serialized table\n";
+	out.header << fmt::format("\tstatic constexpr flowflat::voffset_t flowFlatVTable[] = {{ {} }};\n",
+	                          fmt::join(*info.vtable, ", "));
+	out.header << fmt::format("\tstatic constexpr std::size_t flowFlatAlignment = {};\n", info.alignment);
+	auto schemaName = self.path;
+	schemaName.push_back(self.name);
+	out.header << "\t// the name of the table in the schema\n";
+	out.header << fmt::format("\tstatic constexpr std::string_view flowFlatName = \"{}\";\n\n",
+	                          fmt::join(schemaName, "."));
+	auto const& options = context->options;
+	if (options.profileAccess && !fields.empty()) {
+		std::vector<std::string> names;
+		for (auto const& f : fields) {
+			names.push_back(fmt::format("\"{}\"", f.field->name));
 		}
-		writer << fmt::format("\t// vtable for {}{}{}\n",
-		                      fmt::join(typeName.path, "::"),
-		                      typeName.path.empty() ? "" : "::",
-		                      typeName.name);
-		for (auto o : *serInfo.vtable) {
-			writer << fmt::format("\t*reinterpret_cast<voffset_t*>(buffer + {}}) = {};", curr, o);
+		out.header << "\t// the fields of the table as they are counted by flowflat::profile\n";
+		out.header << fmt::format("\tstatic constexpr std::string_view flowFlatFieldNames[] = {{ {} }};\n\n",
+		                          fmt::join(names, ", "));
+	}
+	if (options.pmr) {
+		emitAllocatorConstructors(out, table, fields);
+	}
+	auto identifier = context->currentFile->rootTypes.contains(table.name)
+	                      ? context->currentFile->fileIdentifier
+	                      : std::optional<std::string>();
+	if (identifier) {
+		uint32_t value = 0;
+		for (int i = 3; i >= 0; --i) {
+			value = value << 8 | uint8_t((*identifier)[i]);
 		}
-		vtableOffsets[typeName] = curr;
-		curr += serInfo.vtable->size() * 2;
+		out.header << "\t// the file identifier of buffers with this root type\n";
+		out.header << fmt::format("\tstatic constexpr uint32_t flowFlatIdentifier = {:#010x};\n", value);
+		out.header << "\t// buffer has to hold at least 8 bytes\n";
+		out.header << "\t[[nodiscard]] static bool hasIdentifier(char const* buffer) {\n";
+		out.header << "\t\treturn flowflat::bufferIdentifier(buffer) == flowFlatIdentifier;\n";
+		out.header << "\t}\n\n";
+	}
+	out.header << "\t// writes the table as the root of a buffer (with the file identifier for root types)\n";
+	out.header << "\tvoid write(flowflat::Writer& w) const;\n";
+	out.header << "\t// same as write, but the buffer starts with its size\n";
+	out.header << "\tvoid writeSizePrefixed(flowflat::Writer& w) const;\n";
+	out.header << "\tvoid write(flowflat::Writer& w, flowflat::Framing const& framing) const;\n";
+	out.header << "\t// same as write, but in bounded steps (see flowflat::Resumable)\n";
+	out.header << fmt::format("\t[[nodiscard]] flowflat::Resumable<{}> writeResumable(\n", table.name);
+	out.header << "\t    flowflat::Writer& w,\n";
+	out.header << "\t    std::size_t elementsPerStep,\n";
+	out.header << "\t    std::size_t bytesPerStep,\n";
+	auto defaultFraming = identifier ? "flowflat::Framing{ flowFlatIdentifier, false }"s : "{}"s;
+	out.header << fmt::format("\t    flowflat::Framing const& framing = {}) const;\n", defaultFraming);
+	out.header << "\t// the vtables of all tables which can be reached from this one (written first into buffers)\n";
+	out.header << "\tstatic flowflat::voffset_t const* const flowFlatVTables[];\n";
+	out.header << "\t// appends the table to a buffer, returns its position\n";
+	out.header << "\t[[nodiscard]] std::size_t writeTo(flowflat::Serializer& s) const;\n";
+	out.header << fmt::format("\t// checks whether buffer contains a valid {}\n", table.name);
+	out.header << "\t[[nodiscard]] static bool verify(char const* buffer, std::size_t size);\n";
+	out.header << "\t// checks the table at position and everything it references\n";
+	out.header << "\tstatic bool verify(flowflat::Verifier& v, std::size_t position);\n";
+	out.header << "\t// verify for size prefixed buffers\n";
+	out.header << "\t[[nodiscard]] static bool verifySizePrefixed(char const* frame, std::size_t size);\n\n";
+	emitView(out.header, table, fields, options.profileAccess && !fields.empty());
+	emitMutableView(out.header, table, fields);
+	emitLazy(out, table, fields, options);
+	out.header << "\t// access to the root table of a buffer\n";
+	out.header << "\t[[nodiscard]] static View view(char const* buffer) {\n";
+	out.header << "\t\treturn View(flowflat::rootTable(buffer));\n";
+	out.header << "\t}\n";
+	out.header << "\t[[nodiscard]] static View sizePrefixedView(char const* frame) {\n";
+	out.header << "\t\treturn view(flowflat::skipSizePrefix(frame));\n";
+	out.header << "\t}\n";
+	out.header << "\t[[nodiscard]] static MutableView mutableView(char* buffer) {\n";
+	out.header << "\t\treturn MutableView(buffer + flowflat::load<flowflat::uoffset_t>(buffer));\n";
+	out.header << "\t}\n";
+	if (options.pmr) {
+		out.header << "\t[[nodiscard]] static Lazy lazy(char const* buffer, allocator_type alloc = {}) {\n";
+		out.header << "\t\treturn Lazy(view(buffer), alloc);\n";
+		out.header << "\t}\n";
+		out.header << fmt::format(
+		    "\t[[nodiscard]] static {} read(char const* buffer, allocator_type alloc = {{}}) {{\n", table.name);
+		out.header << fmt::format("\t\tflowflat::stats::DecodeScope<{}> scope;\n", table.name);
+		out.header << "\t\treturn read(view(buffer), alloc);\n";
+		out.header << "\t}\n";
+		out.header << fmt::format("\t[[nodiscard]] static {} read(View view, allocator_type alloc = {{}});\n\n",
+		                          table.name);
+	} else {
+		out.header << "\t[[nodiscard]] static Lazy lazy(char const* buffer) { return Lazy(view(buffer)); }\n";
+		out.header << fmt::format("\t[[nodiscard]] static {} read(char const* buffer) {{\n", table.name);
+		out.header << fmt::format("\t\tflowflat::stats::DecodeScope<{}> scope;\n", table.name);
+		out.header << "\t\treturn read(view(buffer));\n";
+		out.header << "\t}\n";
+		out.header << fmt::format("\t[[nodiscard]] static {} read(View view);\n\n", table.name);
 	}
-	// 1. Iterate through all fields and generate all types simultaneously
 
-	for (auto const& field : table.fields) {
-		auto fieldType = assertTrue(context->resolve(field.type))->second;
-		int inlineSpace = 0;
+	defer([&out]() { out.header << "};\n"; });
+	for (auto const& f : fields) {
+		emit(out, *f.field, memberType(f));
+	}
+	// the vtables of all tables which can be reached from this one are written at the start of the buffer
+	std::vector<std::string> vtables;
+	for (auto const& [typeName, serInfo] : serInfos) {
+		if (serInfo.vtable) {
+			vtables.push_back(fmt::format("{}::flowFlatVTable", qualifiedName(typeName)));
+		}
 	}
-	out.source << "}\n";
+	auto framedIdentifier = identifier ? "flowFlatIdentifier"s : "std::nullopt"s;
+	out.source << fmt::format("flowflat::voffset_t const* const {}::flowFlatVTables[] = {{ {} }};\n\n",
+	                          table.name,
+	                          fmt::join(vtables, ", "));
+	out.source << fmt::format("void {}::write(flowflat::Writer& w) const {{\n", table.name);
+	out.source << fmt::format("\twrite(w, flowflat::Framing{{ {}, false }});\n", framedIdentifier);
+	out.source << "}\n\n";
+	out.source << fmt::format("void {}::writeSizePrefixed(flowflat::Writer& w) const {{\n", table.name);
+	out.source << fmt::format("\twrite(w, flowflat::Framing{{ {}, true }});\n", framedIdentifier);
+	out.source << "}\n\n";
+	out.source << fmt::format("void {}::write(flowflat::Writer& w, flowflat::Framing const& framing) const {{\n",
+	                          table.name);
+	out.source << "\tflowflat::serialize(w, *this, flowFlatVTables, framing);\n";
+	out.source << "}\n\n";
+	out.source << fmt::format("flowflat::Resumable<{0}> {0}::writeResumable(flowflat::Writer& w,\n", table.name);
+	out.source << "                                    std::size_t elementsPerStep,\n";
+	out.source << "                                    std::size_t bytesPerStep,\n";
+	out.source << "                                    flowflat::Framing const& framing) const {\n";
+	out.source << fmt::format("\treturn flowflat::Resumable<{}>(\n", table.name);
+	out.source << "\t    w, *this, flowFlatVTables, std::size(flowFlatVTables), framing, elementsPerStep, "
+	              "bytesPerStep);\n";
+	out.source << "}\n\n";
+	emitTableWriter(out.source, table, fields);
+	emitVerifier(out.source, table, fields);
+	emitReader(out.source, table, fields, options);
 }
 
-void CodeGenerator::emit(Streams& out, expression::ExpressionTree const& tree) const {
+void CodeGenerator::emit(Streams& out, expression::ExpressionTree const& tree, std::string const& stem) const {
 	Defer defer;
 	if (tree.namespacePath) {
 		out.header << fmt::format("namespace {} {{\n", fmt::join(tree.namespacePath.value(), "::"));
+		out.source << fmt::format("namespace {} {{\n\n", fmt::join(tree.namespacePath.value(), "::"));
 		defer([&out, &tree]() {
 			out.header << fmt::format("}} // namespace {}\n", fmt::join(tree.namespacePath.value(), "::"));
+			out.source << fmt::format("}} // namespace {}\n", fmt::join(tree.namespacePath.value(), "::"));
 		});
 	}
 	// enums have no dependencies, so we will emit them first
-	for (auto const& [_, e] : tree.enums) {
-		emit(out, e);
-		out.header << "\n";
+	for (auto const& name : tree.declarationOrder) {
+		if (auto eIter = tree.enums.find(name); eIter != tree.enums.end()) {
+			emit(out, eIter->second);
+			out.header << "\n";
+		}
 	}
 	auto types = establishEmitOrder(tree);
 	for (auto const& t : types) {
@@ -288,6 +1294,7 @@ void CodeGenerator::emit(Streams& out, expression::ExpressionTree const& tree) c
 		}
 		out.header << "\n";
 	}
+	emitDispatcher(out.header, *context, stem);
 }
 
 void CodeGenerator::emit(std::string const& stem,
@@ -297,11 +1304,33 @@ void CodeGenerator::emit(std::string const& stem,
 	std::ofstream sourceStream(source.c_str(), std::ios_base::out | std::ios_base::trunc);
 	auto guard = headerGuard(stem);
 	headerStream << "// THIS FILE WAS GENERATED BY FLOWFLATC, DO NOT EDIT!\n";
-	headerStream << fmt::format("#ifndef {0}\n#define {0}\n#include <flowflat/flowflat.h>\n\n", guard);
+	headerStream << fmt::format("#ifndef {0}\n#define {0}\n", guard);
+	headerStream << "#include <string>\n#include <string_view>\n#include <vector>\n";
+	headerStream << "#include <variant>\n#include <optional>\n";
+	if (context->options.pmr) {
+		headerStream << "#include <memory_resource>\n";
+	}
+	headerStream << '\n';
+	headerStream << "#include <flowflat/flowflat.h>\n";
+	if (context->options.profileAccess) {
+		headerStream << "#include <flowflat/profile.h>\n";
+	}
+	headerStream << "#include <flowflat/serializer.h>\n";
+	headerStream << "#include <flowflat/span.h>\n";
+	headerStream << "#include <flowflat/verifier.h>\n";
+	headerStream << "#include <flowflat/view.h>\n";
+	for (auto const& incl : context->includes) {
+		headerStream << fmt::format("#include \"{}.h\"\n", incl.stem().string());
+	}
+	headerStream << '\n';
+	sourceStream << "// THIS FILE WAS GENERATED BY FLOWFLATC, DO NOT EDIT!\n";
+	sourceStream << fmt::format("#include \"{}.h\"\n\n", stem);
+	sourceStream << "#include <cstring>\n#include <iterator>\n#include <stdexcept>\n\n";
+	sourceStream << config::usingLiterals << "\n\n";
 	Defer defer;
 	defer([&headerStream, &guard]() { headerStream << fmt::format("\n#endif // #ifndef {}\n", guard); });
 	Streams streams{ headerStream, sourceStream };
-	emit(streams, *context->currentFile);
+	emit(streams, *context->currentFile, stem);
 }
 
 } // namespace flatbuffers
\ No newline at end of file
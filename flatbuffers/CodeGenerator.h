@@ -11,10 +11,12 @@ namespace flatbuffers {
 
 class CodeGenerator {
 	StaticContext* context;
-	void emit(struct Streams& out, expression::ExpressionTree const& tree) const;
+	// stem: the name of the generated files (without extension)
+	void emit(struct Streams& out, expression::ExpressionTree const& tree, std::string const& stem) const;
 	void emit(struct Streams& out, expression::Enum const& anEnum) const;
 	void emit(struct Streams& out, expression::Union const& anUnion) const;
-	void emit(struct Streams& out, expression::Field const& field) const;
+	// type: the C++ type of the member
+	void emit(struct Streams& out, expression::Field const& field, std::string const& type) const;
 	void emit(struct Streams& out, expression::Struct const& st) const;
 	void emit(struct Streams& out, expression::Table const& table) const;
 
@@ -8,9 +8,11 @@
 #include <cstdio>
 #include <cstdint>
 #include <iostream>
+#include <fstream>
+#include <sstream>
 
 #include <fmt/format.h>
-#include <fstream>
+#include <future>
 #include <boost/filesystem/operations.hpp>
 
 #include "Config.h"
@@ -18,6 +20,7 @@
 #include "StaticContext.h"
 #include "CodeGenerator.h"
 #include "Parser.h"
+#include "MappedFile.h"
 #include "Error.h"
 
 namespace flatbuffers {
@@ -31,29 +34,29 @@ namespace expression {
 #define DESC(n, t, c)  PrimitiveType(n, #t, PrimitiveTypeClass::c##Type, sizeof(t))
 // clang-format on
 
-boost::unordered_map<std::string_view, PrimitiveType> primitiveTypes{
-	{ "bool"sv, DESC("bool", bool, Bool) },
-	{ "byte"sv, DESC("byte", char, Char) },
-	{ "ubyte"sv, DESC("ubyte", unsigned char, Char) },
-	{ "short"sv, DESC("short", short, Int) },
-	{ "ushort"sv, DESC("ushort", unsigned short, Int) },
-	{ "int"sv, DESC("int", int, Int) },
-	{ "uint"sv, DESC("uint", unsigned, Int) },
-	{ "float"sv, DESC("float", float, Float) },
-	{ "long"sv, DESC("long", long, Int) },
-	{ "ulong"sv, DESC("ulong", unsigned long, Int) },
-	{ "double"sv, DESC("double", double, Float) },
-	{ "int8"sv, DESC("int8", int8_t, Int) },
-	{ "uint8"sv, DESC("uint8", uint8_t, Int) },
-	{ "int16"sv, DESC("int16", int16_t, Int) },
-	{ "uint16"sv, DESC("uint16", uint16_t, Int) },
-	{ "int32"sv, DESC("int32", int32_t, Int) },
-	{ "uint32"sv, DESC("uint32", uint32_t, Int) },
-	{ "int64"sv, DESC("int64", int64_t, Int) },
-	{ "uint64"sv, DESC("uint64", uint64_t, Int) },
-	{ "float32"sv, DESC("float32", float, Float) },
-	{ "float64"sv, DESC("float64", double, Float) },
-	{ "string"sv, PrimitiveType{ "string", config::stringType, PrimitiveTypeClass::StringType, 4 } },
+boost::unordered_map<Symbol, PrimitiveType> primitiveTypes{
+	{ StringPool::builtinSymbol("bool"), DESC("bool", bool, Bool) },
+	{ StringPool::builtinSymbol("byte"), DESC("byte", char, Char) },
+	{ StringPool::builtinSymbol("ubyte"), DESC("ubyte", unsigned char, Char) },
+	{ StringPool::builtinSymbol("short"), DESC("short", short, Int) },
+	{ StringPool::builtinSymbol("ushort"), DESC("ushort", unsigned short, Int) },
+	{ StringPool::builtinSymbol("int"), DESC("int", int, Int) },
+	{ StringPool::builtinSymbol("uint"), DESC("uint", unsigned, Int) },
+	{ StringPool::builtinSymbol("float"), DESC("float", float, Float) },
+	{ StringPool::builtinSymbol("long"), DESC("long", long, Int) },
+	{ StringPool::builtinSymbol("ulong"), DESC("ulong", unsigned long, Int) },
+	{ StringPool::builtinSymbol("double"), DESC("double", double, Float) },
+	{ StringPool::builtinSymbol("int8"), DESC("int8", int8_t, Int) },
+	{ StringPool::builtinSymbol("uint8"), DESC("uint8", uint8_t, Int) },
+	{ StringPool::builtinSymbol("int16"), DESC("int16", int16_t, Int) },
+	{ StringPool::builtinSymbol("uint16"), DESC("uint16", uint16_t, Int) },
+	{ StringPool::builtinSymbol("int32"), DESC("int32", int32_t, Int) },
+	{ StringPool::builtinSymbol("uint32"), DESC("uint32", uint32_t, Int) },
+	{ StringPool::builtinSymbol("int64"), DESC("int64", int64_t, Int) },
+	{ StringPool::builtinSymbol("uint64"), DESC("uint64", uint64_t, Int) },
+	{ StringPool::builtinSymbol("float32"), DESC("float32", float, Float) },
+	{ StringPool::builtinSymbol("float64"), DESC("float64", double, Float) },
+	{ StringPool::builtinSymbol("string"), PrimitiveType{ "string", config::stringType, PrimitiveTypeClass::StringType, 4 } },
 };
 } // namespace expression
 
@@ -63,26 +66,35 @@ using namespace expression;
 
 boost::unordered_set<std::string_view> reservedAttributes{
 	"id",         "deprecated", "required", "force_align",   "force_align", "bit_flags", "nested_flatbuffer",
-	"flexbuffer", "key",        "hash",     "original_order"
+	"flexbuffer", "key",        "hash",     "original_order", "borrowed",    "hot"
 };
 
-MetadataEntry globalMetadata(std::string const& name,
-                             ast::Metadata::mapped_type const& value,
-                             std::string const& errMsg) {
+MetadataEntry globalMetadata(Symbol name, std::optional<ast::SingleValue> const& value, std::string const& errMsg) {
 	// should not be used directly
 	// fmt::print("Error: Unknown or unsupported metadata type: {}", metadata->toString());
 	throw Error("Unknown or unsupported metadata");
 }
 
-MetadataEntry fieldMetadata(ast::FieldDeclaration const& field,
-                            std::string const& name,
-                            ast::Metadata::mapped_type const& value) {
-	if (name == "deprecated") {
+MetadataEntry fieldMetadata(StaticContext const& state,
+                            ast::FieldDeclaration const& field,
+                            Symbol name,
+                            std::optional<ast::SingleValue> const& value) {
+	if (name.view() == "deprecated" || name.view() == "borrowed" || name.view() == "hot") {
 		if (value) {
 			fmt::print(stderr, "Didn't expect value for metadata type {}\n", name);
 			throw Error("Unexpected metadata value");
 		}
-		return MetadataEntry{ .type = MetadataType::deprecated };
+		if (name.view() == "hot") {
+			return MetadataEntry{ .type = MetadataType::hot, .value = {} };
+		}
+		return MetadataEntry{ .type = name.view() == "deprecated" ? MetadataType::deprecated : MetadataType::borrowed,
+		                      .value = {} };
+	} else if (name.view() == "nested_flatbuffer") {
+		if (!value) {
+			fmt::print(stderr, "Error: nested_flatbuffer of field {} needs the root type as value\n", field.identifier);
+			throw Error("Missing metadata value");
+		}
+		return MetadataEntry{ .type = MetadataType::nestedFlatbuffer, .value = state.intern(value->toString()) };
 	}
 	return globalMetadata(name, value, "");
 }
@@ -96,6 +108,7 @@ struct CompilerVisitor : ast::Visitor {
 
 	explicit CompilerVisitor(StaticContext& state) : state(state) {}
 
+	// includes are resolved and compiled by Compiler::load before this file gets visited
 	void visit(const struct ast::IncludeDeclaration& declaration) override { Visitor::visit(declaration); }
 	void visit(const struct ast::NamespaceDeclaration& declaration) override {
 		if (state.currentFile->namespacePath.has_value()) {
@@ -111,7 +124,8 @@ struct CompilerVisitor : ast::Visitor {
 		if (state.currentFile->attributes.contains(declaration.attribute)) {
 			fmt::print(stderr, "Error: Attribute {} defined multiple times\n", declaration.attribute);
 			throw Error("Multiple attributes");
-		} else if (reservedAttributes.contains(declaration.attribute) || startsWith(declaration.attribute, "native_")) {
+		} else if (reservedAttributes.contains(declaration.attribute.view()) ||
+		           startsWith(declaration.attribute.view(), "native_")) {
 			fmt::print(stderr, "Error: Attribute {} is reserved\n", declaration.attribute);
 			throw Error("Reserved attribute");
 		} else {
@@ -147,9 +161,9 @@ struct CompilerVisitor : ast::Visitor {
 		} else if (state.currentFile->fileIdentifier.has_value()) {
 			fmt::print(stderr,
 			           "Multiple file identifiers \"{}\" and \"{}\"\n",
-			           state.currentFile->fileExtension.value(),
+			           state.currentFile->fileIdentifier.value(),
 			           declaration.identifier);
-			throw Error("Multiple file extensions");
+			throw Error("Multiple file identifiers");
 		} else {
 			state.currentFile->fileIdentifier = declaration.identifier;
 		}
@@ -158,17 +172,17 @@ struct CompilerVisitor : ast::Visitor {
 		if (state.currentFile->typeExists(declaration.identifier)) {
 			fmt::print(stderr, "Error: Type {} already exists\n", declaration.identifier);
 			throw Error("Duplicate type");
-		} else if (!primitiveTypes.contains(declaration.type) ||
-		           (primitiveTypes[declaration.type].typeClass != PrimitiveTypeClass::IntType &&
-		            primitiveTypes[declaration.type].typeClass != PrimitiveTypeClass::CharType)) {
+		} else if (auto base = primitiveTypes.find(declaration.type);
+		           base == primitiveTypes.end() || (base->second.typeClass != PrimitiveTypeClass::IntType &&
+		                                            base->second.typeClass != PrimitiveTypeClass::CharType)) {
 			fmt::print(stderr, "Error: Type {} can't be used as base for an enum\n", declaration.type);
 			throw Error("Incompatible enum type");
 		}
-		expression::Enum newEnum;
+		expression::Enum newEnum(state.currentFile->arena);
 		newEnum.name = declaration.identifier;
 		newEnum.type = declaration.type;
 		int64_t lastVal = -1;
-		boost::unordered_set<std::string_view> usedIdentifiers;
+		boost::unordered_set<Symbol> usedIdentifiers;
 		boost::unordered_set<int64_t> usedValues;
 		for (auto const& val : declaration.enumerations) {
 			int64_t value;
@@ -186,8 +200,10 @@ struct CompilerVisitor : ast::Visitor {
 				throw Error("Duplicate enum identifier");
 			}
 			usedValues.insert(value);
+			usedIdentifiers.insert(val.first);
 			newEnum.values.emplace_back(val.first, value);
 		}
+		state.currentFile->declarationOrder.push_back(newEnum.name);
 		state.currentFile->enums.emplace(newEnum.name, std::move(newEnum));
 	}
 	void visit(const struct ast::UnionDeclaration& declaration) override {
@@ -195,7 +211,7 @@ struct CompilerVisitor : ast::Visitor {
 			fmt::print(stderr, "Error: Type {} already exists\n", declaration.identifier);
 			throw Error("Duplicate type");
 		}
-		expression::Union newUnion;
+		expression::Union newUnion(state.currentFile->arena);
 		newUnion.name = declaration.identifier;
 		for (auto const& val : declaration.enumerations) {
 			if (val.second.has_value()) {
@@ -208,6 +224,7 @@ struct CompilerVisitor : ast::Visitor {
 			}
 			newUnion.types.push_back(val.first);
 		}
+		state.currentFile->declarationOrder.push_back(newUnion.name);
 		state.currentFile->unions.emplace(newUnion.name, std::move(newUnion));
 	}
 
@@ -217,36 +234,39 @@ struct CompilerVisitor : ast::Visitor {
 			fmt::print(stderr, "Error: Type {} already exists\n", res.name);
 			throw Error("Duplicate type");
 		}
-		boost::unordered_set<std::string_view> prevFields;
+		boost::unordered_set<Symbol> prevFields;
+		res.fields.reserve(fields.size());
 		for (auto const& field : fields) {
-			expression::Field f;
-			if (prevFields.contains(field.identifier)) {
-				fmt::print("Error: duplicate field {} in {}\n", field.identifier, res.name);
+			expression::Field f(state.currentFile->arena);
+			if (!prevFields.insert(field.identifier).second) {
+				fmt::print(stderr, "Error: duplicate field {} in {}\n", field.identifier, res.name);
 				throw Error("Duplicate field");
 			}
 			f.name = field.identifier;
 			f.type = field.type.type();
 			f.isArrayType = field.type.isArray();
 			if (field.value) {
-				f.defaultValue = field.value.value().toString();
+				f.defaultValue = state.intern(field.value.value().toString());
 			}
 			for (auto const& m : field.metadata) {
-				f.metadata.push_back(fieldMetadata(field, m.first, m.second));
+				f.metadata.push_back(fieldMetadata(state, field, m.first, m.second));
 			}
-			res.fields.push_back(f);
+			res.fields.push_back(std::move(f));
 		}
 	}
 
 	void visit(const struct ast::StructDeclaration& declaration) override {
-		expression::Struct res;
+		expression::Struct res(state.currentFile->arena);
 		res.name = declaration.identifier;
 		constructStructOrTable(res, declaration.fields);
+		state.currentFile->declarationOrder.push_back(res.name);
 		state.currentFile->structs.emplace(res.name, std::move(res));
 	}
 	void visit(const struct ast::TableDeclaration& declaration) override {
-		expression::Table res;
+		expression::Table res(state.currentFile->arena);
 		res.name = declaration.identifier;
 		constructStructOrTable(res, declaration.fields);
+		state.currentFile->declarationOrder.push_back(res.name);
 		state.currentFile->tables.emplace(res.name, std::move(res));
 	}
 };
@@ -255,16 +275,36 @@ struct CompilerVisitor : ast::Visitor {
 
 namespace expression {
 
-bool ExpressionTree::typeExists(const std::string& name) const {
+MetadataEntry const* Field::findMetadata(MetadataType type) const {
+	auto iter = std::find_if(metadata.begin(), metadata.end(), [type](auto const& m) { return m.type == type; });
+	return iter == metadata.end() ? nullptr : &*iter;
+}
+
+std::optional<Symbol> Field::nestedFlatbuffer() const {
+	if (auto entry = findMetadata(MetadataType::nestedFlatbuffer)) {
+		return entry->value;
+	}
+	return {};
+}
+
+ExpressionTree::ExpressionTree(std::pmr::memory_resource* arena)
+  : arena(arena), enums(arena), unions(arena), structs(arena), tables(arena), declarationOrder(arena) {}
+
+bool ExpressionTree::typeExists(Symbol name) const {
 	return primitiveTypes.contains(name) || enums.contains(name) || unions.contains(name) || structs.contains(name) ||
 	       tables.contains(name);
 }
-void ExpressionTree::verifyField(std::string name, bool isStruct, const Field& field) const {
-	std::string typeLiteral = field.type;
+void ExpressionTree::verifyField(StaticContext const& context,
+                                 Symbol name,
+                                 bool isStruct,
+                                 const Field& field) const {
+	std::string typeLiteral = field.type.str();
 	if (field.isArrayType) {
 		typeLiteral = fmt::format("[{}]", field.type);
 	}
-	if (!typeExists(field.type)) {
+	// the type might be defined in this file or in any of the included files
+	auto fieldType = context.resolve(field.type);
+	if (!fieldType) {
 		fmt::print(stderr,
 		           "{} {} defines field {} of type {}, but {} can't be found\n",
 		           isStruct ? "Struct" : "Table",
@@ -274,6 +314,21 @@ void ExpressionTree::verifyField(std::string name, bool isStruct, const Field& f
 		           field.type);
 		throw Error("Type not found");
 	}
+	if (isStruct) {
+		// the inline data of a struct can't reference other objects
+		auto primitive = dynamic_cast<PrimitiveType const*>(fieldType->second);
+		bool isInline = (primitive && primitive->typeClass != PrimitiveTypeClass::StringType) ||
+		                fieldType->second->typeType() == TypeType::Enum ||
+		                fieldType->second->typeType() == TypeType::Struct;
+		if (field.isArrayType || !isInline) {
+			fmt::print(stderr,
+			           "Error: Field {} in struct {}: structs can only contain scalars, enums and structs, got {}\n",
+			           field.name,
+			           name,
+			           typeLiteral);
+			throw Error("Invalid struct field");
+		}
+	}
 	if (field.defaultValue && field.isArrayType) {
 		fmt::print(stderr,
 		           "Field {} in {} {}: Can't assign value to array type {}\n",
@@ -283,12 +338,49 @@ void ExpressionTree::verifyField(std::string name, bool isStruct, const Field& f
 		           typeLiteral);
 		throw Error("Assign value to array type");
 	}
+	if (field.hasMetadata(MetadataType::borrowed)) {
+		// only strings and vectors of strings, scalars and enums have a non-owning native type
+		auto primitive = dynamic_cast<PrimitiveType const*>(fieldType->second);
+		bool isString = primitive && primitive->typeClass == PrimitiveTypeClass::StringType;
+		bool isElement = fieldType->second->typeType() == TypeType::Enum ||
+		                 (primitive && primitive->typeClass != PrimitiveTypeClass::BoolType);
+		if (!isString && !(field.isArrayType && isElement)) {
+			fmt::print(stderr,
+			           "Error: Field {} in {} {}: {} can't be borrowed\n",
+			           field.name,
+			           isStruct ? "struct" : "table",
+			           name,
+			           typeLiteral);
+			throw Error("Invalid borrowed field");
+		}
+	}
+	if (auto nested = field.nestedFlatbuffer()) {
+		// nested buffers are stored as vectors of bytes
+		auto isBytes = field.isArrayType && (field.type.view() == "ubyte" || field.type.view() == "uint8");
+		auto rootType = context.resolve(*nested);
+		if (!isBytes || !rootType || rootType->second->typeType() != TypeType::Table) {
+			fmt::print(stderr,
+			           "Error: Field {} in {} {}: nested_flatbuffer needs a [ubyte] field and a table as root type, "
+			           "got {} and {}\n",
+			           field.name,
+			           isStruct ? "struct" : "table",
+			           name,
+			           typeLiteral,
+			           *nested);
+			throw Error("Invalid nested flatbuffer");
+		}
+	}
+	if (isStruct && field.hasMetadata(MetadataType::hot)) {
+		// the layout of structs is fixed by the declaration order of their fields
+		fmt::print(stderr, "Error: Field {} in struct {}: only fields of tables can be hot\n", field.name, name);
+		throw Error("Invalid hot field");
+	}
 	if (field.defaultValue) {
-		if (field.defaultValue && enums.contains(field.type)) {
-			auto const& e = enums.at(field.type);
+		if (fieldType->second->typeType() == TypeType::Enum) {
+			auto const& e = dynamic_cast<Enum const&>(*fieldType->second);
 			bool found = false;
 			for (auto const& [n, _] : e.values) {
-				found = found || n == field.defaultValue.value();
+				found = found || n == *field.defaultValue;
 			}
 			if (!found) {
 				fmt::print(stderr,
@@ -297,14 +389,14 @@ void ExpressionTree::verifyField(std::string name, bool isStruct, const Field& f
 				           isStruct ? "struct" : "table",
 				           name,
 				           field.defaultValue.value());
-				std::vector<std::string> values;
+				std::vector<Symbol> values;
 				std::transform(e.values.begin(), e.values.end(), std::back_inserter(values), [](auto const& p) {
 					return p.first;
 				});
 				fmt::print("       possible values are: [{}]\n", fmt::join(values, ", "));
 				throw Error("Invalid enum value");
 			}
-		} else if (!primitiveTypes.contains(field.type)) {
+		} else if (fieldType->second->typeType() != TypeType::Primitive) {
 			fmt::print(stderr,
 			           "Error: Field {} in {} {}: Can't assign value to user defined type {}\n",
 			           field.name,
@@ -317,7 +409,7 @@ void ExpressionTree::verifyField(std::string name, bool isStruct, const Field& f
 }
 
 void ExpressionTree::verify(StaticContext const& context) const {
-	auto assertTypeIsUnique = [&context](std::string const& name) {
+	auto assertTypeIsUnique = [&context](Symbol name) {
 		if (context.resolve(name, true)) {
 			std::cerr << fmt::format("Error: Duplicate type: {}", name);
 			throw Error("Duplicate type");
@@ -352,17 +444,17 @@ void ExpressionTree::verify(StaticContext const& context) const {
 	for (auto const& s : structs) {
 		assertTypeIsUnique(s.second.name);
 		for (auto const& field : s.second.fields) {
-			verifyField(s.first, true, field);
+			verifyField(context, s.first, true, field);
 		}
 	}
 	for (auto const& s : tables) {
 		assertTypeIsUnique(s.second.name);
 		for (auto const& field : s.second.fields) {
-			verifyField(s.first, false, field);
+			verifyField(context, s.first, false, field);
 		}
 	}
 }
-std::optional<Type const*> ExpressionTree::findType(const std::string& name) const {
+std::optional<Type const*> ExpressionTree::findType(Symbol name) const {
 	std::optional<const Type*> res;
 	if (auto eIter = enums.find(name); eIter != enums.end()) {
 		res = &eIter->second;
@@ -379,20 +471,141 @@ std::optional<Type const*> ExpressionTree::findType(const std::string& name) con
 
 Compiler::Compiler(std::vector<std::string> includePaths) : includePaths(std::move(includePaths)) {}
 
-void Compiler::compile(std::string const& inputPath) {
+namespace {
+
+ast::SchemaDeclaration parseFile(boost::filesystem::path const& path, StringPool& symbols, TimeReport& report) {
+	TimeReport::Scope scope(report, Phase::Parse, path.string());
+	MappedFile file(path);
+	return parseSchema(file.contents(), symbols);
+}
+
+} // namespace
+
+boost::filesystem::path Compiler::resolveInclude(boost::filesystem::path const& includingFile,
+                                                 std::string const& include) const {
+	namespace fs = boost::filesystem;
+	boost::system::error_code ec;
+	if (auto candidate = includingFile.parent_path() / include; fs::is_regular_file(candidate, ec)) {
+		return fs::canonical(candidate);
+	}
+	for (auto const& dir : includePaths) {
+		if (auto candidate = fs::path(dir) / include; fs::is_regular_file(candidate, ec)) {
+			return fs::canonical(candidate);
+		}
+	}
+	fmt::print(stderr, "Error: {} includes \"{}\" which can't be found\n", includingFile.string(), include);
+	fmt::print(stderr, "       searched in: [{}]\n", fmt::join(includePaths, ", "));
+	throw Error("Include not found");
+}
+
+/*
+ * Loading happens in two phases:
+ *  1. Discover the include graph breadth first. All files of one level are independent of each other and get read
+ *     and parsed concurrently. Files that were already loaded (in this or in a previous call) are not parsed again.
+ *  2. Compile the files in dependency order (every file after all files it includes), as type resolution needs the
+ *     included types to be available.
+ */
+void Compiler::load(boost::filesystem::path const& path) {
+	using Path = boost::filesystem::path;
+	boost::unordered_map<Path, ast::SchemaDeclaration> schemas;
+	boost::unordered_map<Path, std::vector<Path>> includes;
+	boost::unordered_set<Path> seen{ path };
+	std::vector<Path> frontier{ path };
+	while (!frontier.empty()) {
+		std::vector<std::future<ast::SchemaDeclaration>> parsed;
+		parsed.reserve(frontier.size());
+		for (auto const& p : frontier) {
+			parsed.push_back(std::async(std::launch::async, parseFile, p, std::ref(symbols), std::ref(report)));
+		}
+		std::vector<Path> next;
+		for (std::size_t i = 0; i < frontier.size(); ++i) {
+			auto& schema = schemas[frontier[i]] = parsed[i].get();
+			auto& fileIncludes = includes[frontier[i]];
+			for (auto const& incl : schema.includes) {
+				auto included = resolveInclude(frontier[i], incl.path);
+				fileIncludes.push_back(included);
+				if (!files.contains(included) && seen.insert(included).second) {
+					next.push_back(included);
+				}
+			}
+		}
+		frontier = std::move(next);
+	}
+
+	enum class Mark { InProgress, Done };
+	boost::unordered_map<Path, Mark> marks;
+	std::vector<std::pair<Path, std::size_t>> stack{ { path, 0 } };
+	marks[path] = Mark::InProgress;
+	while (!stack.empty()) {
+		auto& [current, next] = stack.back();
+		auto const& deps = includes[current];
+		if (next < deps.size()) {
+			auto const& dep = deps[next++];
+			if (files.contains(dep)) {
+				continue;
+			}
+			auto [iter, inserted] = marks.emplace(dep, Mark::InProgress);
+			if (inserted) {
+				stack.emplace_back(dep, 0);
+			} else if (iter->second == Mark::InProgress) {
+				fmt::print(stderr, "Error: Cyclic include: {} includes {}\n", current.string(), dep.string());
+				throw Error("Cyclic include");
+			}
+			continue;
+		}
+		auto res = std::make_shared<StaticContext>(*this);
+		res->includes = deps;
+		{
+			TimeReport::Scope scope(report, Phase::Resolve, current.string());
+			CompilerVisitor visitor(*res);
+			schemas[current].accept(visitor);
+		}
+		{
+			TimeReport::Scope scope(report, Phase::Verify, current.string());
+			res->currentFile->verify(*res);
+		}
+		files[current] = std::move(res);
+		marks[current] = Mark::Done;
+		stack.pop_back();
+	}
+}
+
+void Compiler::compile(std::string const& inputPath, GeneratorOptions const& options) {
 	boost::filesystem::path path = boost::filesystem::canonical(inputPath);
-	if (auto iter = files.find(path); iter != files.end()) {
-		compiledFiles[path] = iter->second;
-	}
-	auto res = std::make_shared<StaticContext>(*this);
-	std::ifstream ifs(path.c_str());
-	std::string content((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
-	auto schema = parseSchema(content);
-	CompilerVisitor visitor(*res);
-	schema.accept(visitor);
-	res->currentFile->verify(*res);
-	files[path] = res;
-	compiledFiles[path] = res;
+	if (path.extension() == ".bfbs") {
+		path = loadBinarySchema(path);
+	} else if (!files.contains(path)) {
+		load(path);
+	}
+	compiledFiles[path] = files[path];
+	compiledFiles[path]->options = options;
+}
+
+void Compiler::loadLayoutProfile(std::string const& path) {
+	std::ifstream in(path);
+	if (!in) {
+		fmt::print(stderr, "Error: Can't read layout profile {}\n", path);
+		throw Error("Layout profile not found");
+	}
+	std::string line;
+	for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		// <namespace>.<table>.<field> <accesses>
+		std::istringstream fields(line);
+		std::string field;
+		uint64_t accesses = 0;
+		if (!(fields >> field >> accesses) || field.find('.') == std::string::npos || !(fields >> std::ws).eof()) {
+			fmt::print(stderr,
+			           "Error: {}:{}: expected \"<table>.<field> <accesses>\", got \"{}\"\n",
+			           path,
+			           lineNumber,
+			           line);
+			throw Error("Invalid layout profile");
+		}
+		layoutProfile[field] += accesses;
+	}
 }
 
 void Compiler::generateCode(const std::string& headerDir, const std::string& sourceDir) {
@@ -403,6 +616,7 @@ void Compiler::generateCode(const std::string& headerDir, const std::string& sou
 		auto sourceFileName = stem + ".cpp";
 		auto header = fs::path(headerDir) / headerFileName;
 		auto source = fs::path(sourceDir) / sourceFileName;
+		TimeReport::Scope scope(report, Phase::Emit, name.string());
 		CodeGenerator(context.get()).emit(stem, header, source);
 	}
 }
@@ -410,9 +624,12 @@ void Compiler::describeTables() const {
 	for (auto const& [path, context] : compiledFiles) {
 		fmt::print("Discribing tables in {}:\n", path.string());
 		fmt::print("================================================\n");
-		for (auto const& [_, table] : context->currentFile->tables) {
-			fmt::print("Describing table {}\n", table.name);
-			context->describeTable(table.name);
+		for (auto const& name : context->currentFile->declarationOrder) {
+			if (!context->currentFile->tables.contains(name)) {
+				continue;
+			}
+			fmt::print("Describing table {}\n", name);
+			context->describeTable(name);
 			fmt::print("------------------------------------------------\n");
 		}
 	}
@@ -6,88 +6,131 @@
 #define FLATBUFFER_COMPILER_H
 #include <ostream>
 #include <memory>
-#include <any>
+#include <memory_resource>
 
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <flowflat/flowflat.h>
+
 #include "AST.h"
 #include "Error.h"
+#include "StringPool.h"
+#include "TimeReport.h"
 
 namespace flatbuffers {
 
 class Compiler;
 
-struct StaticContext;
+class StaticContext;
 
 namespace expression {
 
-enum class MetadataType { deprecated };
+// nestedFlatbuffer: the value is the Symbol of the root type of the nested buffer
+// hot: the field is placed at the start of the inline data of its table
+enum class MetadataType { deprecated, borrowed, nestedFlatbuffer, hot };
 
 struct MetadataEntry {
 	MetadataType type;
-	std::any value;
+	// empty for metadata without a value
+	Symbol value;
 };
 
+// Everything below is allocated in the arena of the compilation: strings are interned symbols and containers use the
+// memory resource the node was constructed with.
+
 // the type of the type -- I like silly names
 enum class TypeType { Primitive, Enum, Union, Struct, Table };
 
 struct Type {
-	std::string name;
+	Symbol name;
 	Type() = default;
-	explicit Type(std::string name);
+	explicit Type(Symbol name);
 	virtual ~Type() = default;
 	[[nodiscard]] virtual TypeType typeType() const = 0;
 };
 
 struct Enum : Type {
 	[[nodiscard]] TypeType typeType() const override { return TypeType::Enum; }
-	std::string type;
-	std::vector<std::pair<std::string, int64_t>> values;
+	Symbol type;
+	std::pmr::vector<std::pair<Symbol, int64_t>> values;
+
+	explicit Enum(std::pmr::memory_resource* arena = std::pmr::get_default_resource()) : values(arena) {}
 };
 
 struct Union : Type {
 	[[nodiscard]] TypeType typeType() const override { return TypeType::Union; }
-	std::vector<std::string> types;
+	std::pmr::vector<Symbol> types;
+
+	explicit Union(std::pmr::memory_resource* arena = std::pmr::get_default_resource()) : types(arena) {}
 };
 
 struct Field {
-	std::string name;
-	std::string type;
+	Symbol name;
+	Symbol type;
 	bool isArrayType = false;
-	std::optional<std::string> defaultValue;
-	std::vector<MetadataEntry> metadata;
+	// as it was written in the schema
+	std::optional<Symbol> defaultValue;
+	std::pmr::vector<MetadataEntry> metadata;
+
+	explicit Field(std::pmr::memory_resource* arena = std::pmr::get_default_resource()) : metadata(arena) {}
+
+	[[nodiscard]] MetadataEntry const* findMetadata(MetadataType type) const;
+	[[nodiscard]] bool hasMetadata(MetadataType type) const { return findMetadata(type) != nullptr; }
+	// the root type of a nested flatbuffer field
+	[[nodiscard]] std::optional<Symbol> nestedFlatbuffer() const;
 };
 
 struct StructOrTable : Type {
-	std::vector<Field> fields;
+	std::pmr::vector<Field> fields;
+
+	explicit StructOrTable(std::pmr::memory_resource* arena = std::pmr::get_default_resource()) : fields(arena) {}
 };
 
 struct Struct : StructOrTable {
+	using StructOrTable::StructOrTable;
 	[[nodiscard]] TypeType typeType() const override { return TypeType::Struct; }
 };
 
 struct Table : StructOrTable {
+	// the vtable of a table loaded from a binary schema, empty if the layout has to be computed
+	std::pmr::vector<flowflat::voffset_t> vtable;
+
+	explicit Table(std::pmr::memory_resource* arena = std::pmr::get_default_resource())
+	  : StructOrTable(arena), vtable(arena) {}
 	[[nodiscard]] TypeType typeType() const override { return TypeType::Table; }
 };
 
+// maps names to types, the nodes are allocated in the arena of the compilation
+template <class T>
+using SymbolMap = boost::unordered_map<Symbol,
+                                       T,
+                                       boost::hash<Symbol>,
+                                       std::equal_to<Symbol>,
+                                       std::pmr::polymorphic_allocator<std::pair<Symbol const, T>>>;
+
 struct ExpressionTree {
-	std::optional<std::vector<std::string>> namespacePath;
-	boost::unordered_set<std::string> attributes;
-	boost::unordered_set<std::string> rootTypes;
+	std::pmr::memory_resource* arena;
+	std::optional<std::vector<Symbol>> namespacePath;
+	boost::unordered_set<Symbol> attributes;
+	boost::unordered_set<Symbol> rootTypes;
 	std::optional<std::string> fileIdentifier;
 	std::optional<std::string> fileExtension;
-	boost::unordered_map<std::string, Enum> enums;
-	boost::unordered_map<std::string, Union> unions;
-	boost::unordered_map<std::string, Struct> structs;
-	boost::unordered_map<std::string, Table> tables;
+	SymbolMap<Enum> enums;
+	SymbolMap<Union> unions;
+	SymbolMap<Struct> structs;
+	SymbolMap<Table> tables;
+	// user defined types in the order they were declared -- used to generate deterministic code
+	std::pmr::vector<Symbol> declarationOrder;
 
-	[[nodiscard]] bool typeExists(std::string const& name) const;
+	explicit ExpressionTree(std::pmr::memory_resource* arena = std::pmr::get_default_resource());
 
-	void verifyField(std::string name, bool isStruct, Field const& field) const;
+	[[nodiscard]] bool typeExists(Symbol name) const;
 
-	std::optional<Type const*> findType(std::string const& name) const;
+	void verifyField(StaticContext const& context, Symbol name, bool isStruct, Field const& field) const;
+
+	std::optional<Type const*> findType(Symbol name) const;
 
 	void verify(StaticContext const& context) const;
 };
@@ -100,48 +143,84 @@ struct PrimitiveType : Type {
 	unsigned _size;
 
 	PrimitiveType() = default;
-	PrimitiveType(std::string name, std::string_view nativeName, PrimitiveTypeClass typeClass, unsigned _size)
-	  : Type(name), nativeName(nativeName), typeClass(typeClass), _size(_size) {}
+	PrimitiveType(std::string_view name, std::string_view nativeName, PrimitiveTypeClass typeClass, unsigned _size)
+	  : Type(StringPool::builtinSymbol(name)), nativeName(nativeName), typeClass(typeClass), _size(_size) {}
 
 	[[nodiscard]] unsigned size() const { return _size; }
 	[[nodiscard]] TypeType typeType() const override { return TypeType::Primitive; }
 };
 
-extern boost::unordered_map<std::string_view, PrimitiveType> primitiveTypes;
+// keyed by builtin symbols -- every StringPool interns primitive type names to these
+extern boost::unordered_map<Symbol, PrimitiveType> primitiveTypes;
 
 } // namespace expression
 
 struct TypeName {
-	std::string name;
-	std::vector<std::string> path;
+	Symbol name;
+	std::vector<Symbol> path;
 
 	[[nodiscard]] inline bool operator==(TypeName const& rhs) const { return name == rhs.name && path == rhs.path; }
 	[[nodiscard]] bool operator!=(TypeName const& rhs) const { return !(*this == rhs); }
+	[[nodiscard]] bool operator<(TypeName const& rhs) const {
+		return path < rhs.path || (path == rhs.path && name < rhs.name);
+	}
 };
 
 [[nodiscard]] std::size_t hash_value(TypeName const& v);
 
-struct StaticContext;
+// how the code of a compiled file is generated
+struct GeneratorOptions {
+	// non-owning types for strings and vectors (see the borrowed field attribute)
+	bool borrowed = false;
+	// std::pmr containers and allocator aware tables. Files which are included by such a file have to be generated
+	// with pmr as well.
+	bool pmr = false;
+	// views and read() count field accesses and decodes (see flowflat/profile.h)
+	bool profileAccess = false;
+};
 
 class Compiler {
 	friend struct expression::Field;
 	friend struct expression::StructOrTable;
 	friend class StaticContext;
+	// Identifiers and expression nodes of this compilation. These have to outlive everything below.
+	StringPool symbols;
+	std::pmr::monotonic_buffer_resource arena;
 	// compiled files (used to optimize includes). Filepath -> expression tree
 	boost::unordered_map<boost::filesystem::path, std::shared_ptr<StaticContext>> files;
 	// where to search for included files
 	std::vector<std::string> includePaths;
 	// Files that got compiled in this run
 	boost::unordered_map<boost::filesystem::path, std::shared_ptr<StaticContext>> compiledFiles;
+	// recording doesn't change the compilation, so it also happens in const member functions
+	mutable TimeReport report;
+	// field accesses ("<namespace>.<table>.<field>" -> count) which guide the layout of tables
+	boost::unordered_map<std::string, uint64_t> layoutProfile;
+
+	// find an included file relative to the including file or in one of the include paths
+	[[nodiscard]] boost::filesystem::path resolveInclude(boost::filesystem::path const& includingFile,
+	                                                     std::string const& include) const;
+	// parse path and everything it (transitively) includes and add them to files
+	void load(boost::filesystem::path const& path);
+	// add the files of a binary schema to files and return the path of its root file (defined in BinarySchema.cpp)
+	boost::filesystem::path loadBinarySchema(boost::filesystem::path const& path);
 
 public:
 	explicit Compiler(std::vector<std::string> includePaths);
 
-	void compile(std::string const& path);
+	void compile(std::string const& path, GeneratorOptions const& options = {});
+	// reads a field access profile as written by flowflat::profile::dump. It changes the layout of every table with
+	// profiled fields, so it has to be read before any code or binary schema is generated. Tables loaded from a binary
+	// schema keep the layout stored in it.
+	void loadLayoutProfile(std::string const& path);
+	// disabled unless enabled before the first file gets compiled
+	[[nodiscard]] TimeReport& timeReport() const { return report; }
 
 	// defined in CodeGenerator.cpp
 	void generateCode(std::string const& headerDir, std::string const& sourceDir);
 	void describeTables() const;
+	// write a binary schema (<name>.bfbs) for every compiled file (defined in BinarySchema.cpp)
+	void writeBinarySchemas(std::string const& dir) const;
 };
 
 } // namespace flatbuffers
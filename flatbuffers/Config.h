@@ -15,6 +15,11 @@ constexpr std::string_view usingLiterals =
 
 constexpr std::string_view stringType = "std::string"sv;
 constexpr std::string_view stringViewType = "std::string_view"sv;
+constexpr std::string_view vectorType = "std::vector"sv;
+// native types of files which are generated with polymorphic allocators
+constexpr std::string_view pmrStringType = "std::pmr::string"sv;
+constexpr std::string_view pmrVectorType = "std::pmr::vector"sv;
+constexpr std::string_view allocatorType = "std::pmr::polymorphic_allocator<char>"sv;
 constexpr std::string_view stringViewLiteral = "sv"sv;
 constexpr std::string_view stringLiteral = "s";
 
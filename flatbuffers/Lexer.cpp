@@ -0,0 +1,165 @@
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "Lexer.h"
+
+namespace flatbuffers {
+
+namespace {
+
+// we don't use <cctype> as it is locale dependent and doesn't get inlined
+constexpr bool isIdentStart(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+constexpr bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+constexpr bool isIdentChar(char c) {
+	return isIdentStart(c) || isDigit(c);
+}
+
+constexpr bool isPunctuation(char c) {
+	switch (c) {
+	case ';':
+	case ':':
+	case '{':
+	case '}':
+	case '[':
+	case ']':
+	case '(':
+	case ')':
+	case ',':
+	case '=':
+	case '.':
+		return true;
+	default:
+		return false;
+	}
+}
+
+} // namespace
+
+void Lexer::skipWhitespaceAndComments() {
+	while (pos < input.size()) {
+		char c = input[pos];
+		if (c == '\n') {
+			++line;
+			++pos;
+		} else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+			++pos;
+		} else if (c == '/' && pos + 1 < input.size() && input[pos + 1] == '/') {
+			auto eol = input.find('\n', pos + 2);
+			pos = eol == std::string_view::npos ? input.size() : eol;
+		} else if (c == '/' && pos + 1 < input.size() && input[pos + 1] == '*') {
+			// block comments can be nested
+			auto start = line;
+			int depth = 1;
+			pos += 2;
+			while (depth > 0) {
+				if (pos + 1 >= input.size()) {
+					line = start;
+					error("unterminated block comment");
+				} else if (input[pos] == '/' && input[pos + 1] == '*') {
+					++depth;
+					pos += 2;
+				} else if (input[pos] == '*' && input[pos + 1] == '/') {
+					--depth;
+					pos += 2;
+				} else {
+					line += input[pos] == '\n';
+					++pos;
+				}
+			}
+		} else {
+			return;
+		}
+	}
+}
+
+Token Lexer::next() {
+	skipWhitespaceAndComments();
+	Token res;
+	res.line = line;
+	if (pos >= input.size()) {
+		res.text = input.substr(input.size());
+		return res;
+	}
+	auto start = pos;
+	char c = input[pos];
+	if (isIdentStart(c)) {
+		while (pos < input.size() && isIdentChar(input[pos])) {
+			++pos;
+		}
+		res.kind = TokenKind::Identifier;
+	} else if (c == '"') {
+		auto end = input.find('"', pos + 1);
+		if (end == std::string_view::npos) {
+			error("unterminated string constant");
+		}
+		for (auto i = pos + 1; i < end; ++i) {
+			line += input[i] == '\n';
+		}
+		pos = end + 1;
+		res.kind = TokenKind::String;
+		res.text = input.substr(start + 1, end - start - 1);
+		return res;
+	} else if (isDigit(c) || ((c == '-' || c == '+') && pos + 1 < input.size() && isDigit(input[pos + 1]))) {
+		++pos;
+		res.kind = TokenKind::Integer;
+		while (pos < input.size() && isDigit(input[pos])) {
+			++pos;
+		}
+		if (pos + 1 < input.size() && input[pos] == '.' && isDigit(input[pos + 1])) {
+			res.kind = TokenKind::Float;
+			++pos;
+			while (pos < input.size() && isDigit(input[pos])) {
+				++pos;
+			}
+		}
+		if (pos < input.size() && (input[pos] == 'e' || input[pos] == 'E')) {
+			auto exp = pos + 1;
+			if (exp < input.size() && (input[exp] == '-' || input[exp] == '+')) {
+				++exp;
+			}
+			if (exp < input.size() && isDigit(input[exp])) {
+				res.kind = TokenKind::Float;
+				pos = exp;
+				while (pos < input.size() && isDigit(input[pos])) {
+					++pos;
+				}
+			}
+		}
+	} else if (isPunctuation(c)) {
+		++pos;
+		res.kind = TokenKind::Punctuation;
+	} else {
+		error(fmt::format("unexpected character '{}'", c));
+	}
+	res.text = input.substr(start, pos - start);
+	return res;
+}
+
+void Lexer::error(std::string_view message) const {
+	Token t;
+	t.line = line;
+	t.text = input.substr(std::min(pos, input.size()), 1);
+	printErrorLocation(input, t, message);
+	throw std::runtime_error("Parser Error");
+}
+
+void printErrorLocation(std::string_view source, Token const& token, std::string_view message) {
+	auto offset = static_cast<std::size_t>(token.text.data() - source.data());
+	auto lineStart = source.rfind('\n', offset == 0 ? 0 : offset - 1);
+	lineStart = lineStart == std::string_view::npos || offset == 0 ? 0 : lineStart + 1;
+	auto lineEnd = source.find('\n', offset);
+	auto lineText = source.substr(lineStart, lineEnd == std::string_view::npos ? lineEnd : lineEnd - lineStart);
+	fmt::print(stderr, "In line {}:\n", token.line);
+	fmt::print(stderr, "Error! {} here:\n", message);
+	fmt::print(stderr, "{}\n", lineText);
+	fmt::print(stderr, "{:_>{}}^_\n", "", offset - lineStart);
+}
+
+} // namespace flatbuffers
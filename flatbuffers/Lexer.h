@@ -0,0 +1,53 @@
+#ifndef FLATBUFFER_LEXER_H
+#define FLATBUFFER_LEXER_H
+#include <string_view>
+#include <cstdint>
+
+namespace flatbuffers {
+
+enum class TokenKind {
+	Identifier,
+	// string constants (without the quotes)
+	String,
+	Integer,
+	Float,
+	// a single character like ; : { } [ ] ( ) , = .
+	Punctuation,
+	End
+};
+
+struct Token {
+	TokenKind kind = TokenKind::End;
+	std::string_view text;
+	// 1-based line of the first character of the token
+	unsigned line = 1;
+
+	[[nodiscard]] bool is(char c) const { return kind == TokenKind::Punctuation && text[0] == c; }
+	[[nodiscard]] bool isKeyword(std::string_view keyword) const {
+		return kind == TokenKind::Identifier && text == keyword;
+	}
+};
+
+// A single pass lexer over the schema. It never allocates: all tokens point into the input. Whitespace, line comments
+// and (nested) block comments are skipped.
+class Lexer {
+	std::string_view input;
+	std::size_t pos = 0;
+	unsigned line = 1;
+
+	void skipWhitespaceAndComments();
+	[[noreturn]] void error(std::string_view message) const;
+
+public:
+	explicit Lexer(std::string_view input) : input(input) {}
+
+	Token next();
+	[[nodiscard]] std::string_view source() const { return input; }
+};
+
+// prints the line containing the token with a marker under it
+void printErrorLocation(std::string_view source, Token const& token, std::string_view message);
+
+} // namespace flatbuffers
+
+#endif // FLATBUFFER_LEXER_H
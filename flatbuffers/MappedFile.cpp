@@ -0,0 +1,58 @@
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "MappedFile.h"
+#include "Error.h"
+
+namespace flatbuffers {
+
+MappedFile::MappedFile(boost::filesystem::path const& path) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		fmt::print(stderr, "Error: Can't open file {}\n", path.string());
+		throw Error("Can't open file");
+	}
+	struct stat st {};
+	if (::fstat(fd, &st) != 0) {
+		::close(fd);
+		fmt::print(stderr, "Error: Can't stat file {}\n", path.string());
+		throw Error("Can't open file");
+	}
+	length = st.st_size;
+	// mmap doesn't support empty mappings -- an empty file is represented by a null pointer
+	if (length > 0) {
+		data = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			data = nullptr;
+			::close(fd);
+			fmt::print(stderr, "Error: Can't map file {}\n", path.string());
+			throw Error("Can't map file");
+		}
+		// we read the file once from front to back
+		::madvise(const_cast<void*>(data), length, MADV_SEQUENTIAL);
+	}
+	::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+  : data(std::exchange(other.data, nullptr)), length(std::exchange(other.length, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	std::swap(data, other.data);
+	std::swap(length, other.length);
+	return *this;
+}
+
+MappedFile::~MappedFile() {
+	if (data) {
+		::munmap(const_cast<void*>(data), length);
+	}
+}
+
+} // namespace flatbuffers
@@ -0,0 +1,30 @@
+#ifndef FLATBUFFER_MAPPEDFILE_H
+#define FLATBUFFER_MAPPEDFILE_H
+#include <string_view>
+#include <cstddef>
+
+#include <boost/filesystem/path.hpp>
+
+namespace flatbuffers {
+
+// A read-only memory mapping of a whole file. Schemas are parsed directly from the mapping, so we never copy the
+// input into a string.
+class MappedFile {
+	void const* data = nullptr;
+	std::size_t length = 0;
+
+public:
+	explicit MappedFile(boost::filesystem::path const& path);
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	[[nodiscard]] std::string_view contents() const { return { static_cast<char const*>(data), length }; }
+	[[nodiscard]] std::size_t size() const { return length; }
+};
+
+} // namespace flatbuffers
+
+#endif // FLATBUFFER_MAPPEDFILE_H
@@ -2,136 +2,309 @@
 // Created by Markus Pilman on 10/14/22.
 //
 
-#include <iostream>
-
-#include <boost/fusion/adapted.hpp>
-#include <boost/spirit/home/x3.hpp>
-#include <boost/spirit/home/x3/support/utility/error_reporting.hpp>
-#include <boost/spirit/home/x3/support/utility/annotate_on_success.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <stdexcept>
 
 #include "AST.h"
+#include "Lexer.h"
 #include "Parser.h"
 
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::EnumDeclaration,
-                          (std::string, identifier),
-                          (std::string, type),
-                          (flatbuffers::ast::Metadata, metadata),
-                          (std::vector<flatbuffers::ast::EnumValue>, enumerations))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::UnionDeclaration,
-                          (std::string, identifier),
-                          (flatbuffers::ast::Metadata, metadata),
-                          (std::vector<flatbuffers::ast::EnumValue>, enumerations))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::FieldDeclaration,
-                          (std::string, identifier),
-                          (flatbuffers::ast::Type, type),
-                          (std::optional<flatbuffers::ast::SingleValue>, value),
-                          (flatbuffers::ast::Metadata, metadata))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::StructDeclaration,
-                          (std::string, identifier),
-                          (flatbuffers::ast::Metadata, metadata),
-                          (std::vector<flatbuffers::ast::FieldDeclaration>, fields))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::TableDeclaration,
-                          (std::string, identifier),
-                          (flatbuffers::ast::Metadata, metadata),
-                          (std::vector<flatbuffers::ast::FieldDeclaration>, fields))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::ArrayType, (std::string, type))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::IncludeDeclaration, (std::string, path))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::NamespaceDeclaration, (flatbuffers::ast::NamespacePath, name))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::AttributeDeclaration, (std::string, attribute))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::RootDeclaration, (std::string, rootType))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::FileExtensionDeclaration, (std::string, extension))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::FileIdentifierDeclaration, (std::string, identifier))
-BOOST_FUSION_ADAPT_STRUCT(flatbuffers::ast::SchemaDeclaration,
-                          (std::vector<flatbuffers::ast::IncludeDeclaration>, includes),
-                          (std::vector<flatbuffers::ast::Declaration>, declarations))
-
 namespace flatbuffers {
 
-namespace x3 = boost::spirit::x3;
+namespace {
+
+// A recursive descent parser for the schema language. Every declaration starts with a keyword, so we can decide what
+// to parse by looking at a single token and never have to backtrack.
+class SchemaParser {
+	Lexer lexer;
+	StringPool& symbols;
+	Token current;
+	Token previous;
+
+	void advance() {
+		previous = current;
+		current = lexer.next();
+	}
+
+	[[noreturn]] void fail(std::string_view expected) const {
+		printErrorLocation(lexer.source(), current, fmt::format("Expecting: {}", expected));
+		throw std::runtime_error("Parser Error");
+	}
+
+	bool accept(char c) {
+		if (current.is(c)) {
+			advance();
+			return true;
+		}
+		return false;
+	}
+
+	void expect(char c) {
+		if (!accept(c)) {
+			fail(fmt::format("'{}'", c));
+		}
+	}
+
+	Symbol identifier() {
+		if (current.kind != TokenKind::Identifier) {
+			fail("identifier");
+		}
+		auto res = symbols.intern(current.text);
+		advance();
+		return res;
+	}
+
+	std::string stringConstant() {
+		if (current.kind != TokenKind::String) {
+			fail("string constant");
+		}
+		std::string res(current.text);
+		advance();
+		return res;
+	}
+
+	int integer() {
+		if (current.kind != TokenKind::Integer) {
+			fail("integer");
+		}
+		auto text = current.text;
+		// from_chars doesn't accept a leading plus
+		if (text.front() == '+') {
+			text.remove_prefix(1);
+		}
+		int res = 0;
+		auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), res);
+		if (ec != std::errc() || ptr != text.data() + text.size()) {
+			fail("integer in range");
+		}
+		advance();
+		return res;
+	}
+
+	ast::Scalar number() {
+		if (current.kind == TokenKind::Integer) {
+			return ast::Scalar(integer());
+		}
+		float res = std::strtof(std::string(current.text).c_str(), nullptr);
+		advance();
+		return ast::Scalar(res);
+	}
+
+	// ident ('.' ident)*
+	Symbol typeName() {
+		if (current.kind != TokenKind::Identifier) {
+			fail("identifier");
+		}
+		// In the common case the name is written without whitespace and we can intern the source text directly. We
+		// only build the name if there is whitespace or a comment somewhere in between.
+		auto begin = current.text.data();
+		std::string qualified;
+		auto append = [this, begin, &qualified]() {
+			auto previousEnd = previous.text.data() + previous.text.size();
+			if (qualified.empty() && current.text.data() != previousEnd) {
+				qualified.assign(begin, previousEnd);
+			}
+			if (!qualified.empty()) {
+				qualified += current.text;
+			}
+			advance();
+		};
+		advance();
+		while (current.is('.')) {
+			append();
+			if (current.kind != TokenKind::Identifier) {
+				fail("identifier");
+			}
+			append();
+		}
+		if (!qualified.empty()) {
+			return symbols.intern(qualified);
+		}
+		return symbols.intern(std::string_view(begin, previous.text.data() + previous.text.size() - begin));
+	}
+
+	ast::Type type() {
+		if (accept('[')) {
+			ast::ArrayType res;
+			res.type = typeName();
+			expect(']');
+			return ast::Type(std::move(res));
+		}
+		return ast::Type(typeName());
+	}
+
+	// values in metadata: bool, int, float or a string constant
+	ast::SingleValue singleValue() {
+		if (current.kind == TokenKind::String) {
+			return ast::SingleValue(stringConstant());
+		} else if (current.isKeyword("true") || current.isKeyword("false")) {
+			bool res = current.text == "true";
+			advance();
+			return ast::SingleValue(ast::Scalar(res));
+		} else if (current.kind == TokenKind::Integer || current.kind == TokenKind::Float) {
+			return ast::SingleValue(number());
+		}
+		fail("value");
+	}
+
+	// default values of fields: string constant, identifier (enum values and booleans) or number
+	ast::SingleValue fieldValue() {
+		if (current.kind == TokenKind::String) {
+			return ast::SingleValue(stringConstant());
+		} else if (current.kind == TokenKind::Identifier) {
+			return ast::SingleValue(identifier().str());
+		} else if (current.kind == TokenKind::Integer || current.kind == TokenKind::Float) {
+			return ast::SingleValue(number());
+		}
+		fail("default value");
+	}
+
+	// ('(' ident (':' value)? (',' ident (':' value)?)* ')')?
+	ast::Metadata metadata() {
+		ast::Metadata res;
+		if (!accept('(')) {
+			return res;
+		}
+		if (accept(')')) {
+			return res;
+		}
+		do {
+			auto key = identifier();
+			std::optional<ast::SingleValue> value;
+			if (accept(':')) {
+				value = singleValue();
+			}
+			// if a key is given multiple times, the first one wins
+			if (std::find_if(res.begin(), res.end(), [key](auto const& e) { return e.first == key; }) == res.end()) {
+				res.emplace_back(key, std::move(value));
+			}
+		} while (accept(','));
+		expect(')');
+		return res;
+	}
+
+	// '{' ident ('=' int)? (',' ident ('=' int)?)* '}'
+	std::vector<ast::EnumValue> enumValues() {
+		std::vector<ast::EnumValue> res;
+		expect('{');
+		do {
+			if (current.is('}')) {
+				// trailing comma
+				break;
+			}
+			auto name = identifier();
+			std::optional<int> value;
+			if (accept('=')) {
+				value = integer();
+			}
+			res.emplace_back(std::move(name), value);
+		} while (accept(','));
+		expect('}');
+		return res;
+	}
+
+	ast::FieldDeclaration field() {
+		ast::FieldDeclaration res;
+		res.identifier = identifier();
+		expect(':');
+		res.type = type();
+		if (accept('=')) {
+			res.value = fieldValue();
+		}
+		res.metadata = metadata();
+		expect(';');
+		return res;
+	}
 
-namespace grammar {
+	template <class Decl>
+	Decl structOrTable() {
+		Decl res;
+		res.identifier = identifier();
+		res.metadata = metadata();
+		expect('{');
+		do {
+			res.fields.push_back(field());
+		} while (!accept('}'));
+		return res;
+	}
 
-struct FBErrorHandler {
-	template <typename Iterator, typename Exception, typename Context>
-	x3::error_handler_result on_error(Iterator& first,
-	                                  Iterator const& last,
-	                                  Exception const& x,
-	                                  Context const& context) {
-		auto& error_handler = x3::get<x3::error_handler_tag>(context).get();
-		std::string message = "Error! Expecting: " + x.which() + " here:";
-		error_handler(x.where(), message);
-		return x3::error_handler_result::fail;
+	ast::Declaration declaration() {
+		if (current.kind != TokenKind::Identifier) {
+			fail("declaration");
+		}
+		auto keyword = current.text;
+		advance();
+		if (keyword == "namespace") {
+			ast::NamespaceDeclaration res;
+			do {
+				res.name.push_back(identifier());
+			} while (accept('.'));
+			expect(';');
+			return ast::Declaration(std::move(res));
+		} else if (keyword == "attribute") {
+			ast::AttributeDeclaration res;
+			res.attribute = identifier();
+			expect(';');
+			return ast::Declaration(std::move(res));
+		} else if (keyword == "root_type") {
+			ast::RootDeclaration res;
+			res.rootType = identifier();
+			expect(';');
+			return ast::Declaration(std::move(res));
+		} else if (keyword == "file_extension") {
+			ast::FileExtensionDeclaration res;
+			res.extension = stringConstant();
+			expect(';');
+			return ast::Declaration(std::move(res));
+		} else if (keyword == "file_identifier") {
+			ast::FileIdentifierDeclaration res;
+			res.identifier = stringConstant();
+			expect(';');
+			return ast::Declaration(std::move(res));
+		} else if (keyword == "enum") {
+			ast::EnumDeclaration res;
+			res.identifier = identifier();
+			expect(':');
+			res.type = identifier();
+			res.metadata = metadata();
+			res.enumerations = enumValues();
+			return ast::Declaration(std::move(res));
+		} else if (keyword == "union") {
+			ast::UnionDeclaration res;
+			res.identifier = identifier();
+			res.metadata = metadata();
+			res.enumerations = enumValues();
+			return ast::Declaration(std::move(res));
+		} else if (keyword == "struct") {
+			return ast::Declaration(structOrTable<ast::StructDeclaration>());
+		} else if (keyword == "table") {
+			return ast::Declaration(structOrTable<ast::TableDeclaration>());
+		}
+		fail("namespace, attribute, root_type, file_extension, file_identifier, enum, union, struct or table");
+	}
+
+public:
+	SchemaParser(std::string_view input, StringPool& symbols) : lexer(input), symbols(symbols) { advance(); }
+
+	ast::SchemaDeclaration parse() {
+		ast::SchemaDeclaration res;
+		while (current.isKeyword("include")) {
+			advance();
+			ast::IncludeDeclaration incl;
+			incl.path = stringConstant();
+			expect(';');
+			res.includes.push_back(std::move(incl));
+		}
+		while (current.kind != TokenKind::End) {
+			res.declarations.push_back(declaration());
+		}
+		return res;
 	}
 };
 
-using x3::bool_;
-using x3::char_;
-using x3::float_;
-using x3::int_;
-using x3::lexeme;
-using x3::lit;
-
-struct struct_decl_class;
-struct table_decl_class;
-x3::rule<struct_decl_class, ast::StructDeclaration> struct_decl = "struct";
-x3::rule<table_decl_class, ast::TableDeclaration> table_decl = "table";
-
-auto semicolon = x3::lit(';');
-auto ident = x3::rule<class ident, std::string>{} = lexeme[char_("a-zA-Z_") >> *char_("a-zA-Z0-9_")];
-auto string_constant = x3::rule<class string_constant, std::string>{} = '"' >> lexeme[*(~char_('"'))] >> '"';
-
-auto array_type = x3::rule<class array_type, ast::ArrayType>{} = '[' >> ident >> ']';
-auto type = x3::rule<class type, ast::Type>{} = ident | array_type;
-auto scalar = x3::rule<class scalar, ast::Scalar>{} = bool_ | int_ | float_;
-auto single_value = x3::rule<class single_value, ast::SingleValue>{} = scalar | string_constant;
-
-auto metadata_entry = x3::rule<class metadata_entry, std::pair<std::string, std::optional<ast::SingleValue>>>{} =
-    ident >> -(':' >> single_value);
-auto metadata = x3::rule<class metadata, std::map<std::string, std::optional<ast::SingleValue>>>{} =
-    -('(' >> *(metadata_entry % ',') >> ')');
-
-auto enum_val_decl = x3::rule<class enum_val_decl, ast::EnumValue>{} = ident >> -('=' >> int_);
-auto enum_decls = x3::rule<class enum_decls, std::vector<ast::EnumValue>>{} = enum_val_decl % ',';
-auto enum_decl = x3::rule<class enum_decl, ast::EnumDeclaration>{} =
-    "enum" > ident > ':' > ident > metadata > '{' > enum_decls > '}';
-auto union_decl = x3::rule<class union_decl, ast::UnionDeclaration>{} =
-    "union" >> ident >> metadata >> '{' >> enum_decls >> '}';
-
-auto field_value = x3::rule<class position, std::optional<ast::SingleValue>>{} = -('=' > (string_constant | ident | scalar));
-auto field_decl = x3::rule<class field_decl, ast::FieldDeclaration>{} =
-    (ident >> ':' >> type >> field_value >> metadata) > ';';
-auto const struct_decl_def = "struct" > ident >> metadata > '{' >> +(field_decl) > '}';
-auto const table_decl_def = "table" > ident >> metadata > '{' >> +(field_decl) > '}';
-
-auto include_stmt = x3::rule<class include_stmt, ast::IncludeDeclaration>{} =
-    lit("include") > string_constant > semicolon;
-auto namespace_path = x3::rule<class namespace_path, std::vector<std::string>>{} = ident % '.';
-auto namespace_decl = x3::rule<class namespace_decl, ast::NamespaceDeclaration>{} =
-    "namespace" >> namespace_path >> semicolon;
-auto attribute_decl = x3::rule<class attribute_decl, ast::AttributeDeclaration>{} =
-    lit("attribute") >> ident >> semicolon;
-auto root_decl = x3::rule<class root_decl, ast::RootDeclaration>{} = lit("root_type") >> ident >> semicolon;
-auto file_extension_decl = x3::rule<class file_extension_decl, ast::FileExtensionDeclaration>{} =
-    lit("file_extension") >> string_constant >> semicolon;
-auto file_identifier_decl = x3::rule<class file_identifier_decl, ast::FileIdentifierDeclaration>{} =
-    lit("file_identifier") >> string_constant >> semicolon;
-
-auto declaration = x3::rule<class declarations, ast::Declaration>{} = namespace_decl | attribute_decl | root_decl |
-                                                                      file_extension_decl | file_identifier_decl |
-                                                                      enum_decl | union_decl | struct_decl | table_decl;
-auto schema_decl = x3::rule<class schema_decl, ast::SchemaDeclaration>{} = *include_stmt >> *declaration;
-
-// Skipper -- we want to skip whitespace and comments
-auto single_line_comment = "//" >> *(char_ - x3::eol) >> (x3::eol | x3::eoi);
-x3::rule<class block_comment> block_comment = "block_comment";
-auto block_comment_def = x3::rule<class block_comment>{} = "/*" >> *(block_comment | (char_ - "*/")) >> "*/";
-BOOST_SPIRIT_DEFINE(block_comment, struct_decl, table_decl);
-
-struct struct_decl_class : FBErrorHandler, x3::annotate_on_success {};
-struct table_decl_class : FBErrorHandler, x3::annotate_on_success {};
-
-auto skipper = x3::space | single_line_comment | block_comment;
-} // namespace grammar
+} // namespace
 
 } // namespace flatbuffers
 
@@ -232,21 +405,8 @@ struct PrintVisitor : flatbuffers::ast::Visitor {
 
 namespace flatbuffers {
 
-ast::SchemaDeclaration parseSchema(const std::string& input) {
-	ast::SchemaDeclaration result;
-	auto begin = input.begin(), end = input.end();
-	using error_handler_type = boost::spirit::x3::error_handler<std::string::const_iterator>;
-	error_handler_type error_handler(begin, end, std::cerr);
-	auto parser = x3::with<x3::error_handler_tag>(std::ref(error_handler))[grammar::schema_decl];
-	auto success = boost::spirit::x3::phrase_parse_main(begin, input.end(), parser, grammar::skipper, result);
-	fmt::print("Parsed file {}\n", success ? "successfully" : "usuccessfully");
-	if (begin != input.end()) {
-		fmt::print("Could not parse: {}", std::string(begin, input.end()));
-	}
-	if (success && begin == input.end()) {
-		return result;
-	}
-	throw std::runtime_error("Parser Error");
+ast::SchemaDeclaration parseSchema(std::string_view input, StringPool& symbols) {
+	return SchemaParser(input, symbols).parse();
 }
 
 void printSchema(const ast::SchemaDeclaration& schemaDeclaration) {
@@ -8,7 +8,9 @@
 
 namespace flatbuffers {
 
-ast::SchemaDeclaration parseSchema(std::string const& input);
+// Identifiers get interned in symbols. Throws std::runtime_error on syntax errors (after printing the location of the
+// error to stderr)
+ast::SchemaDeclaration parseSchema(std::string_view input, StringPool& symbols);
 // debuging function
 [[maybe_unused]] void printSchema(ast::SchemaDeclaration const& schemaDeclaration);
 
@@ -2,11 +2,11 @@
 // Created by Markus Pilman on 10/16/22.
 //
 
+#include <algorithm>
+#include <limits>
 #include <map>
 
 #include <fmt/format.h>
-#include <boost/algorithm/string/split.hpp>
-#include <boost/algorithm/string/classification.hpp>
 
 #include "Compiler.h"
 #include "StaticContext.h"
@@ -17,40 +17,80 @@ using namespace std::string_view_literals;
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "cppcoreguidelines-narrowing-conversions"
-// calculate the vtable for a
-std::vector<flowflat::voffset_t> generateVTable(std::vector<std::pair<unsigned, unsigned>> const& alignmentAndSize) {
-	// std::multimap is stable which is a desired property (although not strictly a requirement)
-	// 0. Build a mapping alignment -> size -> index
-	std::map<unsigned, std::multimap<unsigned, int, std::greater<>>, std::greater<>> map;
-	// indexes in the vtable start at 2. 0 is the size of the vtable, idx 1 is the size of the inlined data for the
-	// object.
-	int idx = 1;
-	for (auto p : alignmentAndSize) {
-		map[p.first].emplace(p.second, ++idx);
-	}
-	std::vector<flowflat::voffset_t> result(alignmentAndSize.size() + 2, flowflat::voffset_t(0));
-	result[0] = 2 * (result.size());
-	// order the elements by size
-	flowflat::voffset_t curr = 4;
-	for (auto const& [a, m] : map) {
+namespace {
+
+// hot fields are placed within the first cache line of the inline data
+constexpr unsigned cacheLineSize = 64;
+
+// alignment -> size -> index. Placing fields in this order needs the least padding.
+using Placement = std::map<unsigned, std::multimap<unsigned, std::size_t, std::greater<>>, std::greater<>>;
+
+// assigns offsets to the fields starting at curr (if result is not null) and returns the end of the last field
+unsigned place(Placement const& fields, unsigned curr, std::vector<flowflat::voffset_t>* result) {
+	for (auto const& [a, m] : fields) {
 		for (auto [s, i] : m) {
 			auto padding = (a - (curr % a)) % a;
 			curr += padding;
-			result[i] = curr;
+			if (result) {
+				(*result)[i] = flowflat::voffset_t(curr);
+			}
 			curr += s;
 		}
 	}
+	return curr;
+}
+
+} // namespace
+
+// calculate the vtable for a table. heat is empty or has the access frequency of every field: fields with a non-zero
+// frequency are hot and get placed first, the most frequently accessed ones as long as they fit into the first cache
+// line (the hottest field is always hot).
+std::vector<flowflat::voffset_t> generateVTable(std::vector<std::pair<unsigned, unsigned>> const& alignmentAndSize,
+                                                std::vector<uint64_t> const& heat) {
+	// std::multimap is stable which is a desired property (although not strictly a requirement)
+	// 0. Build a mapping alignment -> size -> index for the hot and for the cold fields
+	Placement hot, cold;
+	// indexes in the vtable start at 2. 0 is the size of the vtable, idx 1 is the size of the inlined data for the
+	// object. The hottest fields are added first, a field which doesn't fit into the cache line anymore is cold.
+	std::vector<std::size_t> byHeat;
+	for (std::size_t i = 0; i < heat.size(); ++i) {
+		if (heat[i] > 0) {
+			byHeat.push_back(i);
+		}
+	}
+	std::stable_sort(byHeat.begin(), byHeat.end(), [&heat](std::size_t lhs, std::size_t rhs) {
+		return heat[lhs] > heat[rhs];
+	});
+	std::vector<bool> isHot(alignmentAndSize.size(), false);
+	for (auto i : byHeat) {
+		auto [a, s] = alignmentAndSize[i];
+		auto iter = hot[a].emplace(s, i + 2);
+		if (place(hot, 4, nullptr) > cacheLineSize && i != byHeat.front()) {
+			hot[a].erase(iter);
+		} else {
+			isHot[i] = true;
+		}
+	}
+	for (std::size_t i = 0; i < alignmentAndSize.size(); ++i) {
+		if (!isHot[i]) {
+			cold[alignmentAndSize[i].first].emplace(alignmentAndSize[i].second, i + 2);
+		}
+	}
+	std::vector<flowflat::voffset_t> result(alignmentAndSize.size() + 2, flowflat::voffset_t(0));
+	result[0] = 2 * (result.size());
+	// order the elements by size, the cold ones follow the hot ones
+	place(cold, place(hot, 4, &result), &result);
 	return result;
 }
 #pragma clang diagnostic pop
 
-expression::Type::Type(std::string name) : name(std::move(name)) {}
+expression::Type::Type(Symbol name) : name(name) {}
 
 StaticContext::StaticContext(Compiler& compiler)
-  : compiler(compiler), currentFile(std::make_shared<expression::ExpressionTree>()) {}
+  : compiler(compiler), currentFile(std::make_shared<expression::ExpressionTree>(&compiler.arena)) {}
 
-boost::unordered_map<TypeName, SerializationInfo> StaticContext::serializationInformation(
-    std::string const& name) const {
+boost::unordered_map<TypeName, SerializationInfo> StaticContext::serializationInformation(Symbol name) const {
+	TimeReport::Scope scope(compiler.timeReport(), Phase::Layout);
 	auto t = resolve(name);
 	assertTrue(t);
 	boost::unordered_map<TypeName, SerializationInfo> result;
@@ -58,6 +98,24 @@ boost::unordered_map<TypeName, SerializationInfo> StaticContext::serializationIn
 	return result;
 }
 
+void StaticContext::serializationInformation(boost::unordered_map<TypeName, SerializationInfo>& state,
+                                             Symbol name) const {
+	TimeReport::Scope scope(compiler.timeReport(), Phase::Layout);
+	auto t = resolve(name);
+	assertTrue(t);
+	if (!state.contains(t->first)) {
+		serializationInformation(state, *t);
+	}
+}
+
+std::vector<std::pair<TypeName, SerializationInfo>> StaticContext::sortedSerializationInformation(
+    Symbol name) const {
+	auto serMap = serializationInformation(name);
+	std::vector<std::pair<TypeName, SerializationInfo>> result(serMap.begin(), serMap.end());
+	std::sort(result.begin(), result.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+	return result;
+}
+
 template <class Iter, class Fun>
 auto map(Iter first, Iter last, Fun f) -> std::vector<std::remove_cv_t<decltype(f(*first))>> {
 	std::vector<std::remove_cv_t<decltype(f(*first))>> res;
@@ -88,7 +146,7 @@ void StaticContext::serializationInformation(boost::unordered_map<TypeName, Seri
 		auto type = dynamic_cast<expression::Union const*>(t.second);
 		// first we need to make sure that type information for every possible type is available
 		for (auto const& typeName : type->types) {
-			auto child = *assertTrue(resolve(typeName));
+			auto child = *assertTrue(resolveInScope(typeName, t.first.path));
 			if (!state.contains(child.first)) {
 				serializationInformation(state, child);
 			}
@@ -105,11 +163,12 @@ void StaticContext::serializationInformation(boost::unordered_map<TypeName, Seri
 		unsigned alignment = 4;
 		// for tables, we need to store the alignment and the size of each object
 		std::vector<std::pair<unsigned, unsigned>> alignmentAndSize;
+		std::vector<uint64_t> heat;
 		bool hasDynamicSize = false;
 		std::vector<StaticContext::TypeDescr> fieldTypes;
 		fieldTypes.reserve(type->fields.size());
 		for (auto const& field : type->fields) {
-			auto fieldType = *assertTrue(resolve(field.type));
+			auto fieldType = *assertTrue(resolveInScope(field.type, t.first.path));
 			if (!state.contains(fieldType.first)) {
 				serializationInformation(state, fieldType);
 				assertTrue(state.contains(fieldType.first));
@@ -124,20 +183,27 @@ void StaticContext::serializationInformation(boost::unordered_map<TypeName, Seri
 				alignment = std::max(alignment, serInfo.alignment);
 			}
 			fieldTypes.push_back(std::move(fieldType));
+			heat.push_back(fieldHeat(t.first, field));
 		}
-		if (type->typeType() == expression::TypeType::Table) {
-			auto vtable = generateVTable(alignmentAndSize);
+		if (auto table = dynamic_cast<expression::Table const*>(type); table && !table->vtable.empty()) {
+			// loaded from a binary schema, which keeps the layout it was compiled with
+			state[t.first] = SerializationInfo{ .alignment = alignment,
+			                                    .staticSize = 4,
+			                                    .vtable = std::vector<flowflat::voffset_t>(table->vtable.begin(),
+			                                                                               table->vtable.end()) };
+		} else if (type->typeType() == expression::TypeType::Table) {
+			auto vtable = generateVTable(alignmentAndSize, heat);
 			flowflat::voffset_t maxOffset = 0;
-			int maxIndex = 0;
-			for (int i = 2; i < vtable.size(); ++i) {
+			std::size_t maxIndex = 0;
+			for (std::size_t i = 2; i < vtable.size(); ++i) {
 				if (vtable[i] > maxOffset) {
 					maxOffset = vtable[i];
 					maxIndex = i - 2;
 				}
 			}
 			assertTrue(maxIndex < fieldTypes.size());
-			auto lastElement = state[fieldTypes[maxIndex].first];
-			unsigned totalSize = maxOffset + lastElement.staticSize;
+			// the inline size of the last field (for vectors this is the reference, not the element)
+			unsigned totalSize = maxOffset + alignmentAndSize[maxIndex].second;
 			vtable[1] = totalSize;
 			state[t.first] = SerializationInfo{ .alignment = alignment, .staticSize = 4, .vtable = std::move(vtable) };
 		} else {
@@ -154,10 +220,26 @@ void StaticContext::serializationInformation(boost::unordered_map<TypeName, Seri
 }
 #pragma clang diagnostic pop
 
+uint64_t StaticContext::fieldHeat(TypeName const& table, expression::Field const& field) const {
+	if (field.hasMetadata(expression::MetadataType::hot)) {
+		return std::numeric_limits<uint64_t>::max();
+	}
+	if (compiler.layoutProfile.empty()) {
+		return 0;
+	}
+	auto name = fmt::format("{}.{}", table.name, field.name);
+	if (!table.path.empty()) {
+		name = fmt::format("{}.{}", fmt::join(table.path, "."), name);
+	}
+	auto iter = compiler.layoutProfile.find(name);
+	return iter == compiler.layoutProfile.end() ? 0 : iter->second;
+}
+
 std::optional<std::pair<TypeName, const expression::Type*>> StaticContext::resolve(TypeName const& name) const {
 	using Res = std::pair<TypeName, const expression::Type*>;
 	for (auto const& [_, tree] : compiler.files) {
-		if (tree->currentFile->namespacePath && *tree->currentFile->namespacePath == name.path) {
+		// files without a namespace declaration define types in the global namespace
+		if (tree->currentFile->namespacePath.value_or(std::vector<Symbol>()) == name.path) {
 			auto res = tree->currentFile->findType(name.name);
 			if (res) {
 				return Res(name, *res);
@@ -167,21 +249,40 @@ std::optional<std::pair<TypeName, const expression::Type*>> StaticContext::resol
 	return {};
 }
 
+std::optional<TypeName> StaticContext::splitQualifiedName(Symbol name) const {
+	TypeName res;
+	auto rest = name.view();
+	while (true) {
+		auto pos = rest.find('.');
+		// if one of the parts was never interned, no type with this name can exist
+		auto symbol = compiler.symbols.find(rest.substr(0, pos));
+		if (!symbol) {
+			return {};
+		}
+		if (pos == std::string_view::npos) {
+			res.name = *symbol;
+			return res;
+		}
+		res.path.push_back(*symbol);
+		rest.remove_prefix(pos + 1);
+	}
+}
+
 std::optional<std::pair<TypeName, const expression::Type*>> StaticContext::resolve(
-    const std::string& name,
+    Symbol name,
     bool excludeCurrent /* = false */) const {
 	using Res = std::pair<TypeName, const expression::Type*>;
 	if (auto iter = expression::primitiveTypes.find(name); iter != expression::primitiveTypes.end()) {
-		return Res(TypeName{ .name = name, .path = std::vector<std::string>() }, &iter->second);
+		return Res(TypeName{ .name = name, .path = std::vector<Symbol>() }, &iter->second);
 	}
-	if (name.find('.') == std::string::npos) {
+	if (name.view().find('.') == std::string_view::npos) {
 		// unqualified name -- check whether this is a "local" type (defined in current file
 		if (!excludeCurrent) {
 			auto res = currentFile->findType(name);
 			if (res) {
 				return Res(TypeName{ .name = name,
 				                     .path = currentFile->namespacePath ? currentFile->namespacePath.value()
-				                                                        : std::vector<std::string>() },
+				                                                        : std::vector<Symbol>() },
 				           *res);
 			}
 		}
@@ -191,35 +292,45 @@ std::optional<std::pair<TypeName, const expression::Type*>> StaticContext::resol
 		if (currentFile->namespacePath && !currentFile->namespacePath->empty()) {
 			// if a type of this name exists in the global namespace AND in the current namespace, we will return the
 			// one from the current namespace. So we have to check there first.
-			auto result =
-			    resolve(fmt::format("{}.{}", fmt::join(*currentFile->namespacePath, "."), name), excludeCurrent);
+			auto result = resolve(TypeName{ .name = name, .path = *currentFile->namespacePath });
 			if (result) {
 				return result;
 			}
-		} else {
-			// We checked the current namespace by calling ourselves recursively. So now we check whether we can find
-			// this type in the global namespace
-			for (auto const& [_, tree] : compiler.files) {
-				if (!tree->currentFile->namespacePath) {
-					auto res = tree->currentFile->findType(name);
-					if (res) {
-						return Res(TypeName{ .name = name }, *res);
-					}
+		}
+		// We checked the current namespace. So now we check whether we can find this type in the global namespace
+		for (auto const& [_, tree] : compiler.files) {
+			if (!tree->currentFile->namespacePath) {
+				auto res = tree->currentFile->findType(name);
+				if (res) {
+					return Res(TypeName{ .name = name }, *res);
 				}
 			}
 		}
-	} else {
+	} else if (auto t = splitQualifiedName(name)) {
 		// this is a qualified name, find files in that namespace and check each for this type
-		std::vector<std::string> parts;
-		boost::algorithm::split(parts, name, boost::is_any_of(","));
-		TypeName t{ .name = parts.back() };
-		parts.pop_back();
-		t.path = std::move(parts);
-		return resolve(t);
+		return resolve(*t);
 	}
 	return {};
 }
 
+std::optional<std::pair<TypeName, const expression::Type*>> StaticContext::resolveInScope(
+    Symbol name,
+    std::vector<Symbol> const& scope) const {
+	using Res = std::pair<TypeName, const expression::Type*>;
+	if (auto iter = expression::primitiveTypes.find(name); iter != expression::primitiveTypes.end()) {
+		return Res(TypeName{ .name = name, .path = std::vector<Symbol>() }, &iter->second);
+	}
+	if (name.view().find('.') != std::string_view::npos) {
+		return resolve(name);
+	}
+	if (!scope.empty()) {
+		if (auto res = resolve(TypeName{ .name = name, .path = scope })) {
+			return res;
+		}
+	}
+	return resolve(TypeName{ .name = name });
+}
+
 std::string multiplyChar(int lhs, char rhs) {
 	std::string res;
 	res.reserve(lhs);
@@ -242,18 +353,21 @@ std::string operator*(int x, std::string const& str) {
 	return x * std::string_view(str);
 }
 
-void StaticContext::describeTable(std::string const& name) const {
-	auto serMap = serializationInformation(name);
+void StaticContext::describeTable(Symbol name) const {
+	auto serInfos = sortedSerializationInformation(name);
 	boost::unordered_map<TypeName, int> vtableOffsets;
 	int curr = 4;
-	for (auto const& [typeName, serInfo] : serMap) {
-		if (serInfo.vtable->empty()) {
+	for (auto const& [typeName, serInfo] : serInfos) {
+		if (!serInfo.vtable) {
 			continue;
 		}
 		vtableOffsets[typeName] = curr;
 		curr += serInfo.vtable->size() * 2;
 	}
-	auto root = serMap[assertTrue(resolve(name))->first];
+	auto rootName = assertTrue(resolve(name))->first;
+	auto rootIter =
+	    std::find_if(serInfos.begin(), serInfos.end(), [&rootName](auto const& p) { return p.first == rootName; });
+	auto root = assertTrue(rootIter != serInfos.end()) ? rootIter->second : SerializationInfo();
 	if (root.alignment == 8) {
 		curr += 4; // we align to the element after the vtable offset
 	}
@@ -262,8 +376,8 @@ void StaticContext::describeTable(std::string const& name) const {
 	fmt::print("// Start of the buffer\n");
 	fmt::print("0: uint32_t {} // Offset to the root table\n", curr);
 	int printOffset = 4;
-	for (auto const& [typeName, serInfo] : serMap) {
-		if (serInfo.vtable->empty()) {
+	for (auto const& [typeName, serInfo] : serInfos) {
+		if (!serInfo.vtable) {
 			continue;
 		}
 		fmt::print("// vtable for {}.{}\n", fmt::join(typeName.path, "::"), typeName.name);
@@ -284,4 +398,38 @@ void StaticContext::describeTable(std::string const& name) const {
 		printOffset += padding;
 	}
 }
+
+Symbol StaticContext::intern(std::string_view str) const {
+	return compiler.symbols.intern(str);
+}
+
+std::vector<std::pair<TypeName, uint32_t>> StaticContext::identifiedRootTypes() const {
+	std::vector<std::pair<TypeName, uint32_t>> res;
+	std::vector<StaticContext const*> frontier{ this };
+	boost::unordered_set<StaticContext const*> visited{ this };
+	while (!frontier.empty()) {
+		auto context = frontier.back();
+		frontier.pop_back();
+		for (auto const& incl : context->includes) {
+			auto included = compiler.files.at(incl).get();
+			if (visited.insert(included).second) {
+				frontier.push_back(included);
+			}
+		}
+		auto const& file = *context->currentFile;
+		if (!file.fileIdentifier) {
+			continue;
+		}
+		uint32_t identifier = 0;
+		for (int i = 3; i >= 0; --i) {
+			identifier = identifier << 8 | uint8_t((*file.fileIdentifier)[i]);
+		}
+		for (auto root : file.rootTypes) {
+			res.emplace_back(TypeName{ .name = root, .path = file.namespacePath.value_or(std::vector<Symbol>()) },
+			                 identifier);
+		}
+	}
+	std::sort(res.begin(), res.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+	return res;
+}
 } // namespace flatbuffers
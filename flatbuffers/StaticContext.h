@@ -22,20 +22,42 @@ struct SerializationInfo {
 class StaticContext {
 	using TypeDescr = std::pair<TypeName, expression::Type const*>;
 	void serializationInformation(boost::unordered_map<TypeName, SerializationInfo>& state, TypeDescr const& t) const;
+	// how often a field of a table is accessed according to the layout profile, the maximum for hot fields
+	[[nodiscard]] uint64_t fieldHeat(TypeName const& table, expression::Field const& field) const;
 
 public:
 	Compiler& compiler;
 	std::shared_ptr<expression::ExpressionTree> currentFile;
+	// canonical paths of the files included by currentFile (in declaration order)
+	std::vector<boost::filesystem::path> includes;
+	// only used if this file gets compiled
+	GeneratorOptions options;
 
 	explicit StaticContext(Compiler& compiler);
 
-	[[nodiscard]] boost::unordered_map<TypeName, SerializationInfo> serializationInformation(
-	    std::string const& name) const;
+	[[nodiscard]] boost::unordered_map<TypeName, SerializationInfo> serializationInformation(Symbol name) const;
+	// adds name and every type it depends on to state, types which are already in state are not computed again
+	void serializationInformation(boost::unordered_map<TypeName, SerializationInfo>& state, Symbol name) const;
+	// same as above, but ordered by type name. Use this whenever the result influences generated output.
+	[[nodiscard]] std::vector<std::pair<TypeName, SerializationInfo>> sortedSerializationInformation(
+	    Symbol name) const;
 	[[nodiscard]] std::optional<std::pair<TypeName, expression::Type const*>> resolve(TypeName const& name) const;
 	[[nodiscard]] std::optional<std::pair<TypeName, expression::Type const*>> resolve(
-	    const std::string& name,
+	    Symbol name,
 	    bool excludeCurrent = false) const;
-	void describeTable(std::string const& name) const;
+	// splits A.B.C into path and name, returns nothing if no type with this name can exist
+	[[nodiscard]] std::optional<TypeName> splitQualifiedName(Symbol name) const;
+	// resolves a type name that was used in a type which is defined in the namespace scope (this might be a type
+	// defined in an included file)
+	[[nodiscard]] std::optional<std::pair<TypeName, expression::Type const*>> resolveInScope(
+	    Symbol name,
+	    std::vector<Symbol> const& scope) const;
+	void describeTable(Symbol name) const;
+	// the root types of currentFile and of all files it (transitively) includes which have a file identifier, ordered
+	// by type name. The identifiers are little endian integers of the 4 identifier bytes.
+	[[nodiscard]] std::vector<std::pair<TypeName, uint32_t>> identifiedRootTypes() const;
+	// interns a name into the symbols of the compilation
+	[[nodiscard]] Symbol intern(std::string_view str) const;
 };
 
 } // namespace flatbuffers
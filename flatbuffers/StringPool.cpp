@@ -0,0 +1,89 @@
+#include <cstring>
+#include <new>
+
+#include "StringPool.h"
+#include "Error.h"
+
+namespace flatbuffers {
+
+using namespace std::string_view_literals;
+
+std::string_view const Symbol::emptyEntry;
+
+namespace {
+
+// every name the compiler refers to directly -- these must be identical in all pools
+constexpr std::string_view builtinNames[] = {
+	"bool"sv,   "byte"sv,  "ubyte"sv,  "short"sv, "ushort"sv, "int"sv,     "uint"sv,   "float"sv,
+	"long"sv,   "ulong"sv, "double"sv, "int8"sv,  "uint8"sv,  "int16"sv,   "uint16"sv, "int32"sv,
+	"uint32"sv, "int64"sv, "uint64"sv, "float32"sv, "float64"sv, "string"sv,
+};
+
+} // namespace
+
+StringPool::StringPool(BuiltinTag) : builtin(nullptr) {
+	for (auto name : builtinNames) {
+		insert(name);
+	}
+}
+
+StringPool::StringPool() : builtin(&builtins()) {}
+
+Symbol StringPool::insert(std::string_view str) {
+	auto chars = static_cast<char*>(arena.allocate(str.size() + 1, 1));
+	std::memcpy(chars, str.data(), str.size());
+	chars[str.size()] = '\0';
+	auto entry = new (arena.allocate(sizeof(std::string_view), alignof(std::string_view)))
+	    std::string_view(chars, str.size());
+	index.emplace(*entry, entry);
+	return Symbol(entry);
+}
+
+Symbol StringPool::intern(std::string_view str) {
+	if (str.empty()) {
+		return Symbol();
+	}
+	// the builtin pool is immutable after construction, so we don't need to lock it
+	if (builtin) {
+		if (auto iter = builtin->index.find(str); iter != builtin->index.end()) {
+			return Symbol(iter->second);
+		}
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	if (auto iter = index.find(str); iter != index.end()) {
+		return Symbol(iter->second);
+	}
+	return insert(str);
+}
+
+std::optional<Symbol> StringPool::find(std::string_view str) const {
+	if (str.empty()) {
+		return Symbol();
+	}
+	if (builtin) {
+		if (auto res = builtin->find(str)) {
+			return res;
+		}
+	}
+	std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+	if (builtin) {
+		lock.lock();
+	}
+	if (auto iter = index.find(str); iter != index.end()) {
+		return Symbol(iter->second);
+	}
+	return {};
+}
+
+StringPool const& StringPool::builtins() {
+	static StringPool pool{ BuiltinTag{} };
+	return pool;
+}
+
+Symbol StringPool::builtinSymbol(std::string_view str) {
+	auto res = builtins().find(str);
+	assertTrue(res.has_value());
+	return *res;
+}
+
+} // namespace flatbuffers
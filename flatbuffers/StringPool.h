@@ -0,0 +1,79 @@
+#ifndef FLATBUFFER_STRINGPOOL_H
+#define FLATBUFFER_STRINGPOOL_H
+#include <string_view>
+#include <string>
+#include <optional>
+#include <mutex>
+#include <memory_resource>
+
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#include <fmt/format.h>
+
+namespace flatbuffers {
+
+// An interned string. Symbols of the same pool are equal if and only if they point to the same entry, so comparing and
+// hashing them is a pointer operation. Ordering is lexicographic, so sorting symbols stays deterministic.
+class Symbol {
+	static std::string_view const emptyEntry;
+	std::string_view const* entry = &emptyEntry;
+
+	friend class StringPool;
+	explicit Symbol(std::string_view const* entry) : entry(entry) {}
+
+public:
+	Symbol() = default;
+
+	[[nodiscard]] std::string_view view() const { return *entry; }
+	[[nodiscard]] std::string str() const { return std::string(*entry); }
+	[[nodiscard]] bool empty() const { return entry->empty(); }
+	[[nodiscard]] std::size_t size() const { return entry->size(); }
+
+	[[nodiscard]] bool operator==(Symbol rhs) const { return entry == rhs.entry; }
+	[[nodiscard]] bool operator!=(Symbol rhs) const { return entry != rhs.entry; }
+	[[nodiscard]] bool operator<(Symbol rhs) const { return *entry < *rhs.entry; }
+
+	friend std::size_t hash_value(Symbol s) { return boost::hash<void const*>()(s.entry); }
+};
+
+// Interns strings for one compilation. The strings live in an arena and are freed all at once when the pool is
+// destroyed. Interning is thread safe, as files get parsed concurrently.
+//
+// Names known to the compiler (the primitive types) are interned in a builtin pool which every pool consults first,
+// so for example "int" maps to the same symbol in all pools.
+class StringPool {
+	struct BuiltinTag {};
+	mutable std::mutex mutex;
+	std::pmr::monotonic_buffer_resource arena;
+	// keys point into the arena
+	boost::unordered_map<std::string_view, std::string_view const*> index;
+	StringPool const* builtin;
+
+	explicit StringPool(BuiltinTag);
+	Symbol insert(std::string_view str);
+
+public:
+	StringPool();
+	StringPool(StringPool const&) = delete;
+	StringPool& operator=(StringPool const&) = delete;
+
+	Symbol intern(std::string_view str);
+	// returns the symbol if str was interned before -- this never allocates
+	[[nodiscard]] std::optional<Symbol> find(std::string_view str) const;
+
+	static StringPool const& builtins();
+	// only valid for builtin names, throws InternalError otherwise
+	static Symbol builtinSymbol(std::string_view str);
+};
+
+} // namespace flatbuffers
+
+template <>
+struct fmt::formatter<flatbuffers::Symbol> : fmt::formatter<std::string_view> {
+	template <class FormatContext>
+	auto format(flatbuffers::Symbol s, FormatContext& ctx) const {
+		return fmt::formatter<std::string_view>::format(s.view(), ctx);
+	}
+};
+
+#endif // FLATBUFFER_STRINGPOOL_H
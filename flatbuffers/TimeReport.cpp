@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <ctime>
+#include <iterator>
+
+#include <fmt/format.h>
+
+#include "TimeReport.h"
+
+namespace flatbuffers {
+
+thread_local std::size_t threadAllocations = 0;
+
+namespace {
+
+// the innermost open scope of this thread
+thread_local TimeReport::Scope* innermost = nullptr;
+
+double threadCpuSeconds() {
+	timespec ts{};
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return double(ts.tv_sec) + double(ts.tv_nsec) * 1e-9;
+}
+
+std::string jsonString(std::string_view str) {
+	std::string res = "\"";
+	for (auto c : str) {
+		if (c == '"' || c == '\\') {
+			res += '\\';
+			res += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			fmt::format_to(std::back_inserter(res), "\\u{:04x}", unsigned(c));
+		} else {
+			res += c;
+		}
+	}
+	res += '"';
+	return res;
+}
+
+// the count is left out if it is 0
+void printMeasurement(std::ostream& out, std::string_view name, TimeReport::Measurement const& m) {
+	out << fmt::format("  {:<10} {:>12.3f} ms wall {:>12.3f} ms cpu {:>12} allocations",
+	                   name,
+	                   m.wall * 1e3,
+	                   m.cpu * 1e3,
+	                   m.allocations);
+	out << (m.count ? fmt::format(" {:>8}x\n", m.count) : "\n");
+}
+
+void printPhases(std::ostream& out, std::map<Phase, TimeReport::Measurement> const& phases) {
+	TimeReport::Measurement total;
+	for (auto const& [phase, m] : phases) {
+		printMeasurement(out, phaseName(phase), m);
+		total += m;
+	}
+	total.count = 0;
+	printMeasurement(out, "total", total);
+}
+
+} // namespace
+
+std::string_view phaseName(Phase phase) {
+	switch (phase) {
+	case Phase::Parse:
+		return "parse";
+	case Phase::Resolve:
+		return "resolve";
+	case Phase::Verify:
+		return "verify";
+	case Phase::Layout:
+		return "layout";
+	case Phase::Emit:
+		return "emit";
+	}
+	return "unknown";
+}
+
+TimeReport::Measurement& TimeReport::Measurement::operator+=(Measurement const& rhs) {
+	wall += rhs.wall;
+	cpu += rhs.cpu;
+	allocations += rhs.allocations;
+	count += rhs.count;
+	return *this;
+}
+
+TimeReport::Scope::Scope(TimeReport& report, Phase phase, std::string_view file) : phase(phase) {
+	if (!report.enabled) {
+		return;
+	}
+	this->report = &report;
+	parent = innermost;
+	innermost = this;
+	if (!file.empty() || !parent) {
+		this->file = report.intern(file);
+	} else {
+		this->file = parent->file;
+	}
+	allocationsStart = threadAllocations;
+	cpuStart = threadCpuSeconds();
+	wallStart = std::chrono::steady_clock::now();
+}
+
+TimeReport::Scope::~Scope() {
+	if (!report) {
+		return;
+	}
+	auto wallEnd = std::chrono::steady_clock::now();
+	Measurement inclusive;
+	inclusive.wall = std::chrono::duration<double>(wallEnd - wallStart).count();
+	inclusive.cpu = threadCpuSeconds() - cpuStart;
+	inclusive.allocations = threadAllocations - allocationsStart;
+	innermost = parent;
+	if (parent) {
+		parent->nested += inclusive;
+	}
+	Measurement self;
+	self.wall = std::max(0.0, inclusive.wall - nested.wall);
+	self.cpu = std::max(0.0, inclusive.cpu - nested.cpu);
+	self.allocations = inclusive.allocations - std::min(inclusive.allocations, nested.allocations);
+	self.count = 1;
+	report->record(Event{ .phase = phase,
+	                      .file = file,
+	                      .thread = 0,
+	                      .start = std::chrono::duration<double>(wallStart - report->started).count(),
+	                      .duration = inclusive.wall,
+	                      .self = self });
+}
+
+TimeReport::TimeReport() : started(std::chrono::steady_clock::now()) {}
+
+void TimeReport::enable() {
+	enabled = true;
+	started = std::chrono::steady_clock::now();
+}
+
+std::size_t TimeReport::intern(std::string_view file) {
+	std::lock_guard lock(mutex);
+	auto [iter, inserted] = fileIndex.emplace(std::string(file), files.size());
+	if (inserted) {
+		files.emplace_back(file);
+	}
+	return iter->second;
+}
+
+void TimeReport::record(Event event) {
+	std::lock_guard lock(mutex);
+	event.thread = threads.emplace(std::this_thread::get_id(), unsigned(threads.size())).first->second;
+	events.push_back(event);
+}
+
+std::map<Phase, TimeReport::Measurement> TimeReport::totals() const {
+	std::lock_guard lock(mutex);
+	std::map<Phase, Measurement> res;
+	for (auto const& e : events) {
+		res[e.phase] += e.self;
+	}
+	return res;
+}
+
+std::map<std::string, std::map<Phase, TimeReport::Measurement>> TimeReport::perFile() const {
+	std::lock_guard lock(mutex);
+	std::map<std::string, std::map<Phase, Measurement>> res;
+	for (auto const& e : events) {
+		res[files[e.file]][e.phase] += e.self;
+	}
+	return res;
+}
+
+void TimeReport::printSummary(std::ostream& out) const {
+	auto byFile = perFile();
+	std::vector<std::pair<double, std::string const*>> order;
+	for (auto const& [file, phases] : byFile) {
+		double wall = 0;
+		for (auto const& [_, m] : phases) {
+			wall += m.wall;
+		}
+		order.emplace_back(wall, &file);
+	}
+	std::sort(order.begin(), order.end(), [](auto const& lhs, auto const& rhs) { return lhs.first > rhs.first; });
+	out << "Time report\n";
+	out << "================================================\n";
+	for (auto const& [_, file] : order) {
+		out << (file->empty() ? std::string("<not attributed to a file>") : *file) << ":\n";
+		printPhases(out, byFile[*file]);
+	}
+	out << "------------------------------------------------\n";
+	out << fmt::format("All files ({}):\n", std::count_if(order.begin(), order.end(), [](auto const& f) {
+		                   return !f.second->empty();
+	                   }));
+	printPhases(out, totals());
+}
+
+void TimeReport::writeTrace(std::ostream& out) const {
+	std::lock_guard lock(mutex);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (auto const& e : events) {
+		out << (first ? "\n" : ",\n");
+		first = false;
+		out << fmt::format("{{\"name\":\"{}\",\"cat\":\"flowflatc\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},"
+		                   "\"dur\":{:.3f},\"args\":{{\"file\":{},\"self_us\":{:.3f},\"cpu_us\":{:.3f},"
+		                   "\"allocations\":{}}}}}",
+		                   phaseName(e.phase),
+		                   e.thread,
+		                   e.start * 1e6,
+		                   e.duration * 1e6,
+		                   jsonString(files[e.file]),
+		                   e.self.wall * 1e6,
+		                   e.self.cpu * 1e6,
+		                   e.self.allocations);
+	}
+	out << "\n]}\n";
+}
+
+} // namespace flatbuffers
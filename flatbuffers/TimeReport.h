@@ -0,0 +1,107 @@
+#ifndef FLATBUFFER_TIMEREPORT_H
+#define FLATBUFFER_TIMEREPORT_H
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+namespace flatbuffers {
+
+// The number of allocations of the calling thread. Programs which want allocation counts in time reports replace
+// operator new and increment this (flowflatc does), otherwise it stays 0.
+extern thread_local std::size_t threadAllocations;
+
+enum class Phase { Parse, Resolve, Verify, Layout, Emit };
+
+[[nodiscard]] std::string_view phaseName(Phase phase);
+
+/*
+ * Records where the compiler spends its time (flowflatc --time-report and --time-trace). Every phase of a file is
+ * measured by a Scope: wall time, CPU time of the thread and the number of allocations. Scopes nest (layout is computed
+ * while code is emitted), but a phase is only charged for the time which wasn't spent in nested scopes, so the phases
+ * of a file add up to the time spent on it.
+ *
+ * Scopes of a disabled report (the default) don't read any clocks. Scopes can be opened concurrently by multiple
+ * threads.
+ */
+class TimeReport {
+public:
+	struct Measurement {
+		// seconds
+		double wall = 0;
+		double cpu = 0;
+		std::size_t allocations = 0;
+		// how often the phase was entered
+		std::size_t count = 0;
+
+		Measurement& operator+=(Measurement const& rhs);
+	};
+
+	class Scope {
+		TimeReport* report = nullptr;
+		Scope* parent = nullptr;
+		Phase phase;
+		std::size_t file = 0;
+		std::chrono::steady_clock::time_point wallStart;
+		double cpuStart = 0;
+		std::size_t allocationsStart = 0;
+		// what nested scopes measured
+		Measurement nested;
+
+	public:
+		// a scope without a file belongs to the file of the enclosing scope on this thread
+		Scope(TimeReport& report, Phase phase, std::string_view file = {});
+		Scope(Scope const&) = delete;
+		Scope& operator=(Scope const&) = delete;
+		~Scope();
+	};
+
+private:
+	struct Event {
+		Phase phase;
+		std::size_t file;
+		unsigned thread;
+		// relative to the start of the report
+		double start;
+		double duration;
+		// without nested scopes
+		Measurement self;
+	};
+
+	bool enabled = false;
+	std::chrono::steady_clock::time_point started;
+	mutable std::mutex mutex;
+	std::vector<std::string> files;
+	boost::unordered_map<std::string, std::size_t> fileIndex;
+	std::map<std::thread::id, unsigned> threads;
+	std::vector<Event> events;
+
+	std::size_t intern(std::string_view file);
+	void record(Event event);
+
+public:
+	TimeReport();
+
+	void enable();
+	[[nodiscard]] bool isEnabled() const { return enabled; }
+
+	// the phases of all files
+	[[nodiscard]] std::map<Phase, Measurement> totals() const;
+	// what every file spent in every phase. Time which wasn't spent on a file (e.g. layouts computed while describing
+	// tables) is reported with an empty file name.
+	[[nodiscard]] std::map<std::string, std::map<Phase, Measurement>> perFile() const;
+	// human readable, files are ordered by the time spent on them (slowest first)
+	void printSummary(std::ostream& out) const;
+	// every scope as a complete event in the Chrome trace event format (chrome://tracing, Perfetto)
+	void writeTrace(std::ostream& out) const;
+};
+
+} // namespace flatbuffers
+#endif // FLATBUFFER_TIMEREPORT_H
@@ -4,10 +4,16 @@
 #include "flowflat/flowflat.h"
 
 #include <cassert>
+#include <stdexcept>
 
 flowflat::Writer::~Writer() = default;
 
+void flowflat::Writer::gather(GatheredPayload const*, std::size_t) {
+	throw std::logic_error("writer doesn't support scatter-gather");
+}
+
 char* flowflat::NewWriter::allocateBuffer(int bytes) {
 	buffer.reset(new char[bytes]);
+	bufferSize = bytes;
 	return buffer.get();
 }
@@ -0,0 +1,42 @@
+#include "flowflat/gather.h"
+
+namespace flowflat {
+
+char* GatherWriter::allocateBuffer(int bytes) {
+	if (std::size_t(bytes) > bufferSize) {
+		buffer.reset(new char[bytes]);
+		bufferSize = bytes;
+	}
+	totalSize = bytes;
+	segments.clear();
+	segments.push_back(iovec{ buffer.get(), std::size_t(bytes) });
+	return buffer.get();
+}
+
+void GatherWriter::gather(GatheredPayload const* payloads, std::size_t count) {
+	// split the written memory at the (buffer) positions of the payloads
+	segments.clear();
+	std::size_t written = 0;
+	std::size_t skipped = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		auto const& payload = payloads[i];
+		auto end = payload.position - skipped;
+		segments.push_back(iovec{ buffer.get() + written, end - written });
+		segments.push_back(iovec{ const_cast<char*>(payload.data), payload.size });
+		written = end;
+		skipped += payload.size;
+	}
+	segments.push_back(iovec{ buffer.get() + written, totalSize - written });
+	totalSize += skipped;
+}
+
+std::string GatherWriter::flatten() const {
+	std::string res;
+	res.reserve(totalSize);
+	for (auto const& segment : segments) {
+		res.append(static_cast<char const*>(segment.iov_base), segment.iov_len);
+	}
+	return res;
+}
+
+} // namespace flowflat
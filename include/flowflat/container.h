@@ -0,0 +1,126 @@
+#ifndef FLATBUFFER_FLOWFLAT_CONTAINER_H
+#define FLATBUFFER_FLOWFLAT_CONTAINER_H
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "flowflat.h"
+
+/*
+ * Container files store many buffers in one file. Readers map the file, so a record is accessed in place: opening a
+ * container reads the trailer, looking up a record is one load from the index.
+ *
+ * Layout (all integers are little endian):
+ *
+ *   Header   uint32_t magic ("FFCF"), uint32_t version, uint32_t flags, uint32_t reserved
+ *   Records  uint32_t size, uint32_t checksum (CRC-32C of the buffer, 0 if the container has no checksums), followed
+ *            by the buffer. Records start at a multiple of 8, so buffers are 8-byte aligned like any other buffer.
+ *   Index    uint64_t position of every record (in append order)
+ *   Trailer  uint64_t position of the index, uint64_t number of records, uint32_t flags, uint32_t magic ("FFCI")
+ *
+ * The index and the trailer are written when the writer is closed. A container which was not closed (the writing
+ * process died) can't be opened.
+ */
+namespace flowflat::container {
+
+constexpr uint32_t magic = 0x46434646; // "FFCF"
+constexpr uint32_t indexMagic = 0x49434646; // "FFCI"
+constexpr uint32_t version = 1;
+constexpr uint32_t checksumFlag = 1;
+
+constexpr std::size_t headerSize = 16;
+constexpr std::size_t recordHeaderSize = 8;
+constexpr std::size_t trailerSize = 24;
+constexpr std::size_t recordAlignment = 8;
+
+// CRC-32C (Castagnoli)
+[[nodiscard]] uint32_t crc32c(char const* data, std::size_t size);
+
+/*
+ * Appends records to a container. Every buffer a generated write() allocates from this writer becomes a record and is
+ * serialized directly into the mapped file:
+ *
+ *   flowflat::container::Writer out("messages.ffc");
+ *   for (auto const& m : messages) {
+ *       m.write(out);
+ *   }
+ *   out.close();
+ *
+ * A buffer is only valid until the next one is allocated (the mapping may move when the file grows). Opening an
+ * existing container appends to it.
+ */
+class Writer : public flowflat::Writer {
+	int fd = -1;
+	char* mapping = nullptr;
+	std::size_t capacity = 0;
+	// the end of the last record
+	std::size_t used = headerSize;
+	// the position of the last record if its checksum wasn't computed yet
+	std::optional<std::size_t> unsealed;
+	bool checksums = false;
+	std::vector<uint64_t> index;
+
+	// makes sure the mapping covers at least size bytes
+	void reserve(std::size_t size);
+	void seal();
+
+public:
+	// throws std::runtime_error if the file can't be opened or is not a container. checksums is ignored when
+	// appending to an existing container.
+	explicit Writer(char const* path, bool checksums = false);
+	Writer(Writer const&) = delete;
+	Writer& operator=(Writer const&) = delete;
+	// closes the container, but ignores errors
+	~Writer() override;
+
+	char* allocateBuffer(int bytes) override;
+	// writes the index and the trailer and releases the file. Throws std::runtime_error if the file can't be written.
+	void close();
+
+	[[nodiscard]] std::size_t size() const { return index.size(); }
+};
+
+// A read-only mapping of a container
+class Reader {
+	void* mapping = nullptr;
+	std::size_t length = 0;
+	char const* index = nullptr;
+	std::size_t count = 0;
+	std::size_t indexPosition = 0;
+	bool checksums = false;
+
+public:
+	// throws std::runtime_error if the file can't be mapped or is not a closed container
+	explicit Reader(char const* path);
+	Reader(Reader const&) = delete;
+	Reader& operator=(Reader const&) = delete;
+	~Reader();
+
+	[[nodiscard]] std::size_t size() const { return count; }
+	[[nodiscard]] bool hasChecksums() const { return checksums; }
+	// the buffer of the i-th record (i < size()). Throws std::runtime_error if the index points outside of the
+	// records. The buffer itself is not verified.
+	[[nodiscard]] std::string_view record(std::size_t i) const;
+	// checks the checksum of the i-th record, always true if the container has no checksums
+	[[nodiscard]] bool checksumMatches(std::size_t i) const;
+	// the root table of the i-th record without copying it, T is a generated table
+	template <class T>
+	[[nodiscard]] typename T::View view(std::size_t i) const {
+		return T::view(record(i).data());
+	}
+	// the root table of the i-th record or nothing if it is not a valid T (or its checksum doesn't match)
+	template <class T>
+	[[nodiscard]] std::optional<typename T::View> verifiedView(std::size_t i) const {
+		auto buffer = record(i);
+		if (!checksumMatches(i) || !T::verify(buffer.data(), buffer.size())) {
+			return {};
+		}
+		return T::view(buffer.data());
+	}
+};
+
+} // namespace flowflat::container
+
+#endif // FLATBUFFER_FLOWFLAT_CONTAINER_H
@@ -6,7 +6,14 @@
 #define FLATBUFFER_FLOWFLAT_H
 #include <string_view>
 #include <string>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
 namespace flowflat {
 
@@ -16,18 +23,174 @@ using uoffset_t = uint32_t;
 using soffset_t = int32_t;
 using voffset_t = int16_t;
 
+// the largest alignment of any type in a buffer
+constexpr std::size_t maxAlignment = 8;
+
+/*
+ * Wire format
+ *
+ * A buffer starts with a uoffset_t which is the position of the root table. All integers are stored little endian.
+ *
+ *  - tables start with a soffset_t. The vtable of the table starts at (table - soffset). The vtable is an array of
+ *    voffset_t: [size of the vtable in bytes, size of the inline data of the table, offset of field 0, offset of
+ *    field 1, ...]. Field offsets are relative to the start of the table. A field is absent if its offset is 0 or if
+ *    the vtable is too short to contain it (this happens when the buffer was written with an older schema).
+ *  - scalars, enums and structs are stored inline.
+ *  - strings, vectors and tables are stored as a uoffset_t which is relative to the position of the uoffset_t itself.
+ *    Offsets always point forward. An offset of 0 is a null reference (the field is absent).
+ *  - strings are a uint32_t length followed by the bytes and a terminating 0.
+ *  - vectors are a uint32_t element count followed by the elements. Elements are stored the same way as fields.
+ *  - unions are stored as a uint32_t tag (0 if the union is empty, i+1 if it holds the i-th type of the union)
+ *    followed by a uoffset_t to the table (relative to the position of the uoffset_t).
+ *
+ * Framing
+ *
+ *  - buffers of root types whose schema declares a file_identifier store the 4 identifier bytes right after the root
+ *    reference (at offset 4).
+ *  - size prefixed buffers start with a uint32_t which holds the size of the rest of the buffer. The buffer itself
+ *    (the root reference) follows the prefix. Alignment is relative to the start of the prefix.
+ *
+ * Generated code writes every object before the objects it references (see stream.h).
+ */
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "flowflat only supports little endian machines");
+
+// loads a value from a possibly unaligned address
+template <class T>
+[[nodiscard]] inline T load(char const* p) {
+	T res;
+	std::memcpy(&res, p, sizeof(T));
+	return res;
+}
+
+// stores a value at a possibly unaligned address
+template <class T>
+inline void store(char* p, T value) {
+	std::memcpy(p, &value, sizeof(T));
+}
+
+// follows the uoffset_t stored at p
+[[nodiscard]] inline char const* follow(char const* p) {
+	return p + load<uoffset_t>(p);
+}
+
+// follows the uoffset_t stored at p, returns nullptr for null references
+[[nodiscard]] inline char const* followOrNull(char const* p) {
+	auto offset = load<uoffset_t>(p);
+	return offset ? p + offset : nullptr;
+}
+
+[[nodiscard]] inline char const* rootTable(char const* buffer) {
+	return follow(buffer);
+}
+
+// a file identifier as it is compared by generated code, e.g. identifier("MONI")
+[[nodiscard]] constexpr uint32_t identifier(char const (&id)[5]) {
+	return uint32_t(uint8_t(id[0])) | uint32_t(uint8_t(id[1])) << 8 | uint32_t(uint8_t(id[2])) << 16 |
+	       uint32_t(uint8_t(id[3])) << 24;
+}
+
+// the file identifier of a buffer, only meaningful if the buffer has one
+[[nodiscard]] inline uint32_t bufferIdentifier(char const* buffer) {
+	return load<uint32_t>(buffer + sizeof(uoffset_t));
+}
+
+// the size of a size prefixed buffer without the prefix
+[[nodiscard]] inline uint32_t sizePrefix(char const* frame) {
+	return load<uint32_t>(frame);
+}
+
+// the buffer of a size prefixed buffer
+[[nodiscard]] inline char const* skipSizePrefix(char const* frame) {
+	return frame + sizeof(uint32_t);
+}
+
+// how a buffer is framed
+struct Framing {
+	std::optional<uint32_t> identifier;
+	bool sizePrefixed = false;
+};
+
+[[nodiscard]] inline char const* vtableOf(char const* table) {
+	return table - load<soffset_t>(table);
+}
+
+// the position of the offset of the field with the given index within a vtable
+[[nodiscard]] constexpr voffset_t vtableSlot(unsigned fieldIndex) {
+	return voffset_t((2 + fieldIndex) * sizeof(voffset_t));
+}
+
+// the offset of a field relative to the table start or 0 if the field is absent
+[[nodiscard]] inline voffset_t fieldOffset(char const* table, voffset_t slot) {
+	auto vtable = vtableOf(table);
+	return slot < load<voffset_t>(vtable) ? load<voffset_t>(vtable + slot) : voffset_t(0);
+}
+
+// p points to the length of the string
+[[nodiscard]] inline std::string_view loadString(char const* p) {
+	return std::string_view(p + sizeof(uint32_t), load<uint32_t>(p));
+}
+
+// copies or moves a variant of generated tables (a native union) and constructs the new member with alloc
+template <class Variant, class Allocator>
+[[nodiscard]] std::decay_t<Variant> withAllocator(Variant&& v, Allocator const& alloc) {
+	using Result = std::decay_t<Variant>;
+	if (v.valueless_by_exception()) {
+		return Result();
+	}
+	return std::visit(
+	    [&alloc](auto&& member) {
+		    using Member = std::decay_t<decltype(member)>;
+		    return Result(std::in_place_type<Member>, std::forward<decltype(member)>(member), alloc);
+	    },
+	    std::forward<Variant>(v));
+}
+
+// a string or vector payload which a scatter-gather writer references instead of copying it into the buffer
+struct GatheredPayload {
+	// the position of the payload in the serialized buffer
+	std::size_t position;
+	char const* data;
+	std::size_t size;
+};
+
 struct Writer {
 	virtual ~Writer();
-	// will be called exactly once
+	// will be called exactly once for every serialized buffer. For scatter-gather writers bytes doesn't include the
+	// gathered payloads.
 	virtual char* allocateBuffer(int bytes) = 0;
+	// strings and vectors of scalars of at least this many bytes are passed to gather instead of being copied
+	[[nodiscard]] virtual std::size_t gatherThreshold() const { return std::numeric_limits<std::size_t>::max(); }
+	// called after the buffer was written if payloads were left out of it (ordered by position)
+	virtual void gather(GatheredPayload const* payloads, std::size_t count);
+	// the number of threads which serialize large vectors of tables
+	[[nodiscard]] virtual unsigned serializationThreads() const { return 1; }
 };
 
 // a writer using new and delete
-class NewWriter : Writer {
+class NewWriter : public Writer {
 	std::unique_ptr<char[]> buffer;
+	int bufferSize = 0;
 
 public:
 	char* allocateBuffer(int bytes) override;
+
+	[[nodiscard]] char const* data() const { return buffer.get(); }
+	[[nodiscard]] int size() const { return bufferSize; }
+};
+
+// serializes into the buffer of another writer using multiple threads. The buffer is the same as with one thread.
+// Buffers for scatter-gather writers are serialized sequentially.
+class ParallelWriter : public Writer {
+	Writer& out;
+	unsigned threads;
+
+public:
+	ParallelWriter(Writer& out, unsigned threads) : out(out), threads(threads) {}
+
+	char* allocateBuffer(int bytes) override { return out.allocateBuffer(bytes); }
+	[[nodiscard]] std::size_t gatherThreshold() const override { return out.gatherThreshold(); }
+	void gather(GatheredPayload const* payloads, std::size_t count) override { out.gather(payloads, count); }
+	[[nodiscard]] unsigned serializationThreads() const override { return threads; }
 };
 
 } // namespace flowflat
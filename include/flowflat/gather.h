@@ -0,0 +1,51 @@
+#ifndef FLATBUFFER_FLOWFLAT_GATHER_H
+#define FLATBUFFER_FLOWFLAT_GATHER_H
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "flowflat.h"
+
+namespace flowflat {
+
+/*
+ * A scatter-gather writer: strings and vectors of scalars of at least `threshold` bytes are referenced in place instead
+ * of being copied, only the rest of the buffer (vtables, tables, offsets, lengths and small payloads) is written into
+ * memory owned by the writer. The buffer is then described by iovecs, which can be passed to writev or sendmsg
+ * directly:
+ *
+ *   flowflat::GatherWriter w;
+ *   message.write(w);
+ *   ::writev(fd, w.iovecs().data(), int(w.iovecs().size()));
+ *
+ * The referenced payloads belong to the serialized object, so it must not be modified or destroyed until the iovecs
+ * were sent. A buffer with n gathered payloads needs up to 2n + 1 iovecs, callers have to respect IOV_MAX.
+ */
+class GatherWriter : public Writer {
+	std::size_t threshold;
+	std::unique_ptr<char[]> buffer;
+	std::size_t bufferSize = 0;
+	std::size_t totalSize = 0;
+	std::vector<iovec> segments;
+
+public:
+	explicit GatherWriter(std::size_t threshold = 4096) : threshold(threshold) {}
+
+	char* allocateBuffer(int bytes) override;
+	[[nodiscard]] std::size_t gatherThreshold() const override { return threshold; }
+	void gather(GatheredPayload const* payloads, std::size_t count) override;
+
+	// the serialized buffer in order
+	[[nodiscard]] std::vector<iovec> const& iovecs() const { return segments; }
+	// the size of the serialized buffer (including the gathered payloads)
+	[[nodiscard]] std::size_t size() const { return totalSize; }
+	// copies the serialized buffer into contiguous memory
+	[[nodiscard]] std::string flatten() const;
+};
+
+} // namespace flowflat
+
+#endif // FLATBUFFER_FLOWFLAT_GATHER_H
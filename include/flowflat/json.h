@@ -0,0 +1,44 @@
+#ifndef FLATBUFFER_FLOWFLAT_JSON_H
+#define FLATBUFFER_FLOWFLAT_JSON_H
+#include <string_view>
+#include <string>
+#include <stdexcept>
+
+#include "reflection.h"
+
+/*
+ * Schema driven conversion between JSON and the binary format. Neither direction builds a document tree: JSON is
+ * parsed straight into the output buffer (after a scan which counts the elements of every array) and buffers are
+ * written straight into JSON text. Numbers are read and written independent of the locale.
+ *
+ * The JSON representation follows flatc:
+ *  - tables and structs are objects, vectors are arrays
+ *  - enums are written as the name of the enumerator and can be read either by name or by value
+ *  - a union field `x` is accompanied by a field `x_type` which holds the name of the member type. When converting to
+ *    binary, `x_type` has to come before `x`.
+ *  - absent fields and nulls are omitted
+ *  - floats which aren't finite are written as nan, inf and -inf (which isn't JSON, but what flatc writes and reads)
+ */
+namespace flowflat::json {
+
+class ParseError : public std::runtime_error {
+	std::size_t errorPosition;
+
+public:
+	ParseError(std::string const& message, std::size_t position);
+
+	// offset in the JSON text where the error was detected
+	[[nodiscard]] std::size_t position() const { return errorPosition; }
+};
+
+// converts a JSON object into a buffer with root type `root`. Throws ParseError if the text is not valid JSON or
+// doesn't match the schema.
+[[nodiscard]] std::string toBinary(reflection::TypeInfo const& root, std::string_view json);
+
+// appends the JSON representation of table to out
+void toJson(reflection::Table const& table, std::string& out);
+[[nodiscard]] std::string toJson(reflection::Table const& table);
+
+} // namespace flowflat::json
+
+#endif // FLATBUFFER_FLOWFLAT_JSON_H
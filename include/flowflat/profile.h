@@ -0,0 +1,93 @@
+#ifndef FLATBUFFER_FLOWFLAT_PROFILE_H
+#define FLATBUFFER_FLOWFLAT_PROFILE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Field access profiles. Code generated with flowflatc --profile-access counts every call of a view accessor (and with
+ * it every field a Lazy table decodes) per field, and every table that is decoded as a whole with read(). Reads of
+ * fields by read() itself are not counted as accesses, so a table which is decoded often but whose fields are rarely
+ * accessed through views was likely decoded for nothing.
+ *
+ * Every thread counts into its own table, a counter update is an uncontended load and store. snapshot() and dump() sum
+ * the tables of all threads (including threads that exited).
+ *
+ * flowflatc --layout-profile reads what dump() wrote and places the most accessed fields of every table at the start of
+ * its inline data.
+ */
+namespace flowflat::profile {
+
+struct FieldAccesses {
+	std::string field;
+	uint64_t accesses = 0;
+};
+
+struct TableProfile {
+	// the name of the table in the schema
+	std::string table;
+	// calls of read(), including the reads of nested tables
+	uint64_t decodes = 0;
+	// in declaration order
+	std::vector<FieldAccesses> fields;
+};
+
+// all tables which were accessed so far ordered by name
+[[nodiscard]] std::vector<TableProfile> snapshot();
+void reset();
+// writes a profile: one line per field ("<table>.<field> <accesses>"), decodes are written as comments
+void dump(std::ostream& out);
+
+namespace detail {
+
+// the counters of the calling thread for a table: decodes followed by the accesses of each field
+[[nodiscard]] std::atomic<uint64_t>* threadCounters(std::string_view table,
+                                                    std::string_view const* fields,
+                                                    std::size_t numFields);
+
+// non-zero while the calling thread is inside of read()
+extern thread_local unsigned decoding;
+
+template <class T>
+[[nodiscard]] std::atomic<uint64_t>* counters() {
+	thread_local auto res =
+	    threadCounters(T::flowFlatName, T::flowFlatFieldNames, std::size(T::flowFlatFieldNames));
+	return res;
+}
+
+inline void increment(std::atomic<uint64_t>& counter) {
+	// only the owning thread writes, so this doesn't need to be atomic
+	counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+// counts an access of field (the index into T::flowFlatFieldNames)
+template <class T>
+void access(std::size_t field) {
+	if (!detail::decoding) {
+		detail::increment(detail::counters<T>()[field + 1]);
+	}
+}
+
+// counts a decode of T, accesses are not counted while it lives
+template <class T>
+class DecodeScope {
+public:
+	DecodeScope() {
+		detail::increment(detail::counters<T>()[0]);
+		++detail::decoding;
+	}
+	DecodeScope(DecodeScope const&) = delete;
+	DecodeScope& operator=(DecodeScope const&) = delete;
+	~DecodeScope() { --detail::decoding; }
+};
+
+} // namespace flowflat::profile
+
+#endif // FLATBUFFER_FLOWFLAT_PROFILE_H
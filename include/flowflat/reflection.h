@@ -0,0 +1,264 @@
+#ifndef FLATBUFFER_FLOWFLAT_REFLECTION_H
+#define FLATBUFFER_FLOWFLAT_REFLECTION_H
+#include <string_view>
+#include <string>
+#include <vector>
+#include <variant>
+#include <optional>
+#include <unordered_map>
+#include <type_traits>
+
+#include "flowflat.h"
+#include "schema.h"
+
+/*
+ * Schema driven access to buffers. This is meant for generic tools which have to handle buffers of schemas they were
+ * not compiled against.
+ *
+ * A Reflection object is built once per binary schema. It precomputes everything which can be derived from the schema
+ * (vtable slots, struct layouts, element sizes, default values, name lookup tables), so accessing a field at runtime is
+ * a vtable lookup followed by a load -- the same work generated code does.
+ *
+ * Buffers are not verified. Untrusted buffers have to be verified before they can be accessed.
+ */
+namespace flowflat::reflection {
+
+using schema::BaseType;
+using schema::Kind;
+
+struct TypeInfo;
+struct FieldInfo;
+class Struct;
+class Table;
+class Vector;
+class Union;
+
+// a decoded field. Enums are decoded as their underlying integer, absent strings, tables, vectors and unions as
+// std::monostate
+using Value =
+    std::variant<std::monostate, bool, int64_t, uint64_t, double, std::string_view, Struct, Table, Vector, Union>;
+
+class Struct {
+	TypeInfo const* info = nullptr;
+	char const* data = nullptr;
+
+public:
+	Struct() = default;
+	Struct(TypeInfo const* info, char const* data) : info(info), data(data) {}
+
+	[[nodiscard]] TypeInfo const& type() const { return *info; }
+	[[nodiscard]] char const* begin() const { return data; }
+
+	template <class T>
+	[[nodiscard]] T scalar(FieldInfo const& field) const;
+	[[nodiscard]] Value get(FieldInfo const& field) const;
+	// throws std::out_of_range if there is no field with this name
+	[[nodiscard]] Value get(std::string_view name) const;
+};
+
+class Table {
+	TypeInfo const* info = nullptr;
+	char const* data = nullptr;
+
+public:
+	Table() = default;
+	Table(TypeInfo const* info, char const* data) : info(info), data(data) {}
+
+	[[nodiscard]] TypeInfo const& type() const { return *info; }
+	[[nodiscard]] char const* begin() const { return data; }
+
+	[[nodiscard]] bool has(FieldInfo const& field) const;
+	// scalar and enum fields: returns the default value if the field is absent
+	template <class T>
+	[[nodiscard]] T scalar(FieldInfo const& field) const;
+	[[nodiscard]] std::string_view string(FieldInfo const& field) const;
+	[[nodiscard]] std::optional<Table> table(FieldInfo const& field) const;
+	[[nodiscard]] std::optional<Struct> structure(FieldInfo const& field) const;
+	[[nodiscard]] Vector vector(FieldInfo const& field) const;
+	[[nodiscard]] Union unionValue(FieldInfo const& field) const;
+	[[nodiscard]] Value get(FieldInfo const& field) const;
+	// throws std::out_of_range if there is no field with this name
+	[[nodiscard]] Value get(std::string_view name) const;
+};
+
+class Vector {
+	// describes the elements
+	FieldInfo const* field = nullptr;
+	char const* data = nullptr;
+	uint32_t count = 0;
+
+public:
+	class iterator {
+		Vector const* vector;
+		uint32_t idx;
+
+	public:
+		iterator(Vector const* vector, uint32_t idx) : vector(vector), idx(idx) {}
+		[[nodiscard]] Value operator*() const;
+		iterator& operator++() {
+			++idx;
+			return *this;
+		}
+		[[nodiscard]] bool operator==(iterator const& rhs) const { return idx == rhs.idx; }
+		[[nodiscard]] bool operator!=(iterator const& rhs) const { return idx != rhs.idx; }
+	};
+
+	Vector() = default;
+	Vector(FieldInfo const* field, char const* data, uint32_t count) : field(field), data(data), count(count) {}
+
+	[[nodiscard]] uint32_t size() const { return count; }
+	[[nodiscard]] bool empty() const { return count == 0; }
+	[[nodiscard]] FieldInfo const& elementInfo() const { return *field; }
+	[[nodiscard]] inline char const* element(uint32_t idx) const;
+
+	// vectors of scalars and enums only
+	template <class T>
+	[[nodiscard]] T scalar(uint32_t idx) const {
+		return load<T>(element(idx));
+	}
+	[[nodiscard]] Value operator[](uint32_t idx) const;
+	[[nodiscard]] iterator begin() const { return iterator(this, 0); }
+	[[nodiscard]] iterator end() const { return iterator(this, count); }
+};
+
+class Union {
+	TypeInfo const* info = nullptr;
+	uint32_t unionTag = 0;
+	char const* data = nullptr;
+
+public:
+	Union() = default;
+	Union(TypeInfo const* info, uint32_t tag, char const* data) : info(info), unionTag(tag), data(data) {}
+
+	[[nodiscard]] TypeInfo const& type() const { return *info; }
+	// 0 if the union is empty, otherwise the index of the member type + 1
+	[[nodiscard]] uint32_t tag() const { return unionTag; }
+	[[nodiscard]] bool empty() const { return unionTag == 0; }
+	// nullptr if the union is empty
+	[[nodiscard]] TypeInfo const* memberType() const;
+	[[nodiscard]] std::optional<Table> table() const;
+};
+
+// a field of a struct or table, or the element of a vector
+struct FieldInfo {
+	schema::Field const* field = nullptr;
+	std::string_view name;
+	// index of the field in its struct or table
+	uint32_t index = 0;
+	// tables: the position of the field in the vtable
+	voffset_t slot = 0;
+	// structs: the offset of the field within the struct
+	// tables: the offset of the field in tables written with this schema (readers have to use the vtable of the buffer)
+	uint32_t offset = 0;
+	// the primitive type or the underlying type of an enum. None for structs, tables and unions.
+	BaseType baseType = BaseType::None;
+	// user defined types only, nullptr for primitives
+	TypeInfo const* type = nullptr;
+	bool isVector = false;
+	// size of the inline representation of a value (for vectors: of an element)
+	uint32_t size = 0;
+	uint32_t alignment = 1;
+	// the value of absent scalar fields
+	Value defaultValue;
+
+	[[nodiscard]] bool isScalar() const { return baseType != BaseType::None && baseType != BaseType::String; }
+	// describes one element of a vector field
+	[[nodiscard]] FieldInfo const& element() const { return *elementInfo; }
+
+private:
+	friend class Reflection;
+	// vectors: the description of an element (same as this, but not a vector)
+	std::shared_ptr<FieldInfo> elementInfo;
+};
+
+struct TypeInfo {
+	schema::Type const* type = nullptr;
+	uint32_t index = 0;
+	Kind kind = Kind::Table;
+	std::string_view name;
+	std::string qualifiedName;
+	// tables: the vtable of tables written with this schema
+	schema::Array<voffset_t> vtable;
+	// structs and tables
+	std::vector<FieldInfo> fields;
+	// unions: tag - 1 -> type
+	std::vector<TypeInfo const*> members;
+	// enums
+	std::vector<std::pair<int64_t, std::string_view>> values;
+
+	// returns nullptr if there is no such field
+	[[nodiscard]] FieldInfo const* field(std::string_view name) const;
+	// enums only, returns an empty string if the value is not an enumerator
+	[[nodiscard]] std::string_view enumName(int64_t value) const;
+	[[nodiscard]] std::optional<int64_t> enumValue(std::string_view name) const;
+
+private:
+	friend class Reflection;
+	std::unordered_map<std::string_view, uint32_t> fieldIndex;
+};
+
+class Reflection {
+	schema::Schema binarySchema;
+	// same order as in the binary schema
+	std::vector<TypeInfo> typeInfos;
+	std::unordered_map<std::string_view, TypeInfo const*> byName;
+
+	void describe(FieldInfo& info, schema::Field const& field);
+
+public:
+	explicit Reflection(schema::Schema const& schema);
+	// type infos point into this object
+	Reflection(Reflection const&) = delete;
+	Reflection& operator=(Reflection const&) = delete;
+
+	[[nodiscard]] schema::Schema const& schema() const { return binarySchema; }
+	[[nodiscard]] std::vector<TypeInfo> const& types() const { return typeInfos; }
+	// the fully qualified name of the type, returns nullptr if the type doesn't exist
+	[[nodiscard]] TypeInfo const* findType(std::string_view qualifiedName) const;
+	// the root type of the schema, nullptr if the schema doesn't declare one
+	[[nodiscard]] TypeInfo const* rootType() const;
+
+	[[nodiscard]] static Table root(char const* buffer, TypeInfo const& type) {
+		return Table(&type, rootTable(buffer));
+	}
+};
+
+// decodes the value described by field which is stored at position p (p is the field position in a table or struct,
+// or the position of a vector element)
+[[nodiscard]] Value decode(FieldInfo const& field, char const* p);
+
+namespace detail {
+
+template <class T>
+T convert(Value const& v) {
+	return std::visit(
+	    [](auto const& x) -> T {
+		    if constexpr (std::is_arithmetic_v<std::decay_t<decltype(x)>>) {
+			    return static_cast<T>(x);
+		    } else {
+			    return T();
+		    }
+	    },
+	    v);
+}
+
+} // namespace detail
+
+char const* Vector::element(uint32_t idx) const {
+	return data + std::size_t(idx) * field->size;
+}
+
+template <class T>
+T Struct::scalar(FieldInfo const& field) const {
+	return load<T>(data + field.offset);
+}
+
+template <class T>
+T Table::scalar(FieldInfo const& field) const {
+	auto offset = fieldOffset(data, field.slot);
+	return offset ? load<T>(data + offset) : detail::convert<T>(field.defaultValue);
+}
+
+} // namespace flowflat::reflection
+
+#endif // FLATBUFFER_FLOWFLAT_REFLECTION_H
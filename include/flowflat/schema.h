@@ -0,0 +1,211 @@
+#ifndef FLATBUFFER_FLOWFLAT_SCHEMA_H
+#define FLATBUFFER_FLOWFLAT_SCHEMA_H
+#include <string_view>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+#include "flowflat.h"
+
+/*
+ * Binary schemas (.bfbs files) are a precompiled form of a verified schema. They contain the schema file, everything
+ * it includes (transitively) and the serialization information (alignment, size and vtable) of every type. A binary
+ * schema can be used in place: all records have a fixed layout and reference each other through offsets, so loading
+ * one is a bounds check followed by pointer arithmetic.
+ *
+ * Layout (all integers are little endian, all records are naturally aligned):
+ *
+ *   Header
+ *   arrays of records referenced by ArrayRef (Files, Types, Fields, ...)
+ *   string table -- StringRef offsets are relative to the start of the string table, strings are NUL-terminated
+ */
+namespace flowflat::schema {
+
+constexpr uint32_t magic = 0x53424646; // "FFBS"
+constexpr uint32_t version = 3;
+
+enum class BaseType : uint8_t { None, Bool, Byte, UByte, Short, UShort, Int, UInt, Long, ULong, Float, Double, String };
+
+enum class Kind : uint8_t { Enum, Union, Struct, Table };
+
+struct StringRef {
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+template <class T>
+struct ArrayRef {
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
+// references either a type in the schema (index into Header::types) or a primitive type (high bit set, the lower bits
+// are the BaseType)
+struct TypeRef {
+	static constexpr uint32_t primitiveFlag = 0x80000000u;
+	uint32_t value = primitiveFlag;
+
+	[[nodiscard]] bool isPrimitive() const { return value & primitiveFlag; }
+	[[nodiscard]] BaseType baseType() const {
+		return isPrimitive() ? BaseType(value & ~primitiveFlag) : BaseType::None;
+	}
+	[[nodiscard]] uint32_t index() const { return value; }
+
+	static TypeRef primitive(BaseType t) { return TypeRef{ primitiveFlag | uint32_t(t) }; }
+	static TypeRef type(uint32_t index) { return TypeRef{ index }; }
+};
+
+struct EnumValue {
+	int64_t value;
+	StringRef name;
+};
+
+struct UnionMember {
+	// the name as it was written in the schema
+	StringRef name;
+	TypeRef type;
+};
+
+struct Field {
+	// IsBorrowed: generated code uses non-owning types (std::string_view, flowflat::Span) for the field
+	// IsHot: the field is placed at the start of the inline data of its table
+	enum Flags : uint16_t { IsArray = 1, IsDeprecated = 2, HasDefault = 4, IsBorrowed = 8, IsHot = 16 };
+	StringRef name;
+	// the type name as it was written in the schema
+	StringRef typeName;
+	TypeRef type;
+	uint16_t flags;
+	uint16_t padding;
+	StringRef defaultValue;
+	// the root type of a nested flatbuffer as it was written in the schema, empty for other fields
+	StringRef nestedFlatbuffer;
+
+	[[nodiscard]] bool isArray() const { return flags & IsArray; }
+	[[nodiscard]] bool isDeprecated() const { return flags & IsDeprecated; }
+	[[nodiscard]] bool hasDefault() const { return flags & HasDefault; }
+	[[nodiscard]] bool isBorrowed() const { return flags & IsBorrowed; }
+	[[nodiscard]] bool isHot() const { return flags & IsHot; }
+};
+
+struct Type {
+	StringRef name;
+	// index into Header::files
+	uint32_t file;
+	Kind kind;
+	// underlying type of enums, None otherwise
+	BaseType underlyingType;
+	uint16_t padding;
+	// enums only: the underlying type as it was written in the schema
+	StringRef underlyingTypeName;
+	uint32_t alignment;
+	uint32_t staticSize;
+	// tables only
+	ArrayRef<voffset_t> vtable;
+	// structs and tables only
+	ArrayRef<Field> fields;
+	// enums only
+	ArrayRef<EnumValue> values;
+	// unions only
+	ArrayRef<UnionMember> members;
+};
+
+struct File {
+	enum Flags : uint32_t { HasNamespace = 1, HasIdentifier = 2, HasExtension = 4 };
+	// canonical path of the schema this was compiled from
+	StringRef path;
+	uint32_t flags;
+	StringRef fileIdentifier;
+	StringRef fileExtension;
+	ArrayRef<StringRef> namespacePath;
+	ArrayRef<StringRef> attributes;
+	ArrayRef<StringRef> rootTypes;
+	// indexes into Header::types in declaration order
+	ArrayRef<uint32_t> types;
+	// indexes into Header::files, in declaration order
+	ArrayRef<uint32_t> includes;
+};
+
+struct Header {
+	uint32_t magic;
+	uint32_t version;
+	// size of the whole binary schema
+	uint32_t size;
+	// index of the file the binary schema was compiled for. Files are ordered such that every file comes after all
+	// files it includes, so this is always the last file.
+	uint32_t root;
+	ArrayRef<File> files;
+	ArrayRef<Type> types;
+	ArrayRef<char> strings;
+};
+
+// a read-only view of a range of records
+template <class T>
+class Array {
+	T const* first = nullptr;
+	uint32_t count = 0;
+
+public:
+	Array() = default;
+	Array(T const* first, uint32_t count) : first(first), count(count) {}
+
+	[[nodiscard]] T const* begin() const { return first; }
+	[[nodiscard]] T const* end() const { return first + count; }
+	[[nodiscard]] uint32_t size() const { return count; }
+	[[nodiscard]] bool empty() const { return count == 0; }
+	[[nodiscard]] T const& operator[](uint32_t idx) const { return first[idx]; }
+};
+
+// A view of a binary schema. This doesn't own the memory.
+class Schema {
+	char const* data;
+
+	explicit Schema(char const* data) : data(data) {}
+
+public:
+	// checks that the buffer contains a binary schema, that every reference in it is in bounds and that every type is
+	// well-formed for its kind (fields of the right types which lie within the inline data, integral enums, unions of
+	// tables). The buffer has to be aligned to 8 bytes. Returns nothing if the buffer is not a valid binary schema.
+	static std::optional<Schema> open(void const* buffer, std::size_t size);
+
+	[[nodiscard]] Header const& header() const { return *reinterpret_cast<Header const*>(data); }
+
+	template <class T>
+	[[nodiscard]] Array<T> operator[](ArrayRef<T> ref) const {
+		return Array<T>(reinterpret_cast<T const*>(data + ref.offset), ref.size);
+	}
+	[[nodiscard]] std::string_view operator[](StringRef ref) const {
+		return std::string_view(data + header().strings.offset + ref.offset, ref.size);
+	}
+
+	[[nodiscard]] Array<File> files() const { return (*this)[header().files]; }
+	[[nodiscard]] Array<Type> types() const { return (*this)[header().types]; }
+	[[nodiscard]] File const& root() const { return files()[header().root]; }
+
+	// finds a type by its fully qualified name (e.g. "MyNamespace.MyTable"). This is a linear search, clients which
+	// look up types repeatedly should build an index.
+	[[nodiscard]] Type const* findType(std::string_view qualifiedName) const;
+	// the fully qualified name of a type
+	[[nodiscard]] std::string qualifiedName(Type const& type) const;
+	// the name of a primitive type as it is written in a schema
+	static std::string_view name(BaseType type);
+};
+
+// A binary schema loaded from a file. The file is memory mapped, so opening a binary schema doesn't read it.
+class SchemaFile {
+	void* mapping = nullptr;
+	std::size_t length = 0;
+	std::optional<Schema> loaded;
+
+public:
+	// throws std::runtime_error if the file can't be mapped or is not a valid binary schema
+	explicit SchemaFile(char const* path);
+	SchemaFile(SchemaFile const&) = delete;
+	SchemaFile& operator=(SchemaFile const&) = delete;
+	~SchemaFile();
+
+	[[nodiscard]] Schema const& schema() const { return *loaded; }
+};
+
+} // namespace flowflat::schema
+
+#endif // FLATBUFFER_FLOWFLAT_SCHEMA_H
@@ -0,0 +1,741 @@
+#ifndef FLATBUFFER_FLOWFLAT_SERIALIZER_H
+#define FLATBUFFER_FLOWFLAT_SERIALIZER_H
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <limits>
+#include <map>
+#include <vector>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+#include "flowflat.h"
+#include "stats.h"
+
+namespace flowflat {
+
+class Serializer;
+template <class Root>
+class Resumable;
+
+// the work which is left of a resumable serialization (see Resumable)
+struct ResumableWork {
+	using RangeKey = std::tuple<void const*, std::size_t, std::size_t>;
+
+	std::size_t elementsPerStep = 1;
+	std::size_t bytesPerStep = 1;
+	// a stack, so the jobs a job deferred run before the jobs which were deferred earlier. A job returns false if
+	// it had nothing left to do.
+	std::vector<std::function<bool()>> jobs;
+	// the serializer of the root in the current pass, jobs share its buffer and vtables
+	Serializer const* origin = nullptr;
+	// the sizes of deferred ranges of vector elements by first element, number of elements and start modulo
+	// maxAlignment
+	std::map<RangeKey, std::size_t> sizes;
+};
+
+/*
+ * Writes buffers for generated code.
+ *
+ * A buffer is written in two passes over the same generated code: the first pass runs on a Serializer without a buffer
+ * and only computes the layout (and with it the size of the buffer), the second pass writes into a buffer of exactly
+ * that size. Objects are appended in the order in which they are visited, so every reference points forward.
+ *
+ * Vtables are static per table type. Each vtable is written once per buffer, tables refer to it through their soffset.
+ *
+ * Scatter-gather: strings and vectors of scalars of at least gatherThreshold bytes are not copied into the buffer.
+ * Positions still refer to the logical buffer (which contains the payloads), the payloads are only left out of the
+ * memory that gets written. See GatherWriter.
+ *
+ * Parallel serialization: large vectors of tables are split into one chunk per thread. The layout of a chunk only
+ * depends on its start position modulo maxAlignment, so the sizing pass sizes every chunk for each possible start in
+ * parallel. A prefix sum over the chunk sizes gives every chunk its position and the writing pass fills the chunks in
+ * parallel. The result is byte-identical to the sequential layout. Only the outermost large vectors are split, and
+ * scatter-gather writers always serialize sequentially.
+ *
+ * Resumable serialization (see Resumable) runs the passes as jobs with a budget of vector elements and bytes. What a
+ * job can't afford is deferred to jobs of its own: ranges of vector elements, which are sized for every possible start
+ * like the chunks above, and copies of payloads. What a job spends doesn't depend on its position, so both passes defer
+ * the same ranges.
+ */
+class Serializer {
+	template <class Root>
+	friend class Resumable;
+
+	struct VTableEntry {
+		voffset_t const* vtable;
+		std::size_t position;
+	};
+
+	// nullptr during the sizing pass
+	char* buffer = nullptr;
+	std::size_t used = 0;
+	// vtables which were already written. Most buffers contain only a few table types, so the first few entries don't
+	// need an allocation.
+	std::array<VTableEntry, 16> vtables{};
+	unsigned numVTables = 0;
+	std::vector<VTableEntry> moreVTables;
+	std::size_t gatherThreshold = std::numeric_limits<std::size_t>::max();
+	// ordered by position
+	std::vector<GatheredPayload> gathered;
+	std::size_t gatheredSize = 0;
+	unsigned threads = 1;
+	// the chunk sizes computed by the sizing pass, consumed by the writing pass in the same order
+	std::vector<std::size_t> plan;
+	std::size_t planned = 0;
+	bool planComplete = false;
+	// resumable serialization: the work which is left and what this job spent of its budget
+	ResumableWork* work = nullptr;
+	std::size_t spentElements = 0;
+	std::size_t spentBytes = 0;
+	// the jobs this job deferred, handed over to work when it is done
+	std::vector<std::function<bool()>> later;
+	// the sizing pass skipped a deferred range whose size isn't known yet, so the computed size is meaningless
+	bool incomplete = false;
+#ifdef FLOWFLAT_STATS
+	// vtables this pass found in the buffer, added to counters when the serializer is destroyed
+	stats::Counters* counters = nullptr;
+	std::size_t vtableHits = 0;
+#endif
+
+	[[nodiscard]] std::size_t hit(std::size_t vtablePosition) {
+#ifdef FLOWFLAT_STATS
+		++vtableHits;
+#endif
+		return vtablePosition;
+	}
+
+	[[nodiscard]] std::size_t align(std::size_t alignment) const { return (used + alignment - 1) & ~(alignment - 1); }
+
+	void pad(std::size_t to) {
+		if (buffer) {
+			std::memset(at(used), 0, to - used);
+		}
+		used = to;
+	}
+
+	// leaves the payload at position out of the buffer
+	void gather(std::size_t position, char const* data, std::size_t size) {
+		gathered.push_back(GatheredPayload{ position, data, size });
+		gatheredSize += size;
+	}
+
+	// serializes a chunk of a vector on a worker thread, starting at `start`
+	Serializer(Serializer const& parent, std::size_t start)
+	  : buffer(parent.buffer), used(start), vtables(parent.vtables), numVTables(parent.numVTables),
+	    moreVTables(parent.moreVTables) {
+#ifdef FLOWFLAT_STATS
+		counters = parent.counters;
+#endif
+	}
+
+	// a job of a resumable serialization, starting at `start` with a budget of its own
+	Serializer(ResumableWork* work, std::size_t start) : Serializer(*work->origin, start) { this->work = work; }
+
+	// padding is spent as if it was as large as it can be, so what a job spends doesn't depend on its position
+	void spend(std::size_t elements, std::size_t bytes) {
+		spentElements += elements;
+		spentBytes += bytes;
+	}
+
+	// a job of a resumable serialization used up its budget, the vector elements it reaches from now on are deferred
+	[[nodiscard]] bool exhausted() const {
+		return work && (spentElements >= work->elementsPerStep || spentBytes >= work->bytesPerStep);
+	}
+
+	// hands the jobs this job deferred to the resumable serialization
+	void handOver() {
+		std::move(later.begin(), later.end(), std::back_inserter(work->jobs));
+		later.clear();
+	}
+
+	// copies a payload into the buffer. A job of a resumable serialization which can't afford the copy defers it in
+	// slices of bytesPerStep. This doesn't change the layout, so only the writing pass defers anything.
+	void copy(std::size_t position, void const* data, std::size_t bytes) {
+		if (!buffer) {
+			return;
+		}
+		if (!work || spentBytes + bytes <= work->bytesPerStep) {
+			std::memcpy(at(position), data, bytes);
+			return;
+		}
+		for (std::size_t offset = 0; offset < bytes; offset += work->bytesPerStep) {
+			later.emplace_back([to = at(position) + offset,
+			                    from = static_cast<char const*>(data) + offset,
+			                    size = std::min(work->bytesPerStep, bytes - offset)]() {
+				std::memcpy(to, from, size);
+				return true;
+			});
+		}
+	}
+
+	// sizes a deferred range of vector elements for one start. If the range deferred ranges itself, it is sized again
+	// once they are sized.
+	template <class Walk>
+	struct SizeRange {
+		ResumableWork* work;
+		ResumableWork::RangeKey key;
+		Walk walk;
+		std::size_t first;
+		std::size_t last;
+
+		bool operator()() const {
+			if (work->sizes.count(key)) {
+				return false;
+			}
+			auto start = std::get<2>(key);
+			Serializer job(work, start);
+			walk(job, first, last);
+			if (job.incomplete) {
+				work->jobs.emplace_back(*this);
+			} else {
+				work->sizes.emplace(key, job.used - start);
+			}
+			job.handOver();
+			return true;
+		}
+	};
+
+	// defers the elements [begin, end) of a vector to jobs of at most elementsPerStep elements which call
+	// walk(job, first, last). The sizing pass needs the size of every range, which is only known once the range was
+	// sized for every start it can have.
+	template <class Element, class Walk>
+	void deferRanges(Element const* elements, std::size_t begin, std::size_t end, std::size_t alignment, Walk walk) {
+		for (auto first = begin; first < end; first += work->elementsPerStep) {
+			auto last = std::min(end, first + work->elementsPerStep);
+			auto key = [&](std::size_t start) {
+				return ResumableWork::RangeKey(static_cast<void const*>(elements + first), last - first, start);
+			};
+			auto start = align(alignment);
+			if (!sizing()) {
+				later.emplace_back([work = work, walk, first, last, position = used]() {
+					Serializer job(work, position);
+					walk(job, first, last);
+					job.handOver();
+					return true;
+				});
+				used = start + work->sizes.at(key(start % maxAlignment));
+				continue;
+			}
+			auto size = work->sizes.find(key(start % maxAlignment));
+			if (size != work->sizes.end()) {
+				used = start + size->second;
+				continue;
+			}
+			incomplete = true;
+			for (std::size_t i = 0; i < maxAlignment; i += alignment) {
+				later.emplace_back(SizeRange<Walk>{ work, key(i), walk, first, last });
+			}
+			used = start;
+		}
+	}
+
+	// serializes the elements [begin, end) of a vector of tables or strings until the budget is used up and defers the
+	// rest. writeElement(serializer, element) returns the position of the serialized element.
+	template <class Element, class WriteElement>
+	void referenceRange(std::size_t vector,
+	                    Element const* elements,
+	                    std::size_t begin,
+	                    std::size_t end,
+	                    std::size_t alignment,
+	                    WriteElement writeElement) {
+		auto e = begin;
+		for (; e < end && !exhausted(); ++e) {
+			spend(1, sizeof(uoffset_t));
+			link(vector + sizeof(uint32_t) + sizeof(uoffset_t) * e, writeElement(*this, elements[e]));
+		}
+		if (e < end) {
+			deferRanges(elements, e, end, alignment, [=](Serializer& job, std::size_t first, std::size_t last) {
+				job.referenceRange(vector, elements, first, last, alignment, writeElement);
+			});
+		}
+	}
+
+	// writes the elements [begin, end) of a vector of fixed size elements with write(serializer, index) until the
+	// budget is used up and defers the rest. Their positions are known, so only the writing pass defers anything.
+	template <class Write>
+	void fixedRange(std::size_t elementSize, std::size_t begin, std::size_t end, Write write) {
+		auto count = end - begin;
+		if (work) {
+			count = exhausted() ? 0
+			                    : std::min({ count,
+			                                 work->elementsPerStep - spentElements,
+			                                 (work->bytesPerStep - spentBytes) / elementSize });
+			// a job always makes progress, even if a single element exceeds the budget
+			if (count == 0 && spentElements == 0 && spentBytes == 0) {
+				count = 1;
+			}
+			spend(count, count * elementSize);
+		}
+		if (!buffer) {
+			return;
+		}
+		for (auto i = begin; i < begin + count; ++i) {
+			write(*this, i);
+		}
+		auto perJob = work ? std::max(std::size_t(1), std::min(work->elementsPerStep, work->bytesPerStep / elementSize))
+		                   : std::size_t(1);
+		for (auto first = begin + count; first < end; first += perJob) {
+			later.emplace_back([work = work, elementSize, write, first, last = std::min(end, first + perJob)]() {
+				Serializer job(work, 0);
+				job.fixedRange(elementSize, first, last, write);
+				job.handOver();
+				return true;
+			});
+		}
+	}
+
+	// runs the jobs on up to `threads` threads
+	void run(std::vector<std::function<void()>>& jobs) {
+		auto n = std::min(std::size_t(threads), jobs.size());
+		std::vector<std::thread> workers;
+		std::vector<std::exception_ptr> errors(n);
+		auto work = [&jobs, &errors, n](std::size_t worker) {
+			try {
+				for (auto i = worker; i < jobs.size(); i += n) {
+					jobs[i]();
+				}
+			} catch (...) {
+				errors[worker] = std::current_exception();
+			}
+		};
+		workers.reserve(n - 1);
+		for (std::size_t i = 1; i < n; ++i) {
+			workers.emplace_back(work, i);
+		}
+		work(0);
+		for (auto& worker : workers) {
+			worker.join();
+		}
+		jobs.clear();
+		for (auto const& error : errors) {
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+	}
+
+	template <class T>
+	void chunkedTables(std::size_t vector, T const* elements, std::size_t count) {
+		constexpr std::size_t alignment = T::flowFlatAlignment;
+		constexpr std::size_t starts = maxAlignment / alignment;
+		auto chunks = std::min(std::size_t(threads), count);
+		auto chunkBegin = [count, chunks](std::size_t chunk) { return count * chunk / chunks; };
+		std::vector<std::function<void()>> jobs;
+		if (sizing() && !planComplete) {
+			// chunk c started at i * alignment (modulo maxAlignment) ends plan[first + c * starts + i] bytes later
+			auto first = plan.size();
+			plan.resize(first + chunks * starts);
+			for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+				for (std::size_t i = 0; i < starts; ++i) {
+					jobs.emplace_back([this,
+					                   elements,
+					                   begin = chunkBegin(chunk),
+					                   end = chunkBegin(chunk + 1),
+					                   slot = first + chunk * starts + i,
+					                   start = i * alignment]() {
+						Serializer worker(*this, start);
+						for (auto e = begin; e < end; ++e) {
+							(void)elements[e].writeTo(worker);
+						}
+						plan[slot] = worker.used - start;
+					});
+				}
+			}
+			run(jobs);
+		}
+		// prefix sum: chunks start where the previous chunk ended
+		std::vector<std::size_t> positions(chunks + 1, used);
+		for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+			auto aligned = (positions[chunk] + alignment - 1) & ~(alignment - 1);
+			auto start = (aligned % maxAlignment) / alignment;
+			positions[chunk + 1] = aligned + plan[planned + chunk * starts + start];
+		}
+		planned += chunks * starts;
+		if (!sizing()) {
+			for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+				jobs.emplace_back([this,
+				                   elements,
+				                   vector,
+				                   begin = chunkBegin(chunk),
+				                   end = chunkBegin(chunk + 1),
+				                   start = positions[chunk]]() {
+					Serializer worker(*this, start);
+					for (auto e = begin; e < end; ++e) {
+						worker.link(vector + sizeof(uint32_t) + sizeof(uoffset_t) * e, elements[e].writeTo(worker));
+					}
+				});
+			}
+			run(jobs);
+		}
+		used = positions[chunks];
+	}
+
+public:
+	// vectors of tables with fewer elements are always serialized sequentially
+	static constexpr std::size_t minParallelElements = 1024;
+
+	// the sizing pass
+	Serializer() = default;
+	// buffer has to be at least as large as the size computed by the sizing pass
+	explicit Serializer(char* buffer) : buffer(buffer) {}
+	// the sizing pass for a buffer that will be allocated from w (uses its scatter-gather and threading settings)
+	explicit Serializer(Writer const& w) : gatherThreshold(w.gatherThreshold()), threads(w.serializationThreads()) {}
+	// the pass after `previous` (usually the writing pass after the sizing pass), reuses the chunk sizes it computed
+	Serializer(char* buffer, Serializer&& previous)
+	  : buffer(buffer), gatherThreshold(previous.gatherThreshold), threads(previous.threads),
+	    plan(std::move(previous.plan)), planComplete(true) {}
+	Serializer(Serializer const&) = delete;
+	Serializer& operator=(Serializer const&) = delete;
+#ifdef FLOWFLAT_STATS
+	~Serializer() {
+		if (counters) {
+			counters->vtableHits.fetch_add(vtableHits, std::memory_order_relaxed);
+		}
+	}
+#endif
+
+	// counts what this pass does for the root type Root (only if FLOWFLAT_STATS is defined, see stats.h)
+	template <class Root>
+	void countFor() {
+#ifdef FLOWFLAT_STATS
+		counters = &stats::counters<Root>();
+#endif
+	}
+
+	[[nodiscard]] bool sizing() const { return buffer == nullptr; }
+	// the size of the logical buffer
+	[[nodiscard]] std::size_t size() const { return used; }
+	[[nodiscard]] char* data() const { return buffer; }
+	// the payloads which were left out of the buffer and their total size
+	[[nodiscard]] std::vector<GatheredPayload> const& gatheredPayloads() const { return gathered; }
+	[[nodiscard]] std::size_t gatheredBytes() const { return gatheredSize; }
+
+	// the address of a position of the logical buffer. Stores almost always target the end of the buffer or a position
+	// shortly before the last gathered payload, so the payloads are searched backwards.
+	[[nodiscard]] char* at(std::size_t position) const {
+		auto res = position - gatheredSize;
+		for (auto i = gathered.size(); i > 0 && position < gathered[i - 1].position; --i) {
+			res += gathered[i - 1].size;
+		}
+		return buffer + res;
+	}
+
+	// reserves zeroed memory, returns its position
+	std::size_t allocate(std::size_t bytes, std::size_t alignment) {
+		pad(align(alignment));
+		auto res = used;
+		pad(used + bytes);
+		spend(0, alignment - 1 + bytes);
+		return res;
+	}
+
+	void zero(std::size_t position, std::size_t bytes) {
+		if (buffer) {
+			std::memset(at(position), 0, bytes);
+		}
+	}
+
+	template <class T>
+	void store(std::size_t position, T value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		if (buffer) {
+			std::memcpy(at(position), &value, sizeof(T));
+		}
+	}
+
+	// stores a reference at position `from` to the object at position `to`
+	void link(std::size_t from, std::size_t to) { store(from, uoffset_t(to - from)); }
+
+	// writes the vtable unless it was already written, returns its position
+	std::size_t vtable(voffset_t const* vtable) {
+		for (unsigned i = 0; i < numVTables; ++i) {
+			if (vtables[i].vtable == vtable) {
+				return hit(vtables[i].position);
+			}
+		}
+		for (auto const& e : moreVTables) {
+			if (e.vtable == vtable) {
+				return hit(e.position);
+			}
+		}
+		auto pos = align(alignof(voffset_t));
+		pad(pos);
+		if (buffer) {
+			std::memcpy(at(pos), vtable, vtable[0]);
+		}
+		used += vtable[0];
+		spend(0, alignof(voffset_t) - 1 + vtable[0]);
+		if (numVTables < vtables.size()) {
+			vtables[numVTables++] = VTableEntry{ vtable, pos };
+		} else {
+			moreVTables.push_back(VTableEntry{ vtable, pos });
+		}
+		return pos;
+	}
+
+	// reserves the zeroed inline data of a table and links it to its vtable, returns the position of the table
+	std::size_t table(voffset_t const* vtable, std::size_t alignment) {
+		auto vtablePos = this->vtable(vtable);
+		auto pos = allocate(std::size_t(vtable[1]), alignment);
+		store(pos, soffset_t(pos - vtablePos));
+		return pos;
+	}
+
+	std::size_t string(std::string_view str) {
+		pad(align(sizeof(uint32_t)));
+		auto pos = used;
+		store(pos, uint32_t(str.size()));
+		if (str.size() >= gatherThreshold) {
+			gather(pos + sizeof(uint32_t), str.data(), str.size());
+		} else {
+			copy(pos + sizeof(uint32_t), str.data(), str.size());
+		}
+		if (buffer) {
+			*at(pos + sizeof(uint32_t) + str.size()) = '\0';
+		}
+		used += sizeof(uint32_t) + str.size() + 1;
+		spend(0, sizeof(uint32_t) - 1 + sizeof(uint32_t) + str.size() + 1);
+		return pos;
+	}
+
+	// reserves a vector, returns the position of its element count. The elements are not initialized. The first element
+	// is aligned to max(4, alignment).
+	std::size_t vector(std::size_t count, std::size_t elementSize, std::size_t alignment) {
+		alignment = std::max(alignment, sizeof(uint32_t));
+		auto data = (used + sizeof(uint32_t) + alignment - 1) & ~(alignment - 1);
+		pad(data - sizeof(uint32_t));
+		auto pos = used;
+		store(pos, uint32_t(count));
+		used = data + count * elementSize;
+		spend(0, alignment - 1 + sizeof(uint32_t));
+		return pos;
+	}
+
+	// vectors of scalars and enums are copied in one go. alignment can be raised above the alignment of T (nested
+	// buffers are aligned to the largest alignment of the types they contain).
+	template <class T>
+	std::size_t scalars(T const* elements, std::size_t count, std::size_t alignment = sizeof(T)) {
+		static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+		auto pos = vector(count, sizeof(T), alignment);
+		if (count * sizeof(T) >= gatherThreshold) {
+			gather(pos + sizeof(uint32_t), reinterpret_cast<char const*>(elements), count * sizeof(T));
+		} else {
+			copy(pos + sizeof(uint32_t), elements, count * sizeof(T));
+		}
+		spend(0, count * sizeof(T));
+		return pos;
+	}
+
+	// writes the elements of a vector of structs (elementSize apart) into the vector at position `vector`
+	template <class T>
+	void structs(std::size_t vector, T const* elements, std::size_t count, std::size_t elementSize) {
+		fixedRange(elementSize, 0, count, [vector, elements, elementSize](Serializer& s, std::size_t i) {
+			elements[i].writeTo(s, vector + sizeof(uint32_t) + elementSize * i);
+		});
+	}
+
+	// writes the elements of a container of bools into the vector at position `vector`
+	template <class Bools>
+	void bools(std::size_t vector, Bools const& elements) {
+		fixedRange(1, 0, elements.size(), [vector, &elements](Serializer& s, std::size_t i) {
+			s.store(vector + sizeof(uint32_t) + i, uint8_t(elements[i]));
+		});
+	}
+
+	// serializes the elements of a vector of strings and links them into the vector at position `vector`
+	template <class S>
+	void strings(std::size_t vector, S const* elements, std::size_t count) {
+		if (work) {
+			referenceRange(vector, elements, 0, count, sizeof(uint32_t), [](Serializer& s, S const& str) {
+				return s.string(str);
+			});
+			return;
+		}
+		for (std::size_t i = 0; i < count; ++i) {
+			link(vector + sizeof(uint32_t) + sizeof(uoffset_t) * i, string(elements[i]));
+		}
+	}
+
+	// serializes the elements of a vector of tables and links them into the vector at position `vector`
+	template <class T>
+	void tables(std::size_t vector, T const* elements, std::size_t count) {
+		if (work) {
+			referenceRange(vector, elements, 0, count, T::flowFlatAlignment, [](Serializer& s, T const& table) {
+				return table.writeTo(s);
+			});
+			return;
+		}
+		auto chunked = threads > 1 && count >= minParallelElements;
+		if (chunked && gatherThreshold == std::numeric_limits<std::size_t>::max()) {
+			chunkedTables(vector, elements, count);
+			return;
+		}
+		for (std::size_t i = 0; i < count; ++i) {
+			link(vector + sizeof(uint32_t) + sizeof(uoffset_t) * i, elements[i].writeTo(*this));
+		}
+	}
+
+	// writes the size prefix, the root reference and the file identifier (if the framing asks for them), the vtables of
+	// all tables which can be reached from the root and the root table
+	template <class Root>
+	void root(Root const& root, voffset_t const* const* vtables, std::size_t numVTables, Framing const& framing = {}) {
+		auto prefix = framing.sizePrefixed ? allocate(sizeof(uint32_t), sizeof(uint32_t)) : 0;
+		auto pos = allocate(sizeof(uoffset_t), sizeof(uoffset_t));
+		if (framing.identifier) {
+			store(allocate(sizeof(uint32_t), sizeof(uint32_t)), *framing.identifier);
+		}
+		for (std::size_t i = 0; i < numVTables; ++i) {
+			vtable(vtables[i]);
+		}
+		link(pos, root.writeTo(*this));
+		if (framing.sizePrefixed) {
+			store(prefix, uint32_t(used - sizeof(uint32_t)));
+		}
+	}
+};
+
+// writes root into a buffer allocated from w. vtables are the vtables of all tables which can be reached from root.
+template <class Root, std::size_t N>
+void serialize(Writer& w, Root const& root, voffset_t const* const (&vtables)[N], Framing const& framing = {}) {
+	stats::EncodeScope<Root> scope;
+	Serializer sizing(w);
+	sizing.root(root, vtables, N, framing);
+	auto bytes = sizing.size() - sizing.gatheredBytes();
+	Serializer out(w.allocateBuffer(int(bytes)), std::move(sizing));
+	stats::allocated<Root>(bytes);
+	out.countFor<Root>();
+	out.root(root, vtables, N, framing);
+	if (!out.gatheredPayloads().empty()) {
+		w.gather(out.gatheredPayloads().data(), out.gatheredPayloads().size());
+	}
+}
+
+/*
+ * Serializes a buffer in bounded steps, so a single threaded event loop can interleave a large serialization with
+ * other work:
+ *
+ *   auto s = message.writeResumable(w, 1000, 1 << 20);
+ *   while (s.step()) {
+ *       wait(yield());
+ *   }
+ *
+ * A step runs one job of the sizing or the writing pass. A job stops taking on vector elements once it sized or wrote
+ * elementsPerStep of them or bytesPerStep bytes, the remaining elements are deferred to further jobs (in ranges of at
+ * most elementsPerStep elements). Copies of strings and vectors of scalars which a job can't afford are deferred in
+ * slices of bytesPerStep bytes. So a step only exceeds its budget by the inline data of the tables it already started
+ * and by the vtables. The sizing pass of the root runs again once the sizes of the ranges it deferred are known.
+ *
+ * The buffer is allocated from the writer once the layout is known, it is complete when step returns false. root and w
+ * have to outlive the serialization and root must not be modified until it is complete. Scatter-gather writers are not
+ * supported.
+ */
+template <class Root>
+class Resumable {
+	enum class State { Size, Write, Done };
+
+	Writer* w;
+	Root const* root;
+	voffset_t const* const* vtables;
+	std::size_t numVTables;
+	Framing framing;
+	State state = State::Size;
+	// on the heap, jobs keep pointers to it when the Resumable is moved
+	std::unique_ptr<ResumableWork> work = std::make_unique<ResumableWork>();
+	// the job which walks the root in the current pass
+	std::unique_ptr<Serializer> serializer;
+
+	void walk(std::unique_ptr<Serializer> s) {
+		serializer = std::move(s);
+		serializer->work = work.get();
+		work->origin = serializer.get();
+		serializer->root(*root, vtables, numVTables, framing);
+		serializer->handOver();
+	}
+
+	// runs the next job which has something to do, returns false if there is none
+	bool runJob() {
+		while (!work->jobs.empty()) {
+			auto job = std::move(work->jobs.back());
+			work->jobs.pop_back();
+			if (job()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void finish() {
+		serializer.reset();
+		work.reset();
+		state = State::Done;
+		stats::encodeEnd<Root>();
+	}
+
+public:
+	Resumable(Writer& w,
+	          Root const& root,
+	          voffset_t const* const* vtables,
+	          std::size_t numVTables,
+	          Framing const& framing,
+	          std::size_t elementsPerStep,
+	          std::size_t bytesPerStep)
+	  : w(&w), root(&root), vtables(vtables), numVTables(numVTables), framing(framing) {
+		work->elementsPerStep = std::max(elementsPerStep, std::size_t(1));
+		work->bytesPerStep = std::max(bytesPerStep, std::size_t(1));
+	}
+
+	// does a bounded amount of work, returns whether there is more to do
+	bool step() {
+		switch (state) {
+		case State::Size:
+			if (!serializer) {
+				stats::encodeBegin<Root>();
+				walk(std::make_unique<Serializer>());
+				return true;
+			}
+			if (runJob()) {
+				return true;
+			}
+			if (serializer->incomplete) {
+				// the sizes of all ranges the last walk deferred are known now
+				walk(std::make_unique<Serializer>());
+				return true;
+			}
+			{
+				auto bytes = serializer->size();
+				auto s = std::make_unique<Serializer>(w->allocateBuffer(int(bytes)));
+				stats::allocated<Root>(bytes);
+				s->countFor<Root>();
+				walk(std::move(s));
+			}
+			state = State::Write;
+			if (!work->jobs.empty()) {
+				return true;
+			}
+			finish();
+			return false;
+		case State::Write:
+			runJob();
+			if (!work->jobs.empty()) {
+				return true;
+			}
+			finish();
+			return false;
+		case State::Done:
+			break;
+		}
+		return false;
+	}
+
+	[[nodiscard]] bool done() const { return state == State::Done; }
+};
+
+} // namespace flowflat
+
+#endif // FLATBUFFER_FLOWFLAT_SERIALIZER_H
@@ -0,0 +1,43 @@
+#ifndef FLATBUFFER_FLOWFLAT_SPAN_H
+#define FLATBUFFER_FLOWFLAT_SPAN_H
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace flowflat {
+
+/*
+ * A non-owning view of contiguous elements (a minimal std::span for C++17). Generated code uses spans as the native
+ * type of borrowed vectors: the elements are owned by someone else and have to outlive the span.
+ */
+template <class T>
+class Span {
+	T* elements = nullptr;
+	std::size_t count = 0;
+
+public:
+	using element_type = T;
+	using value_type = std::remove_cv_t<T>;
+	using iterator = T*;
+
+	constexpr Span() = default;
+	constexpr Span(T* elements, std::size_t count) : elements(elements), count(count) {}
+	template <std::size_t N>
+	constexpr Span(T (&elements)[N]) : elements(elements), count(N) {}
+	// any contiguous container (std::vector, std::array, Span<U>, ...)
+	template <class Container,
+	          class = std::enable_if_t<std::is_convertible_v<decltype(std::data(std::declval<Container&>())), T*>>>
+	constexpr Span(Container& container) : elements(std::data(container)), count(std::size(container)) {}
+
+	[[nodiscard]] constexpr T* data() const { return elements; }
+	[[nodiscard]] constexpr std::size_t size() const { return count; }
+	[[nodiscard]] constexpr bool empty() const { return count == 0; }
+	[[nodiscard]] constexpr T& operator[](std::size_t idx) const { return elements[idx]; }
+	[[nodiscard]] constexpr iterator begin() const { return elements; }
+	[[nodiscard]] constexpr iterator end() const { return elements + count; }
+};
+
+} // namespace flowflat
+
+#endif // FLATBUFFER_FLOWFLAT_SPAN_H
@@ -0,0 +1,162 @@
+#ifndef FLATBUFFER_FLOWFLAT_STATS_H
+#define FLATBUFFER_FLOWFLAT_STATS_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Counters and tracing hooks for serialization, per root type. They are only compiled in if FLOWFLAT_STATS is defined
+ * (the CMake option of the same name defines it for the runtime and everything linking against it). Otherwise the
+ * helpers below, which generated code calls, are empty and compile to nothing.
+ *
+ * The counters of a type are registered the first time a buffer of that type is written, read or verified:
+ *
+ *   for (auto const& s : flowflat::stats::snapshot()) {
+ *       report(s.type, s.messages, s.bytes);
+ *   }
+ *
+ * A trace hook is called before and after every encoded or decoded root table, e.g. to open spans of a tracer. It is
+ * one atomic load per message if no hook is installed.
+ */
+namespace flowflat::stats {
+
+#ifdef FLOWFLAT_STATS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+struct Counters {
+	// buffers written with this root type
+	std::atomic<uint64_t> messages{ 0 };
+	// the bytes allocated for them
+	std::atomic<uint64_t> bytes{ 0 };
+	// calls to Writer::allocateBuffer
+	std::atomic<uint64_t> allocations{ 0 };
+	// tables which reused a vtable that was already in the buffer
+	std::atomic<uint64_t> vtableHits{ 0 };
+	// buffers decoded into native tables with read()
+	std::atomic<uint64_t> decodes{ 0 };
+	// buffers rejected by verify()
+	std::atomic<uint64_t> verifyFailures{ 0 };
+};
+
+struct Snapshot {
+	std::string type;
+	uint64_t messages = 0;
+	uint64_t bytes = 0;
+	uint64_t allocations = 0;
+	uint64_t vtableHits = 0;
+	uint64_t decodes = 0;
+	uint64_t verifyFailures = 0;
+};
+
+enum class Event { EncodeBegin, EncodeEnd, DecodeBegin, DecodeEnd };
+
+// type is the name of the root type in the schema (e.g. "MyGame.Monster"). Hooks can be called concurrently.
+using TraceHook = void (*)(void* context, Event event, std::string_view type);
+
+// the counters of a type, registered under the given name (never deallocated)
+[[nodiscard]] Counters& registerType(std::string_view type);
+// all registered types ordered by name, empty if FLOWFLAT_STATS is not defined
+[[nodiscard]] std::vector<Snapshot> snapshot();
+// sets all counters to 0
+void reset();
+// installs a trace hook (nullptr removes it). Has no effect if FLOWFLAT_STATS is not defined.
+void setTraceHook(TraceHook hook, void* context = nullptr);
+
+namespace detail {
+
+struct Hook {
+	TraceHook hook;
+	void* context;
+};
+
+extern std::atomic<Hook const*> hook;
+
+inline void trace(Event event, std::string_view type) {
+	if (auto h = hook.load(std::memory_order_acquire)) {
+		h->hook(h->context, event, type);
+	}
+}
+
+} // namespace detail
+
+// T is a generated table
+template <class T>
+[[nodiscard]] Counters& counters() {
+	static Counters& res = registerType(T::flowFlatName);
+	return res;
+}
+
+// counts a buffer of root type T which was allocated from a writer
+template <class T>
+void allocated(std::size_t bytes) {
+	if constexpr (enabled) {
+		auto& c = counters<T>();
+		c.allocations.fetch_add(1, std::memory_order_relaxed);
+		c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+	}
+}
+
+// passes result through, counts failures
+template <class T>
+bool verified(bool result) {
+	if constexpr (enabled) {
+		if (!result) {
+			counters<T>().verifyFailures.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	return result;
+}
+
+template <class T>
+void encodeBegin() {
+	if constexpr (enabled) {
+		detail::trace(Event::EncodeBegin, T::flowFlatName);
+	}
+}
+
+template <class T>
+void encodeEnd() {
+	if constexpr (enabled) {
+		counters<T>().messages.fetch_add(1, std::memory_order_relaxed);
+		detail::trace(Event::EncodeEnd, T::flowFlatName);
+	}
+}
+
+// counts and traces the encoding of a buffer with root type T for as long as it lives
+template <class T>
+class EncodeScope {
+public:
+	EncodeScope() { encodeBegin<T>(); }
+	EncodeScope(EncodeScope const&) = delete;
+	EncodeScope& operator=(EncodeScope const&) = delete;
+	~EncodeScope() { encodeEnd<T>(); }
+};
+
+// counts and traces the decoding of a buffer with root type T for as long as it lives
+template <class T>
+class DecodeScope {
+public:
+	DecodeScope() {
+		if constexpr (enabled) {
+			counters<T>().decodes.fetch_add(1, std::memory_order_relaxed);
+			detail::trace(Event::DecodeBegin, T::flowFlatName);
+		}
+	}
+	DecodeScope(DecodeScope const&) = delete;
+	DecodeScope& operator=(DecodeScope const&) = delete;
+	~DecodeScope() {
+		if constexpr (enabled) {
+			detail::trace(Event::DecodeEnd, T::flowFlatName);
+		}
+	}
+};
+
+} // namespace flowflat::stats
+
+#endif // FLATBUFFER_FLOWFLAT_STATS_H
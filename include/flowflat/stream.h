@@ -0,0 +1,139 @@
+#ifndef FLATBUFFER_FLOWFLAT_STREAM_H
+#define FLATBUFFER_FLOWFLAT_STREAM_H
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#include "flowflat.h"
+#include "verifier.h"
+#include "view.h"
+
+/*
+ * Streaming deserialization: reading a buffer while it arrives in chunks.
+ *
+ * Generated code writes buffers in pre-order: the vtables come first, every table is followed by everything it
+ * references and the tables of a vector are written one after the other, each followed by its own strings, vectors
+ * and tables. So every dependency of an object (its vtable, the reference to it) lies before it, and the i-th table of
+ * a vector with everything it references is the range between the i-th and the (i+1)-th table.
+ *
+ * StreamReader places the chunks at their position in a reserved (but not committed) region of address space, so
+ * views work unchanged. Tables of a vector which were processed can be discarded, which returns their memory to the
+ * operating system. Receiving a large message therefore only needs memory for the part that is being processed.
+ */
+namespace flowflat {
+
+class StreamReader {
+	char* base = nullptr;
+	std::size_t capacity = 0;
+	std::size_t received = 0;
+	bool finished = false;
+
+public:
+	// reserves address space for a buffer of up to maxSize bytes. Throws std::runtime_error if that fails.
+	explicit StreamReader(std::size_t maxSize);
+	StreamReader(StreamReader const&) = delete;
+	StreamReader& operator=(StreamReader const&) = delete;
+	~StreamReader();
+
+	// appends the next chunk of the buffer. Throws std::runtime_error if the buffer gets larger than maxSize.
+	void append(char const* data, std::size_t size);
+	// the whole buffer arrived
+	void finish() { finished = true; }
+
+	[[nodiscard]] bool complete() const { return finished; }
+	[[nodiscard]] std::size_t size() const { return received; }
+	// the start of the buffer, all views point into it
+	[[nodiscard]] char const* data() const { return base; }
+	// whether [p, p + bytes) arrived
+	[[nodiscard]] bool arrived(char const* p, std::size_t bytes) const {
+		return p >= base && std::size_t(p - base) <= received && bytes <= received - std::size_t(p - base);
+	}
+	// the root table once its inline data arrived, nullptr before. Fields of the root table which reference other
+	// objects have to be checked with arrived before they are used.
+	[[nodiscard]] char const* rootTable() const;
+	// releases the memory of [begin, end) (whole pages only), it reads as zeros afterwards
+	void discard(char const* begin, char const* end);
+};
+
+/*
+ * Visits the tables of a vector as they arrive:
+ *
+ *   flowflat::StreamReader reader(maxSize);
+ *   std::optional<flowflat::StreamedTables<Item>> items;
+ *   while (auto chunk = receive()) {
+ *       reader.append(chunk.data(), chunk.size());
+ *       if (!items && reader.rootTable()) {
+ *           items.emplace(reader, Snapshot::View(reader.rootTable()).items());
+ *       }
+ *       if (items) {
+ *           items->poll([](uint32_t i, Item::View item) { ... });
+ *       }
+ *   }
+ *
+ * A table is visited once it and everything it references arrived: when the next table of the vector starts to arrive,
+ * or for the last table when the reader is complete. Visited tables are discarded, so views must not be used after
+ * the visitor returned. The last table is kept: the end of the buffer after it can hold other fields of the root.
+ */
+template <class T>
+class StreamedTables {
+	StreamReader* reader;
+	char const* elements;
+	uint32_t count;
+	uint32_t next = 0;
+
+	[[nodiscard]] char const* table(uint32_t i) const { return follow(elements + sizeof(uoffset_t) * i); }
+
+	// the end of the i-th table with everything it references, nullptr if it didn't arrive yet
+	[[nodiscard]] char const* end(uint32_t i) const {
+		if (i + 1 < count) {
+			// the first byte of the next table arrived
+			auto nextTable = table(i + 1);
+			return reader->arrived(nextTable, 1) ? nextTable : nullptr;
+		}
+		return reader->complete() ? reader->data() + reader->size() : nullptr;
+	}
+
+	template <class Visitor>
+	uint32_t visit(Visitor& visitor, bool verify) {
+		if (!reader->arrived(elements, sizeof(uoffset_t) * std::size_t(count))) {
+			return 0;
+		}
+		uint32_t visited = 0;
+		for (char const* to; next < count && (to = end(next)) != nullptr; ++next, ++visited) {
+			auto from = table(next);
+			if (verify) {
+				Verifier v(reader->data(), std::size_t(to - reader->data()));
+				if (!T::verify(v, std::size_t(from - reader->data())) || !v.ok()) {
+					throw std::runtime_error("invalid table in stream");
+				}
+			}
+			visitor(next, typename T::View(from));
+			if (next + 1 < count) {
+				reader->discard(from, to);
+			}
+		}
+		return visited;
+	}
+
+public:
+	// vector has to be a field of a table that arrived
+	StreamedTables(StreamReader& reader, TableVector<T> vector)
+	  : reader(&reader), elements(vector.data()), count(vector.size()) {}
+
+	// calls visitor(index, view) for every table which arrived since the last call, returns how many it visited
+	template <class Visitor>
+	uint32_t poll(Visitor&& visitor) {
+		return visit(visitor, false);
+	}
+	// same as poll, but every table is verified first. Throws std::runtime_error for invalid tables.
+	template <class Visitor>
+	uint32_t pollVerified(Visitor&& visitor) {
+		return visit(visitor, true);
+	}
+
+	[[nodiscard]] bool done() const { return next == count; }
+};
+
+} // namespace flowflat
+
+#endif // FLATBUFFER_FLOWFLAT_STREAM_H
@@ -0,0 +1,254 @@
+#ifndef FLATBUFFER_FLOWFLAT_VERIFIER_H
+#define FLATBUFFER_FLOWFLAT_VERIFIER_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "flowflat.h"
+
+namespace flowflat {
+
+/*
+ * Checks that an untrusted buffer can be accessed safely. Generated code drives the verifier: every table type has a
+ * `verify` function which checks its fields and recurses into the objects they reference.
+ *
+ * All checks record failures in a sticky flag instead of returning early. A check which fails (or which gets an absent
+ * object as input) returns 0, so generated code can chain checks without branching on every result and only has to
+ * test the flag once per table.
+ *
+ * Tables which use the vtable of the generated code -- which is the case for every buffer written with the same schema
+ * -- are recognized with a single comparison. For these the layout of the inline data is known at compile time and
+ * only the extent of the inline data has to be checked instead of each field.
+ *
+ * Besides the nesting depth the verifier limits the total number of tables it visits. Tables can be shared, so without
+ * this limit a small hostile buffer (vectors whose elements all reference the same table, which again holds such a
+ * vector) makes verification take time exponential in the depth.
+ *
+ * The verifier doesn't allocate.
+ */
+class Verifier {
+	char const* buffer;
+	std::size_t bufferSize;
+	unsigned depth = 0;
+	unsigned maxDepth;
+	std::size_t tables = 0;
+	std::size_t maxTables;
+	bool valid = true;
+
+	bool check(bool condition) {
+		valid &= condition;
+		return condition;
+	}
+
+	[[nodiscard]] bool inBounds(std::size_t position, std::size_t bytes) const {
+		return position <= bufferSize && bytes <= bufferSize - position;
+	}
+
+public:
+	// a table which passed enterTable
+	struct Table {
+		std::size_t position = 0;
+		std::size_t vtable = 0;
+		voffset_t vtableSize = 0;
+		voffset_t inlineSize = 0;
+		// the table uses the static vtable of its type
+		bool isStatic = false;
+	};
+
+	// maxDepth limits how deeply tables can be nested, maxTables how many tables are visited in total (a table which is
+	// referenced more than once counts every time)
+	Verifier(char const* buffer, std::size_t size, unsigned maxDepth = 64, std::size_t maxTables = 1000000)
+	  : buffer(buffer), bufferSize(size), maxDepth(maxDepth), maxTables(maxTables) {}
+
+	[[nodiscard]] bool ok() const { return valid; }
+	[[nodiscard]] char const* data() const { return buffer; }
+
+	// returns the position of the root table. at is the position of the root reference.
+	std::size_t root(std::size_t at = 0) {
+		if (!check(inBounds(at, sizeof(uoffset_t)))) {
+			return 0;
+		}
+		auto target = at + std::size_t(load<uoffset_t>(buffer + at));
+		return check(target < bufferSize) ? target : 0;
+	}
+
+	// checks the size prefix and restricts the verifier to the size it announces, returns the position of the root
+	std::size_t sizePrefixedRoot() {
+		if (!check(inBounds(0, sizeof(uint32_t)))) {
+			return 0;
+		}
+		auto size = std::size_t(load<uint32_t>(buffer));
+		if (!check(size <= bufferSize - sizeof(uint32_t))) {
+			return 0;
+		}
+		bufferSize = sizeof(uint32_t) + size;
+		return root(sizeof(uint32_t));
+	}
+
+	// follows the reference at position, returns the position of the referenced object (0 for null references)
+	std::size_t reference(std::size_t position) {
+		if (position == 0) {
+			return 0;
+		}
+		auto target = position + load<uoffset_t>(buffer + position);
+		return check(target < bufferSize) && target != position ? target : 0;
+	}
+
+	// checks the table header and its vtable. staticVTable is the vtable of the generated code for the type.
+	bool enterTable(std::size_t position, std::size_t alignment, voffset_t const* staticVTable, Table& table) {
+		if (!check(valid && ++depth <= maxDepth && ++tables <= maxTables && position != 0 && position % alignment == 0 &&
+		           inBounds(position, sizeof(soffset_t)))) {
+			return false;
+		}
+		auto vtable = int64_t(position) - load<soffset_t>(buffer + position);
+		if (!check(vtable >= 0 && vtable % alignof(voffset_t) == 0 && inBounds(vtable, 2 * sizeof(voffset_t)))) {
+			return false;
+		}
+		table.position = position;
+		table.vtable = std::size_t(vtable);
+		table.vtableSize = load<voffset_t>(buffer + vtable);
+		table.inlineSize = load<voffset_t>(buffer + vtable + sizeof(voffset_t));
+		if (!check(table.vtableSize >= voffset_t(2 * sizeof(voffset_t)) && table.vtableSize % 2 == 0 &&
+		           table.inlineSize >= voffset_t(sizeof(soffset_t)) && inBounds(table.vtable, table.vtableSize) &&
+		           inBounds(position, table.inlineSize))) {
+			return false;
+		}
+		table.isStatic =
+		    table.vtableSize == staticVTable[0] && std::memcmp(buffer + vtable, staticVTable, staticVTable[0]) == 0;
+		return true;
+	}
+
+	// has to be called after the fields of a table were verified, returns whether the buffer is still valid
+	bool leaveTable() {
+		--depth;
+		return valid;
+	}
+
+	// returns the position of a field of the table or 0 if the field is absent. staticOffset is the offset of the field
+	// in the static vtable.
+	std::size_t field(Table const& table,
+	                  voffset_t slot,
+	                  voffset_t staticOffset,
+	                  std::size_t size,
+	                  std::size_t alignment) {
+		if (table.isStatic) {
+			// enterTable already checked the inline data
+			return table.position + staticOffset;
+		}
+		auto offset = slot < table.vtableSize ? load<voffset_t>(buffer + table.vtable + slot) : voffset_t(0);
+		if (offset == 0) {
+			return 0;
+		}
+		auto position = table.position + offset;
+		return check(offset >= voffset_t(sizeof(soffset_t)) &&
+		             std::size_t(offset) + size <= std::size_t(table.inlineSize) && position % alignment == 0)
+		           ? position
+		           : 0;
+	}
+
+	// checks the string at position (if it isn't null)
+	void string(std::size_t position) {
+		if (position == 0 || !check(position % sizeof(uint32_t) == 0 && inBounds(position, sizeof(uint32_t)))) {
+			return;
+		}
+		auto length = std::size_t(load<uint32_t>(buffer + position));
+		check(inBounds(position + sizeof(uint32_t), length + 1) && buffer[position + sizeof(uint32_t) + length] == 0);
+	}
+
+	// checks the extent of the vector at position, returns position or 0 if the vector is null or invalid
+	std::size_t vector(std::size_t position, std::size_t elementSize, std::size_t alignment) {
+		alignment = std::max(alignment, sizeof(uint32_t));
+		if (position == 0 || !check((position + sizeof(uint32_t)) % alignment == 0 &&
+		                            inBounds(position, sizeof(uint32_t)))) {
+			return 0;
+		}
+		auto bytes = std::size_t(load<uint32_t>(buffer + position)) * elementSize;
+		return check(inBounds(position + sizeof(uint32_t), bytes)) ? position : 0;
+	}
+
+	// checks a vector of strings or tables. In addition to the extent of the vector this checks that no element is null
+	// and that every element points into the buffer. The elements themselves still have to be checked.
+	std::size_t references(std::size_t position) {
+		position = vector(position, sizeof(uoffset_t), sizeof(uoffset_t));
+		if (position == 0) {
+			return 0;
+		}
+		auto n = count(position);
+		auto first = position + sizeof(uint32_t);
+		// element i is valid if 0 < offset_i <= bufferSize - 4 - (first + 4i), the right hand side can't underflow as
+		// the vector is in bounds
+		auto limit = bufferSize - sizeof(uint32_t) - first;
+		uint32_t i = 0;
+		bool bad = false;
+#ifdef __SSE2__
+		// four elements at a time: an unsigned comparison is a signed comparison with the sign bits flipped
+		if (bufferSize <= std::numeric_limits<uint32_t>::max()) {
+			auto const bias = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+			auto const step = _mm_set1_epi32(16);
+			auto limits = _mm_xor_si128(_mm_setr_epi32(int32_t(limit), int32_t(limit - 4), int32_t(limit - 8),
+			                                           int32_t(limit - 12)),
+			                            bias);
+			auto errors = _mm_setzero_si128();
+			for (; i + 4 <= n; i += 4) {
+				auto offsets = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buffer + first + 4 * std::size_t(i)));
+				errors = _mm_or_si128(errors, _mm_cmpeq_epi32(offsets, _mm_setzero_si128()));
+				errors = _mm_or_si128(errors, _mm_cmpgt_epi32(_mm_xor_si128(offsets, bias), limits));
+				limits = _mm_sub_epi32(limits, step);
+			}
+			bad = _mm_movemask_epi8(errors) != 0;
+		}
+#endif
+		for (; i < n; ++i) {
+			auto offset = load<uoffset_t>(buffer + first + 4 * std::size_t(i));
+			bad |= offset == 0 || offset > limit - 4 * std::size_t(i);
+		}
+		return check(!bad) ? position : 0;
+	}
+
+	// the number of elements of a vector which passed vector or references
+	[[nodiscard]] uint32_t count(std::size_t vector) const { return load<uint32_t>(buffer + vector); }
+
+	// the position of the object referenced by element i of a vector which passed references
+	[[nodiscard]] std::size_t element(std::size_t vector, uint32_t i) const {
+		auto position = vector + sizeof(uint32_t) + sizeof(uoffset_t) * std::size_t(i);
+		return position + load<uoffset_t>(buffer + position);
+	}
+
+	// checks the strings of a vector which passed references (if it isn't null)
+	void strings(std::size_t vector) {
+		if (vector == 0) {
+			return;
+		}
+		for (uint32_t i = 0, n = count(vector); i < n; ++i) {
+			string(element(vector, i));
+		}
+	}
+
+	// checks the nested buffer held by a vector of bytes which passed vector (if it isn't null or empty). Root is the
+	// generated root type of the nested buffer. The nested buffer gets its own verifier, as its offsets are relative to
+	// its own start, but it shares the depth and table limits.
+	template <class Root>
+	void nested(std::size_t vector) {
+		if (vector == 0 || count(vector) == 0 || !valid) {
+			return;
+		}
+		Verifier inner(buffer + vector + sizeof(uint32_t), count(vector), maxDepth - depth, maxTables - tables);
+		check(Root::verify(inner, inner.root()) && inner.ok());
+		tables += inner.tables;
+	}
+
+	// returns the tag of the union at position, 0 if the union is empty or the tag is invalid
+	uint32_t unionTag(std::size_t position, uint32_t numMembers) {
+		auto tag = load<uint32_t>(buffer + position);
+		return check(tag <= numMembers) ? tag : 0;
+	}
+};
+
+} // namespace flowflat
+
+#endif // FLATBUFFER_FLOWFLAT_VERIFIER_H
@@ -0,0 +1,136 @@
+#ifndef FLATBUFFER_FLOWFLAT_VIEW_H
+#define FLATBUFFER_FLOWFLAT_VIEW_H
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+#include "flowflat.h"
+#include "span.h"
+
+/*
+ * Building blocks for the generated buffer views. A view is a pointer to a table in a buffer, its accessors decode
+ * fields on every call and never allocate. Views don't check anything, buffers from untrusted sources have to be
+ * verified first.
+ *
+ * A null view (the view of an absent table) behaves like a table without any fields: every accessor returns the
+ * default value of its field.
+ */
+namespace flowflat {
+
+// the position of a field or nullptr if the field is absent
+[[nodiscard]] inline char const* field(char const* table, voffset_t slot) {
+	if (table == nullptr) {
+		return nullptr;
+	}
+	auto offset = fieldOffset(table, slot);
+	return offset ? table + offset : nullptr;
+}
+
+template <class T>
+[[nodiscard]] inline T scalar(char const* table, voffset_t slot, T defaultValue) {
+	auto p = field(table, slot);
+	return p ? load<T>(p) : defaultValue;
+}
+
+// the object referenced by a string, vector or table field, nullptr if the field is absent
+[[nodiscard]] inline char const* reference(char const* table, voffset_t slot) {
+	auto p = field(table, slot);
+	return p ? followOrNull(p) : nullptr;
+}
+
+[[nodiscard]] inline std::string_view string(char const* table, voffset_t slot, std::string_view defaultValue = {}) {
+	auto p = reference(table, slot);
+	return p ? loadString(p) : defaultValue;
+}
+
+// the table held by a union field if its tag is `tag`, nullptr otherwise
+[[nodiscard]] inline char const* unionTable(char const* table, voffset_t slot, uint32_t tag) {
+	auto p = field(table, slot);
+	return p && load<uint32_t>(p) == tag ? followOrNull(p + sizeof(uint32_t)) : nullptr;
+}
+
+// overwrites a field in place, returns false if the field is absent
+template <class T>
+inline bool mutate(char* table, voffset_t slot, T value) {
+	auto p = const_cast<char*>(field(table, slot));
+	if (p) {
+		store(p, value);
+	}
+	return p != nullptr;
+}
+
+[[nodiscard]] inline bool loadBool(char const* p) {
+	return load<uint8_t>(p) != 0;
+}
+
+// p points to the reference to the string
+[[nodiscard]] inline std::string_view loadStringReference(char const* p) {
+	return loadString(follow(p));
+}
+
+// The elements of a vector in a buffer. Load decodes the element at a position.
+template <class T, std::size_t Stride, T (*Load)(char const*)>
+class VectorView {
+	char const* elements = nullptr;
+	uint32_t count = 0;
+
+public:
+	class iterator {
+		char const* p = nullptr;
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = T;
+
+		iterator() = default;
+		explicit iterator(char const* p) : p(p) {}
+		[[nodiscard]] T operator*() const { return Load(p); }
+		iterator& operator++() {
+			p += Stride;
+			return *this;
+		}
+		iterator operator++(int) {
+			auto res = *this;
+			p += Stride;
+			return res;
+		}
+		[[nodiscard]] bool operator==(iterator const& rhs) const { return p == rhs.p; }
+		[[nodiscard]] bool operator!=(iterator const& rhs) const { return p != rhs.p; }
+	};
+
+	VectorView() = default;
+	// vector points to the element count, nullptr for absent vectors
+	explicit VectorView(char const* vector)
+	  : elements(vector ? vector + sizeof(uint32_t) : nullptr), count(vector ? load<uint32_t>(vector) : 0) {}
+
+	[[nodiscard]] uint32_t size() const { return count; }
+	[[nodiscard]] bool empty() const { return count == 0; }
+	[[nodiscard]] char const* data() const { return elements; }
+	[[nodiscard]] T operator[](uint32_t idx) const { return Load(elements + Stride * idx); }
+	[[nodiscard]] iterator begin() const { return iterator(elements); }
+	[[nodiscard]] iterator end() const { return iterator(elements + Stride * count); }
+};
+
+template <class T>
+using ScalarVector = VectorView<T, sizeof(T), load<T>>;
+using BoolVector = VectorView<bool, 1, loadBool>;
+using StringVector = VectorView<std::string_view, sizeof(uoffset_t), loadStringReference>;
+// the elements of a vector of scalars without copying them. Requires a buffer which is aligned to alignof(T).
+template <class T>
+[[nodiscard]] inline Span<T const> borrow(ScalarVector<T> vector) {
+	return Span<T const>(reinterpret_cast<T const*>(vector.data()), vector.size());
+}
+
+// T is a generated struct
+template <class T>
+using StructVector = VectorView<T, T::flowFlatSize, T::readFrom>;
+// T is a generated table
+template <class T>
+using TableVector = VectorView<typename T::View, sizeof(uoffset_t), T::View::follow>;
+
+} // namespace flowflat
+
+#endif // FLATBUFFER_FLOWFLAT_VIEW_H
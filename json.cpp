@@ -0,0 +1,837 @@
+#include "flowflat/json.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace flowflat::json {
+
+using namespace reflection;
+
+ParseError::ParseError(std::string const& message, std::size_t position)
+  : std::runtime_error(message + " at offset " + std::to_string(position)), errorPosition(position) {}
+
+namespace {
+
+// the index of the first character in [from, str.size()) which ends a run of plain string characters: a quote, a
+// backslash or a control character. Returns str.size() if there is none.
+std::size_t findSpecial(std::string_view str, std::size_t from) {
+#ifdef __SSE2__
+	auto const quote = _mm_set1_epi8('"');
+	auto const backslash = _mm_set1_epi8('\\');
+	auto const control = _mm_set1_epi8(0x1f);
+	for (; from + 16 <= str.size(); from += 16) {
+		auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(str.data() + from));
+		auto special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+		                            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+		if (auto mask = unsigned(_mm_movemask_epi8(special))) {
+			return from + __builtin_ctz(mask);
+		}
+	}
+#endif
+	for (; from < str.size(); ++from) {
+		auto c = static_cast<unsigned char>(str[from]);
+		if (c == '"' || c == '\\' || c < 0x20) {
+			return from;
+		}
+	}
+	return from;
+}
+
+bool isWhitespace(char c) {
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+	if (cp < 0x80) {
+		out.push_back(char(cp));
+	} else if (cp < 0x800) {
+		out.push_back(char(0xc0 | (cp >> 6)));
+		out.push_back(char(0x80 | (cp & 0x3f)));
+	} else if (cp < 0x10000) {
+		out.push_back(char(0xe0 | (cp >> 12)));
+		out.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+		out.push_back(char(0x80 | (cp & 0x3f)));
+	} else {
+		out.push_back(char(0xf0 | (cp >> 18)));
+		out.push_back(char(0x80 | ((cp >> 12) & 0x3f)));
+		out.push_back(char(0x80 | ((cp >> 6) & 0x3f)));
+		out.push_back(char(0x80 | (cp & 0x3f)));
+	}
+}
+
+bool isNumberChar(char c) {
+	return std::isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+bool isUnsigned(BaseType type) {
+	return type == BaseType::UByte || type == BaseType::UShort || type == BaseType::UInt || type == BaseType::ULong;
+}
+
+bool isFloat(BaseType type) {
+	return type == BaseType::Float || type == BaseType::Double;
+}
+
+// A growing buffer. Everything is referenced by position, as the buffer moves when it grows.
+struct Output {
+	std::string buffer;
+	// type index -> position of the vtable of this type in this buffer
+	std::unordered_map<uint32_t, std::size_t> vtables;
+
+	// writes the vtables of type and of every table a table of this type can reference (pre-order, like generated
+	// writers)
+	void writeVTables(TypeInfo const& type) {
+		if (type.kind == Kind::Union) {
+			for (auto member : type.members) {
+				writeVTables(*member);
+			}
+			return;
+		} else if (type.kind != Kind::Table || !vtables.emplace(type.index, 0).second) {
+			return;
+		}
+		auto at = reserve(type.vtable.size() * sizeof(voffset_t), sizeof(voffset_t));
+		std::memcpy(buffer.data() + at, type.vtable.begin(), type.vtable.size() * sizeof(voffset_t));
+		vtables[type.index] = at;
+		for (auto const& field : type.fields) {
+			if (field.type) {
+				writeVTables(*field.type);
+			}
+		}
+	}
+
+	void align(std::size_t alignment) {
+		buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, '\0');
+	}
+	std::size_t reserve(std::size_t bytes, std::size_t alignment) {
+		align(alignment);
+		auto pos = buffer.size();
+		buffer.resize(pos + bytes, '\0');
+		return pos;
+	}
+	template <class T>
+	void store(std::size_t pos, T value) {
+		std::memcpy(buffer.data() + pos, &value, sizeof(T));
+	}
+	// offsets always point forward, the target is always written after the reference
+	void link(std::size_t from, std::size_t to) { store<uoffset_t>(from, uoffset_t(to - from)); }
+};
+
+/*
+ * Tables have a static layout (the vtable is the same for all tables of one type), so the vtables of all tables the
+ * root can reference are written first, the inline part of a table can be reserved when its object starts and fields
+ * can be filled in the order they appear in the text. Everything a field references (strings, vectors and tables)
+ * gets appended behind it, which keeps all offsets pointing forward.
+ *
+ * Vectors of strings and tables need their number of elements before the first element is written, as the offset
+ * array comes first. A single scan over the text before parsing counts the elements of every array (in the order the
+ * arrays start), so the elements can be written straight behind their offset array.
+ */
+class Parser {
+	std::string_view input;
+	std::size_t pos = 0;
+	// used for keys and enum names which contain escape sequences
+	std::string scratch;
+	// the number of elements of every array in the text, in the order the arrays start
+	std::vector<uint32_t> arrayCounts;
+	std::size_t nextArray = 0;
+
+	[[noreturn]] void fail(std::string const& message) const { throw ParseError(message, pos); }
+
+	void skipWhitespace() {
+#ifdef __SSE2__
+		// whitespace runs are usually short, so only the first chunk is checked with simd
+		if (pos + 16 <= input.size()) {
+			auto chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input.data() + pos));
+			auto ws = _mm_or_si128(
+			    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+			    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+			if (auto mask = ~unsigned(_mm_movemask_epi8(ws)) & 0xffffu) {
+				pos += __builtin_ctz(mask);
+				return;
+			}
+			pos += 16;
+		}
+#endif
+		while (pos < input.size() && isWhitespace(input[pos])) {
+			++pos;
+		}
+	}
+
+	char peek() {
+		skipWhitespace();
+		if (pos >= input.size()) {
+			fail("unexpected end of input");
+		}
+		return input[pos];
+	}
+
+	bool consume(char c) {
+		if (peek() == c) {
+			++pos;
+			return true;
+		}
+		return false;
+	}
+
+	void expect(char c) {
+		if (!consume(c)) {
+			fail(std::string("expected '") + c + "'");
+		}
+	}
+
+	bool consumeLiteral(std::string_view literal) {
+		skipWhitespace();
+		if (input.substr(pos, literal.size()) == literal) {
+			pos += literal.size();
+			return true;
+		}
+		return false;
+	}
+
+	uint32_t hex4() {
+		if (pos + 4 > input.size()) {
+			fail("invalid unicode escape");
+		}
+		uint32_t res = 0;
+		auto [end, ec] = std::from_chars(input.data() + pos, input.data() + pos + 4, res, 16);
+		if (ec != std::errc() || end != input.data() + pos + 4) {
+			fail("invalid unicode escape");
+		}
+		pos += 4;
+		return res;
+	}
+
+	// parses the rest of a string (after the opening quote) and appends it to out
+	void stringContents(std::string& out) {
+		while (true) {
+			auto special = findSpecial(input, pos);
+			out.append(input.data() + pos, special - pos);
+			pos = special;
+			if (pos >= input.size()) {
+				fail("unterminated string");
+			}
+			auto c = input[pos++];
+			if (c == '"') {
+				return;
+			} else if (c != '\\') {
+				fail("control character in string");
+			} else if (pos >= input.size()) {
+				fail("unterminated string");
+			}
+			switch (input[pos++]) {
+			case '"':
+				out.push_back('"');
+				break;
+			case '\\':
+				out.push_back('\\');
+				break;
+			case '/':
+				out.push_back('/');
+				break;
+			case 'b':
+				out.push_back('\b');
+				break;
+			case 'f':
+				out.push_back('\f');
+				break;
+			case 'n':
+				out.push_back('\n');
+				break;
+			case 'r':
+				out.push_back('\r');
+				break;
+			case 't':
+				out.push_back('\t');
+				break;
+			case 'u': {
+				auto cp = hex4();
+				if (cp >= 0xd800 && cp < 0xdc00) {
+					if (input.substr(pos, 2) != "\\u") {
+						fail("invalid surrogate pair");
+					}
+					pos += 2;
+					auto low = hex4();
+					if (low < 0xdc00 || low >= 0xe000) {
+						fail("invalid surrogate pair");
+					}
+					cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+				}
+				appendUtf8(out, cp);
+				break;
+			}
+			default:
+				fail("invalid escape sequence");
+			}
+		}
+	}
+
+	// keys and enum names almost never contain escape sequences, in which case this doesn't copy
+	std::string_view shortString() {
+		expect('"');
+		auto start = pos;
+		auto end = findSpecial(input, pos);
+		if (end < input.size() && input[end] == '"') {
+			pos = end + 1;
+			return input.substr(start, end - start);
+		}
+		scratch.clear();
+		stringContents(scratch);
+		return scratch;
+	}
+
+	std::string_view numberToken() {
+		skipWhitespace();
+		auto start = pos;
+		while (pos < input.size() && isNumberChar(input[pos])) {
+			++pos;
+		}
+		if (start == pos) {
+			fail("expected a value");
+		}
+		return input.substr(start, pos - start);
+	}
+
+	template <class T>
+	void storeInteger(Output& out, std::size_t at, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t> value) {
+		if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) {
+			fail("integer out of range");
+		}
+		out.store<T>(at, T(value));
+	}
+
+	void storeScalar(BaseType type, Output& out, std::size_t at, Value const& value) {
+		auto asInt = [&value]() {
+			return std::holds_alternative<uint64_t>(value) ? int64_t(std::get<uint64_t>(value))
+			                                               : std::get<int64_t>(value);
+		};
+		auto asUInt = [&value]() {
+			return std::holds_alternative<int64_t>(value) ? uint64_t(std::get<int64_t>(value))
+			                                              : std::get<uint64_t>(value);
+		};
+		switch (type) {
+		case BaseType::Bool:
+			out.store<uint8_t>(at, std::get<bool>(value));
+			break;
+		case BaseType::Byte:
+			storeInteger<int8_t>(out, at, asInt());
+			break;
+		case BaseType::UByte:
+			storeInteger<uint8_t>(out, at, asUInt());
+			break;
+		case BaseType::Short:
+			storeInteger<int16_t>(out, at, asInt());
+			break;
+		case BaseType::UShort:
+			storeInteger<uint16_t>(out, at, asUInt());
+			break;
+		case BaseType::Int:
+			storeInteger<int32_t>(out, at, asInt());
+			break;
+		case BaseType::UInt:
+			storeInteger<uint32_t>(out, at, asUInt());
+			break;
+		case BaseType::Long:
+			storeInteger<int64_t>(out, at, asInt());
+			break;
+		case BaseType::ULong:
+			storeInteger<uint64_t>(out, at, asUInt());
+			break;
+		case BaseType::Float:
+			out.store<float>(at, float(std::get<double>(value)));
+			break;
+		case BaseType::Double:
+			out.store<double>(at, std::get<double>(value));
+			break;
+		case BaseType::String:
+		case BaseType::None:
+			fail("not a scalar");
+		}
+	}
+
+	Value number(BaseType type) {
+		if (isFloat(type)) {
+			// the values the writer uses for floats which aren't finite
+			if (consumeLiteral("nan")) {
+				return std::numeric_limits<double>::quiet_NaN();
+			}
+			if (consumeLiteral("inf") || consumeLiteral("+inf")) {
+				return std::numeric_limits<double>::infinity();
+			}
+			if (consumeLiteral("-inf")) {
+				return -std::numeric_limits<double>::infinity();
+			}
+		}
+		auto token = numberToken();
+		if (isFloat(type)) {
+			// unlike strtod, from_chars doesn't depend on the locale
+			double res;
+			auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), res);
+			if (ec != std::errc() || end != token.data() + token.size()) {
+				fail("invalid number");
+			}
+			return res;
+		}
+		if (isUnsigned(type)) {
+			uint64_t res;
+			auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), res);
+			if (ec != std::errc() || end != token.data() + token.size()) {
+				fail("invalid unsigned integer");
+			}
+			return res;
+		}
+		int64_t res;
+		auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), res);
+		if (ec != std::errc() || end != token.data() + token.size()) {
+			fail("invalid integer");
+		}
+		return res;
+	}
+
+	// scalars and enums
+	void scalar(FieldInfo const& field, Output& out, std::size_t at) {
+		auto c = peek();
+		if (field.baseType == BaseType::Bool) {
+			if (consumeLiteral("true")) {
+				out.store<uint8_t>(at, 1);
+			} else if (consumeLiteral("false")) {
+				out.store<uint8_t>(at, 0);
+			} else {
+				auto v = number(BaseType::Long);
+				out.store<uint8_t>(at, std::get<int64_t>(v) != 0);
+			}
+		} else if (c == '"') {
+			if (!field.type || field.type->kind != Kind::Enum) {
+				fail("expected a number");
+			}
+			auto name = shortString();
+			auto value = field.type->enumValue(name);
+			if (!value) {
+				fail("unknown enumerator " + std::string(name) + " of " + field.type->qualifiedName);
+			}
+			storeScalar(field.baseType, out, at, *value);
+		} else {
+			storeScalar(field.baseType, out, at, number(field.baseType));
+		}
+	}
+
+	std::size_t string(Output& out) {
+		expect('"');
+		auto at = out.reserve(sizeof(uint32_t), sizeof(uint32_t));
+		stringContents(out.buffer);
+		out.store<uint32_t>(at, uint32_t(out.buffer.size() - at - sizeof(uint32_t)));
+		out.buffer.push_back('\0');
+		return at;
+	}
+
+	void structure(TypeInfo const& type, Output& out, std::size_t at) {
+		expect('{');
+		if (consume('}')) {
+			return;
+		}
+		do {
+			auto key = shortString();
+			auto field = type.field(key);
+			if (!field) {
+				fail("unknown field " + std::string(key) + " in " + type.qualifiedName);
+			}
+			expect(':');
+			if (field->isVector || field->baseType == BaseType::String ||
+			    (field->type && field->type->kind != Kind::Struct && field->type->kind != Kind::Enum)) {
+				fail("structs can only contain scalars, enums and structs");
+			} else if (field->type && field->type->kind == Kind::Struct) {
+				structure(*field->type, out, at + field->offset);
+			} else {
+				scalar(*field, out, at + field->offset);
+			}
+		} while (consume(','));
+		expect('}');
+	}
+
+	std::size_t vector(FieldInfo const& element, Output& out) {
+		expect('[');
+		if (nextArray >= arrayCounts.size()) {
+			fail("malformed array");
+		}
+		auto expected = arrayCounts[nextArray++];
+		bool inlineElements = element.baseType != BaseType::String &&
+		                      (!element.type || element.type->kind == Kind::Enum || element.type->kind == Kind::Struct);
+		if (inlineElements) {
+			// elements are stored back to back and the first element is aligned
+			auto alignment = std::max<std::size_t>(sizeof(uint32_t), element.alignment);
+			out.align(alignment);
+			out.reserve(alignment - sizeof(uint32_t), 1);
+			auto at = out.reserve(sizeof(uint32_t), sizeof(uint32_t));
+			uint32_t count = 0;
+			if (!consume(']')) {
+				do {
+					auto elem = out.reserve(element.size, 1);
+					if (element.type && element.type->kind == Kind::Struct) {
+						structure(*element.type, out, elem);
+					} else {
+						scalar(element, out, elem);
+					}
+					++count;
+				} while (consume(','));
+				expect(']');
+			}
+			out.store<uint32_t>(at, count);
+			return at;
+		}
+		if (element.type && element.type->kind == Kind::Union) {
+			fail("vectors of unions are not supported");
+		}
+		auto at = out.reserve(sizeof(uint32_t) * (std::size_t(expected) + 1), sizeof(uint32_t));
+		out.store<uint32_t>(at, expected);
+		uint32_t count = 0;
+		if (!consume(']')) {
+			do {
+				if (count == expected) {
+					fail("malformed array");
+				}
+				auto elem = element.type ? table(*element.type, out) : string(out);
+				out.link(at + sizeof(uint32_t) * ++count, elem);
+			} while (consume(','));
+			expect(']');
+		}
+		if (count != expected) {
+			fail("malformed array");
+		}
+		return at;
+	}
+
+	void field(FieldInfo const& field, Output& out, std::size_t at) {
+		if (field.isVector) {
+			auto v = vector(field.element(), out);
+			out.link(at, v);
+		} else if (field.baseType == BaseType::String) {
+			auto s = string(out);
+			out.link(at, s);
+		} else if (field.baseType != BaseType::None) {
+			scalar(field, out, at);
+		} else if (field.type->kind == Kind::Struct) {
+			structure(*field.type, out, at);
+		} else if (field.type->kind == Kind::Table) {
+			auto t = table(*field.type, out);
+			out.link(at, t);
+		} else {
+			auto tag = load<uint32_t>(out.buffer.data() + at);
+			if (tag == 0 || tag > field.type->members.size()) {
+				fail("the type of union " + std::string(field.name) + " has to be set before its value");
+			}
+			auto t = table(*field.type->members[tag - 1], out);
+			out.link(at + sizeof(uint32_t), t);
+		}
+	}
+
+	// handles `x_type` keys of union fields, returns false if key is not the type of a union
+	bool unionType(TypeInfo const& type, std::string_view key, Output& out, std::size_t table) {
+		constexpr std::string_view suffix = "_type";
+		if (key.size() <= suffix.size() || key.substr(key.size() - suffix.size()) != suffix) {
+			return false;
+		}
+		auto field = type.field(key.substr(0, key.size() - suffix.size()));
+		if (!field || field->isVector || !field->type || field->type->kind != Kind::Union) {
+			return false;
+		}
+		expect(':');
+		uint32_t tag = 0;
+		if (peek() == '"') {
+			auto name = shortString();
+			for (uint32_t i = 0; i < field->type->members.size() && tag == 0; ++i) {
+				auto const& member = *field->type->members[i];
+				if (member.name == name || member.qualifiedName == name) {
+					tag = i + 1;
+				}
+			}
+			if (tag == 0 && name != "NONE") {
+				fail("unknown type " + std::string(name) + " for union " + field->type->qualifiedName);
+			}
+		} else {
+			tag = uint32_t(std::get<uint64_t>(number(BaseType::UInt)));
+			if (tag > field->type->members.size()) {
+				fail("invalid union tag");
+			}
+		}
+		out.store<uint32_t>(table + field->offset, tag);
+		return true;
+	}
+
+	// counts the elements of every array. Malformed text is only skipped here, parsing reports the error.
+	void countArrays() {
+		// index into arrayCounts for arrays, npos for objects. The flag is set while the current element is counted.
+		std::vector<std::pair<std::size_t, bool>> open;
+		for (std::size_t i = 0; i < input.size(); ++i) {
+			auto c = input[i];
+			if (isWhitespace(c) || c == ':') {
+				continue;
+			}
+			auto inArray = !open.empty() && open.back().first != std::string_view::npos;
+			if (c == ',') {
+				if (inArray) {
+					open.back().second = false;
+				}
+				continue;
+			} else if (c == ']' || c == '}') {
+				if (!open.empty()) {
+					open.pop_back();
+				}
+				continue;
+			}
+			if (inArray && !open.back().second) {
+				++arrayCounts[open.back().first];
+				open.back().second = true;
+			}
+			if (c == '[') {
+				open.emplace_back(arrayCounts.size(), false);
+				arrayCounts.push_back(0);
+			} else if (c == '{') {
+				open.emplace_back(std::string_view::npos, false);
+			} else if (c == '"') {
+				// skip the string, escaped characters can't end it
+				for (i = findSpecial(input, i + 1); i < input.size() && input[i] != '"';
+				     i = findSpecial(input, i + (input[i] == '\\' ? 2 : 1))) {
+				}
+			}
+		}
+	}
+
+public:
+	explicit Parser(std::string_view input) : input(input) { countArrays(); }
+
+	std::size_t table(TypeInfo const& type, Output& out) {
+		if (type.kind != Kind::Table) {
+			fail(type.qualifiedName + " is not a table");
+		}
+		expect('{');
+		auto const& vtable = type.vtable;
+		auto vtablePos = out.vtables.at(type.index);
+		auto at = out.reserve(std::size_t(vtable[1]), type.type->alignment);
+		out.store<soffset_t>(at, soffset_t(at - vtablePos));
+		for (auto const& f : type.fields) {
+			if (!f.isVector && f.isScalar() && f.field->hasDefault()) {
+				storeScalar(f.baseType, out, at + f.offset, f.defaultValue);
+			}
+		}
+		if (consume('}')) {
+			return at;
+		}
+		do {
+			auto key = shortString();
+			auto field = type.field(key);
+			if (!field) {
+				// key might point into scratch which gets overwritten when the union type is parsed
+				if (unionType(type, std::string(key), out, at)) {
+					continue;
+				}
+				fail("unknown field " + std::string(key) + " in " + type.qualifiedName);
+			}
+			expect(':');
+			if (consumeLiteral("null")) {
+				continue;
+			}
+			this->field(*field, out, at + field->offset);
+		} while (consume(','));
+		expect('}');
+		return at;
+	}
+
+	void finish() {
+		skipWhitespace();
+		if (pos != input.size()) {
+			fail("unexpected characters after the root object");
+		}
+	}
+};
+
+class Writer {
+	std::string& out;
+
+	void string(std::string_view str) {
+		out.push_back('"');
+		std::size_t pos = 0;
+		while (pos < str.size()) {
+			auto special = findSpecial(str, pos);
+			out.append(str.data() + pos, special - pos);
+			if (special == str.size()) {
+				break;
+			}
+			auto c = str[special];
+			switch (c) {
+			case '"':
+				out.append("\\\"");
+				break;
+			case '\\':
+				out.append("\\\\");
+				break;
+			case '\n':
+				out.append("\\n");
+				break;
+			case '\r':
+				out.append("\\r");
+				break;
+			case '\t':
+				out.append("\\t");
+				break;
+			default: {
+				char buf[8];
+				std::snprintf(buf, sizeof(buf), "\\u%04x", unsigned(static_cast<unsigned char>(c)));
+				out.append(buf);
+			}
+			}
+			pos = special + 1;
+		}
+		out.push_back('"');
+	}
+
+	template <class T>
+	void integer(T value) {
+		char buf[24];
+		auto [end, _] = std::to_chars(buf, buf + sizeof(buf), value);
+		out.append(buf, end);
+	}
+
+	void floatingPoint(double value, BaseType type) {
+		if (std::isnan(value)) {
+			out.append("nan");
+		} else if (std::isinf(value)) {
+			out.append(value < 0 ? "-inf" : "inf");
+		} else {
+			// the shortest representation that round trips, independent of the locale
+			char buf[32];
+			auto [end, _] = type == BaseType::Float ? std::to_chars(buf, buf + sizeof(buf), float(value))
+			                                        : std::to_chars(buf, buf + sizeof(buf), value);
+			out.append(buf, end);
+		}
+	}
+
+	void value(FieldInfo const& field, Value const& v) {
+		std::visit(
+		    [this, &field](auto const& x) {
+			    using T = std::decay_t<decltype(x)>;
+			    if constexpr (std::is_same_v<T, std::monostate>) {
+				    out.append("null");
+			    } else if constexpr (std::is_same_v<T, bool>) {
+				    out.append(x ? "true" : "false");
+			    } else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>) {
+				    if (field.type && field.type->kind == Kind::Enum) {
+					    if (auto name = field.type->enumName(int64_t(x)); !name.empty()) {
+						    string(name);
+						    return;
+					    }
+				    }
+				    integer(x);
+			    } else if constexpr (std::is_same_v<T, double>) {
+				    floatingPoint(x, field.baseType);
+			    } else if constexpr (std::is_same_v<T, std::string_view>) {
+				    string(x);
+			    } else if constexpr (std::is_same_v<T, Struct>) {
+				    structure(x);
+			    } else if constexpr (std::is_same_v<T, Table>) {
+				    table(x);
+			    } else if constexpr (std::is_same_v<T, Vector>) {
+				    vector(x);
+			    } else {
+				    if (auto t = x.table()) {
+					    table(*t);
+				    } else {
+					    out.append("null");
+				    }
+			    }
+		    },
+		    v);
+	}
+
+	void key(std::string_view name, bool& first) {
+		if (!first) {
+			out.push_back(',');
+		}
+		first = false;
+		string(name);
+		out.push_back(':');
+	}
+
+	void structure(Struct const& s) {
+		out.push_back('{');
+		bool first = true;
+		for (auto const& field : s.type().fields) {
+			key(field.name, first);
+			value(field, s.get(field));
+		}
+		out.push_back('}');
+	}
+
+	void vector(Vector const& v) {
+		out.push_back('[');
+		for (uint32_t i = 0; i < v.size(); ++i) {
+			if (i > 0) {
+				out.push_back(',');
+			}
+			value(v.elementInfo(), v[i]);
+		}
+		out.push_back(']');
+	}
+
+public:
+	explicit Writer(std::string& out) : out(out) {}
+
+	void table(Table const& t) {
+		out.push_back('{');
+		bool first = true;
+		for (auto const& field : t.type().fields) {
+			if (field.field->isDeprecated()) {
+				continue;
+			}
+			auto v = t.get(field);
+			if (std::holds_alternative<std::monostate>(v)) {
+				continue;
+			}
+			if (auto u = std::get_if<Union>(&v)) {
+				auto member = u->memberType();
+				if (!member) {
+					continue;
+				}
+				key(std::string(field.name) + "_type", first);
+				string(member->name);
+			}
+			key(field.name, first);
+			value(field, v);
+		}
+		out.push_back('}');
+	}
+};
+
+} // namespace
+
+std::string toBinary(TypeInfo const& root, std::string_view json) {
+	Output out;
+	out.reserve(sizeof(uoffset_t), sizeof(uoffset_t));
+	out.writeVTables(root);
+	Parser parser(json);
+	auto table = parser.table(root, out);
+	parser.finish();
+	out.link(0, table);
+	return std::move(out.buffer);
+}
+
+void toJson(Table const& table, std::string& out) {
+	Writer(out).table(table);
+}
+
+std::string toJson(Table const& table) {
+	std::string res;
+	toJson(table, res);
+	return res;
+}
+
+} // namespace flowflat::json
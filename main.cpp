@@ -1,6 +1,12 @@
+#include <algorithm>
 #include <string_view>
 #include <string>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <optional>
 #include <fmt/format.h>
 
 #include "flatbuffers/Compiler.h"
@@ -8,6 +14,83 @@
 using namespace std::string_view_literals;
 using namespace std::string_literals;
 
+// counts allocations for --time-report
+void* operator new(std::size_t size) {
+	++flatbuffers::threadAllocations;
+	if (auto res = std::malloc(size ? size : 1)) {
+		return res;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+// used by the standard library (e.g. std::stable_sort), these have to allocate with malloc as well
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept {
+	++flatbuffers::threadAllocations;
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const& tag) noexcept {
+	return operator new(size, tag);
+}
+
+// over-aligned types. aligned_alloc needs the size to be a non-zero multiple of the alignment.
+void* operator new(std::size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+	++flatbuffers::threadAllocations;
+	auto a = static_cast<std::size_t>(alignment);
+	return std::aligned_alloc(a, std::max(a, (size + a - 1) / a * a));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, std::nothrow_t const& tag) noexcept {
+	return operator new(size, alignment, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	if (auto res = operator new(size, alignment, std::nothrow)) {
+		return res;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+
 int main(int argc, const char* argv[]) {
 	if (argc < 2) {
 		return 1;
@@ -16,6 +99,11 @@ int main(int argc, const char* argv[]) {
 	std::vector<std::string> includePaths;
 	std::string sourceDir;
 	std::string headerDir;
+	std::optional<std::string> binarySchemaDir;
+	flatbuffers::GeneratorOptions options;
+	bool timeReport = false;
+	std::optional<std::string> timeTrace;
+	std::optional<std::string> layoutProfile;
 
 	int i = 1;
 	auto expectValue = [argv, &i, argc]() {
@@ -40,8 +128,41 @@ int main(int argc, const char* argv[]) {
 			++i;
 			expectValue();
 			headerDir = argv[i];
+		} else if (argv[i] == "-b"sv) {
+			++i;
+			expectValue();
+			binarySchemaDir = argv[i];
+		} else if (argv[i] == "--borrowed"sv) {
+			options.borrowed = true;
+		} else if (argv[i] == "--pmr"sv) {
+			options.pmr = true;
+		} else if (argv[i] == "--profile-access"sv) {
+			options.profileAccess = true;
+		} else if (argv[i] == "--layout-profile"sv) {
+			++i;
+			expectValue();
+			layoutProfile = argv[i];
+		} else if (argv[i] == "--time-report"sv) {
+			timeReport = true;
+		} else if (argv[i] == "--time-trace"sv) {
+			++i;
+			expectValue();
+			timeTrace = argv[i];
 		} else if (argv[i] == "-h"sv || argv[i] == "--help"sv) {
-			fmt::print("Usage: {} [-I include-path]* [-s sourceDir] [-i headerDir] [-h] [--] (idl_file.fbs)+", argv[0]);
+			fmt::print("Usage: {} [-I include-path]* [-s sourceDir] [-i headerDir] [-b binarySchemaDir] "
+			           "[--borrowed] [--pmr] [--profile-access] [--layout-profile file] [--time-report] "
+			           "[--time-trace file] [-h] [--] "
+			           "(idl_file.fbs|idl_file.bfbs)+\n",
+			           argv[0]);
+			fmt::print("  --borrowed: generate non-owning types (std::string_view, flowflat::Span) for strings and\n"
+			           "              vectors of the given files\n");
+			fmt::print("  --pmr:      generate std::pmr containers and allocator aware tables for the given files\n");
+			fmt::print("  --profile-access: generate views which count field accesses (see flowflat/profile.h) for\n"
+			           "                    the given files\n");
+			fmt::print("  --layout-profile: place the most accessed fields of every table in the first cache line of\n"
+			           "                    its inline data (the profile is written by flowflat::profile::dump)\n");
+			fmt::print("  --time-report: print the time and allocations every file spent in every compiler phase\n");
+			fmt::print("  --time-trace:  write the compiler phases as a Chrome trace (chrome://tracing, Perfetto)\n");
 			return 0;
 		} else if (argv[i] == "--"sv) {
 			++i;
@@ -54,11 +175,31 @@ int main(int argc, const char* argv[]) {
 	}
 
 	flatbuffers::Compiler compiler(includePaths);
+	if (timeReport || timeTrace) {
+		compiler.timeReport().enable();
+	}
+	if (layoutProfile) {
+		compiler.loadLayoutProfile(*layoutProfile);
+	}
 	for (; i < argc; ++i) {
-		compiler.compile(argv[i]);
+		compiler.compile(argv[i], options);
 	}
 	compiler.generateCode(headerDir, sourceDir);
+	if (binarySchemaDir) {
+		compiler.writeBinarySchemas(*binarySchemaDir);
+	}
 	compiler.describeTables();
+	if (timeReport) {
+		compiler.timeReport().printSummary(std::cout);
+	}
+	if (timeTrace) {
+		std::ofstream out(*timeTrace, std::ios::trunc);
+		compiler.timeReport().writeTrace(out);
+		if (!out) {
+			fmt::print(stderr, "Error: Can't write time trace {}\n", *timeTrace);
+			return 1;
+		}
+	}
 
 	//	for (int i = 1; i < argc; ++i) {
 	//		fmt::print("Parsing file: {}\n", argv[i]);
@@ -0,0 +1,93 @@
+#include "flowflat/profile.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace flowflat::profile {
+
+namespace detail {
+
+thread_local unsigned decoding = 0;
+
+} // namespace detail
+
+namespace {
+
+struct Table {
+	std::vector<std::string> fields;
+	// one block of counters per thread, kept after the thread exited
+	std::vector<std::unique_ptr<std::atomic<uint64_t>[]>> threads;
+};
+
+struct Registry {
+	std::mutex mutex;
+	std::map<std::string, Table, std::less<>> tables;
+};
+
+Registry& registry() {
+	static Registry res;
+	return res;
+}
+
+} // namespace
+
+std::atomic<uint64_t>* detail::threadCounters(std::string_view table,
+                                               std::string_view const* fields,
+                                               std::size_t numFields) {
+	auto& r = registry();
+	std::lock_guard lock(r.mutex);
+	auto iter = r.tables.find(table);
+	if (iter == r.tables.end()) {
+		iter = r.tables.emplace(std::string(table), Table{ { fields, fields + numFields }, {} }).first;
+	}
+	auto& block = iter->second.threads.emplace_back(new std::atomic<uint64_t>[numFields + 1]);
+	for (std::size_t i = 0; i <= numFields; ++i) {
+		block[i].store(0, std::memory_order_relaxed);
+	}
+	return block.get();
+}
+
+std::vector<TableProfile> snapshot() {
+	auto& r = registry();
+	std::lock_guard lock(r.mutex);
+	std::vector<TableProfile> res;
+	for (auto const& [name, table] : r.tables) {
+		auto& profile = res.emplace_back();
+		profile.table = name;
+		for (auto const& field : table.fields) {
+			profile.fields.push_back(FieldAccesses{ field, 0 });
+		}
+		for (auto const& counters : table.threads) {
+			profile.decodes += counters[0].load(std::memory_order_relaxed);
+			for (std::size_t i = 0; i < profile.fields.size(); ++i) {
+				profile.fields[i].accesses += counters[i + 1].load(std::memory_order_relaxed);
+			}
+		}
+	}
+	return res;
+}
+
+void reset() {
+	auto& r = registry();
+	std::lock_guard lock(r.mutex);
+	for (auto& [_, table] : r.tables) {
+		for (auto& counters : table.threads) {
+			for (std::size_t i = 0; i <= table.fields.size(); ++i) {
+				counters[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+void dump(std::ostream& out) {
+	out << "# flowflat field access profile: <table>.<field> <accesses>\n";
+	for (auto const& table : snapshot()) {
+		out << "# " << table.table << " decoded " << table.decodes << " times\n";
+		for (auto const& f : table.fields) {
+			out << table.table << '.' << f.field << ' ' << f.accesses << '\n';
+		}
+	}
+}
+
+} // namespace flowflat::profile
@@ -0,0 +1,363 @@
+#include "flowflat/reflection.h"
+
+#include <charconv>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace flowflat::reflection {
+
+namespace {
+
+uint32_t scalarSize(BaseType type) {
+	switch (type) {
+	case BaseType::Bool:
+	case BaseType::Byte:
+	case BaseType::UByte:
+		return 1;
+	case BaseType::Short:
+	case BaseType::UShort:
+		return 2;
+	case BaseType::Int:
+	case BaseType::UInt:
+	case BaseType::Float:
+	case BaseType::String:
+		return 4;
+	case BaseType::Long:
+	case BaseType::ULong:
+	case BaseType::Double:
+		return 8;
+	case BaseType::None:
+		break;
+	}
+	return 0;
+}
+
+bool isUnsigned(BaseType type) {
+	return type == BaseType::UByte || type == BaseType::UShort || type == BaseType::UInt || type == BaseType::ULong;
+}
+
+Value loadScalar(BaseType type, char const* p) {
+	switch (type) {
+	case BaseType::Bool:
+		return load<uint8_t>(p) != 0;
+	case BaseType::Byte:
+		return int64_t(load<int8_t>(p));
+	case BaseType::UByte:
+		return uint64_t(load<uint8_t>(p));
+	case BaseType::Short:
+		return int64_t(load<int16_t>(p));
+	case BaseType::UShort:
+		return uint64_t(load<uint16_t>(p));
+	case BaseType::Int:
+		return int64_t(load<int32_t>(p));
+	case BaseType::UInt:
+		return uint64_t(load<uint32_t>(p));
+	case BaseType::Long:
+		return load<int64_t>(p);
+	case BaseType::ULong:
+		return load<uint64_t>(p);
+	case BaseType::Float:
+		return double(load<float>(p));
+	case BaseType::Double:
+		return load<double>(p);
+	case BaseType::String:
+		if (auto str = followOrNull(p)) {
+			return loadString(str);
+		}
+		return {};
+	case BaseType::None:
+		break;
+	}
+	return {};
+}
+
+// parses the default value of a scalar field as it was written in the schema
+Value parseDefault(FieldInfo const& info, std::string_view literal) {
+	std::string str(literal);
+	if (info.type && info.type->kind == Kind::Enum) {
+		if (auto v = info.type->enumValue(literal)) {
+			return isUnsigned(info.baseType) ? Value(uint64_t(*v)) : Value(*v);
+		}
+	}
+	switch (info.baseType) {
+	case BaseType::Bool:
+		return literal == "true" || std::strtol(str.c_str(), nullptr, 10) != 0;
+	case BaseType::Float:
+	case BaseType::Double: {
+		// unlike strtod, from_chars doesn't depend on the locale
+		auto number = literal.substr(literal.substr(0, 1) == "+" ? 1 : 0);
+		double res = 0;
+		std::from_chars(number.data(), number.data() + number.size(), res);
+		return res;
+	}
+	case BaseType::String:
+		return literal;
+	default:
+		if (isUnsigned(info.baseType)) {
+			return uint64_t(std::strtoull(str.c_str(), nullptr, 0));
+		}
+		return int64_t(std::strtoll(str.c_str(), nullptr, 0));
+	}
+}
+
+// absent scalar fields without a default are 0
+Value zero(BaseType type) {
+	switch (type) {
+	case BaseType::Bool:
+		return false;
+	case BaseType::Float:
+	case BaseType::Double:
+		return 0.0;
+	case BaseType::None:
+	case BaseType::String:
+		return {};
+	default:
+		return isUnsigned(type) ? Value(uint64_t(0)) : Value(int64_t(0));
+	}
+}
+
+} // namespace
+
+Value decode(FieldInfo const& field, char const* p) {
+	if (field.isVector) {
+		if (auto v = followOrNull(p)) {
+			return Vector(&field.element(), v + sizeof(uint32_t), load<uint32_t>(v));
+		}
+		return {};
+	}
+	if (field.baseType != BaseType::None) {
+		return loadScalar(field.baseType, p);
+	}
+	switch (field.type->kind) {
+	case Kind::Struct:
+		return Struct(field.type, p);
+	case Kind::Table:
+		if (auto table = followOrNull(p)) {
+			return Table(field.type, table);
+		}
+		return {};
+	case Kind::Union: {
+		auto tag = load<uint32_t>(p);
+		auto table = followOrNull(p + sizeof(uint32_t));
+		return tag && table ? Union(field.type, tag, table) : Union(field.type, 0, nullptr);
+	}
+	case Kind::Enum:
+		break;
+	}
+	return {};
+}
+
+Value Struct::get(FieldInfo const& field) const {
+	return decode(field, data + field.offset);
+}
+
+Value Struct::get(std::string_view name) const {
+	auto field = info->field(name);
+	if (!field) {
+		throw std::out_of_range(std::string("no field ") + std::string(name) + " in " + info->qualifiedName);
+	}
+	return get(*field);
+}
+
+bool Table::has(FieldInfo const& field) const {
+	return fieldOffset(data, field.slot) != 0;
+}
+
+std::string_view Table::string(FieldInfo const& field) const {
+	if (auto offset = fieldOffset(data, field.slot); offset && load<uoffset_t>(data + offset)) {
+		return loadString(follow(data + offset));
+	}
+	auto def = std::get_if<std::string_view>(&field.defaultValue);
+	return def ? *def : std::string_view();
+}
+
+std::optional<Table> Table::table(FieldInfo const& field) const {
+	if (auto offset = fieldOffset(data, field.slot); offset && load<uoffset_t>(data + offset)) {
+		return Table(field.type, follow(data + offset));
+	}
+	return {};
+}
+
+std::optional<Struct> Table::structure(FieldInfo const& field) const {
+	if (auto offset = fieldOffset(data, field.slot)) {
+		return Struct(field.type, data + offset);
+	}
+	return {};
+}
+
+Vector Table::vector(FieldInfo const& field) const {
+	if (auto offset = fieldOffset(data, field.slot); offset && load<uoffset_t>(data + offset)) {
+		auto v = follow(data + offset);
+		return Vector(&field.element(), v + sizeof(uint32_t), load<uint32_t>(v));
+	}
+	return Vector(&field.element(), nullptr, 0);
+}
+
+Union Table::unionValue(FieldInfo const& field) const {
+	if (auto offset = fieldOffset(data, field.slot)) {
+		return std::get<Union>(decode(field, data + offset));
+	}
+	return Union(field.type, 0, nullptr);
+}
+
+Value Table::get(FieldInfo const& field) const {
+	if (auto offset = fieldOffset(data, field.slot)) {
+		return decode(field, data + offset);
+	}
+	return field.defaultValue;
+}
+
+Value Table::get(std::string_view name) const {
+	auto field = info->field(name);
+	if (!field) {
+		throw std::out_of_range(std::string("no field ") + std::string(name) + " in " + info->qualifiedName);
+	}
+	return get(*field);
+}
+
+Value Vector::iterator::operator*() const {
+	return (*vector)[idx];
+}
+
+Value Vector::operator[](uint32_t idx) const {
+	return decode(*field, element(idx));
+}
+
+TypeInfo const* Union::memberType() const {
+	return unionTag == 0 || unionTag > info->members.size() ? nullptr : info->members[unionTag - 1];
+}
+
+std::optional<Table> Union::table() const {
+	if (auto member = memberType()) {
+		return Table(member, data);
+	}
+	return {};
+}
+
+FieldInfo const* TypeInfo::field(std::string_view name) const {
+	auto iter = fieldIndex.find(name);
+	return iter == fieldIndex.end() ? nullptr : &fields[iter->second];
+}
+
+std::string_view TypeInfo::enumName(int64_t value) const {
+	for (auto const& [v, n] : values) {
+		if (v == value) {
+			return n;
+		}
+	}
+	return {};
+}
+
+std::optional<int64_t> TypeInfo::enumValue(std::string_view name) const {
+	for (auto const& [v, n] : values) {
+		if (n == name) {
+			return v;
+		}
+	}
+	return {};
+}
+
+void Reflection::describe(FieldInfo& info, schema::Field const& field) {
+	auto const& s = binarySchema;
+	info.field = &field;
+	info.name = s[field.name];
+	info.isVector = field.isArray();
+	if (field.type.isPrimitive()) {
+		info.baseType = field.type.baseType();
+		info.size = info.alignment = scalarSize(info.baseType);
+	} else {
+		info.type = &typeInfos[field.type.index()];
+		switch (info.type->kind) {
+		case Kind::Enum:
+			info.baseType = info.type->type->underlyingType;
+			info.size = info.alignment = scalarSize(info.baseType);
+			break;
+		case Kind::Struct:
+			info.size = info.type->type->staticSize;
+			info.alignment = info.type->type->alignment;
+			break;
+		case Kind::Table:
+			info.size = info.alignment = sizeof(uoffset_t);
+			break;
+		case Kind::Union:
+			info.size = sizeof(uint32_t) + sizeof(uoffset_t);
+			info.alignment = sizeof(uint32_t);
+			break;
+		}
+	}
+	if (field.nestedFlatbuffer.size > 0) {
+		// the bytes of a nested buffer are aligned like the largest scalar, which satisfies every type the nested
+		// buffer can contain
+		info.alignment = sizeof(uint64_t);
+	}
+	if (info.isVector) {
+		info.elementInfo = std::make_shared<FieldInfo>(info);
+		info.elementInfo->isVector = false;
+	} else if (info.isScalar() || info.baseType == BaseType::String) {
+		info.defaultValue = field.hasDefault() ? parseDefault(info, s[field.defaultValue]) : zero(info.baseType);
+	}
+}
+
+Reflection::Reflection(schema::Schema const& schema) : binarySchema(schema) {
+	auto types = schema.types();
+	typeInfos.resize(types.size());
+	// names and kinds first, so fields can reference any type
+	for (uint32_t i = 0; i < types.size(); ++i) {
+		auto& info = typeInfos[i];
+		info.type = &types[i];
+		info.index = i;
+		info.kind = types[i].kind;
+		info.name = schema[types[i].name];
+		info.vtable = schema[types[i].vtable];
+		info.qualifiedName = schema.qualifiedName(types[i]);
+		for (auto const& v : schema[types[i].values]) {
+			info.values.emplace_back(v.value, schema[v.name]);
+		}
+	}
+	for (auto& info : typeInfos) {
+		byName.emplace(info.qualifiedName, &info);
+		for (auto const& m : schema[info.type->members]) {
+			info.members.push_back(&typeInfos[m.type.index()]);
+		}
+		auto fields = schema[info.type->fields];
+		info.fields.resize(fields.size());
+		uint32_t offset = 0;
+		for (uint32_t i = 0; i < fields.size(); ++i) {
+			auto& field = info.fields[i];
+			describe(field, fields[i]);
+			field.index = i;
+			if (info.kind == Kind::Table) {
+				field.slot = vtableSlot(i);
+				field.offset = uint32_t(info.vtable[2 + i]);
+			} else {
+				// struct fields are laid out in declaration order, every field aligned to its natural alignment
+				offset += (field.alignment - offset % field.alignment) % field.alignment;
+				field.offset = offset;
+				offset += field.size;
+			}
+			info.fieldIndex.emplace(field.name, i);
+		}
+	}
+}
+
+TypeInfo const* Reflection::findType(std::string_view qualifiedName) const {
+	auto iter = byName.find(qualifiedName);
+	return iter == byName.end() ? nullptr : iter->second;
+}
+
+TypeInfo const* Reflection::rootType() const {
+	auto const& root = binarySchema.root();
+	auto rootTypes = binarySchema[root.rootTypes];
+	if (rootTypes.empty()) {
+		return nullptr;
+	}
+	std::string name;
+	for (auto const& part : binarySchema[root.namespacePath]) {
+		name.append(binarySchema[part]);
+		name.push_back('.');
+	}
+	name.append(binarySchema[rootTypes[0]]);
+	return findType(name);
+}
+
+} // namespace flowflat::reflection
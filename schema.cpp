@@ -0,0 +1,357 @@
+#include "flowflat/schema.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace flowflat::schema {
+
+namespace {
+
+// checks every reference in a binary schema before it is used. Arithmetic is done in 64 bits, so a reference can't
+// wrap around.
+class Validator {
+	char const* data;
+	Header const& header;
+
+public:
+	Validator(char const* data, Header const& header) : data(data), header(header) {}
+
+	template <class T>
+	[[nodiscard]] bool valid(ArrayRef<T> ref) const {
+		return ref.offset % alignof(T) == 0 && uint64_t(ref.offset) + uint64_t(ref.size) * sizeof(T) <= header.size;
+	}
+
+	[[nodiscard]] bool valid(StringRef ref) const {
+		return uint64_t(ref.offset) + ref.size < header.strings.size &&
+		       data[header.strings.offset + ref.offset + ref.size] == '\0';
+	}
+
+	[[nodiscard]] bool valid(TypeRef ref) const {
+		return ref.isPrimitive() ? ref.baseType() <= BaseType::String : ref.index() < header.types.size;
+	}
+
+	[[nodiscard]] bool valid(Array<StringRef> refs) const {
+		for (auto const& ref : refs) {
+			if (!valid(ref)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <class T>
+	[[nodiscard]] Array<T> array(ArrayRef<T> ref) const {
+		return Array<T>(reinterpret_cast<T const*>(data + ref.offset), ref.size);
+	}
+
+	[[nodiscard]] bool valid(File const& file, uint32_t index) const {
+		if (!valid(file.path) || !valid(file.fileIdentifier) || !valid(file.fileExtension) ||
+		    !valid(file.namespacePath) || !valid(file.attributes) || !valid(file.rootTypes) || !valid(file.types) ||
+		    !valid(file.includes)) {
+			return false;
+		}
+		if (!valid(array(file.namespacePath)) || !valid(array(file.attributes)) || !valid(array(file.rootTypes))) {
+			return false;
+		}
+		for (auto t : array(file.types)) {
+			if (t >= header.types.size) {
+				return false;
+			}
+		}
+		// files are ordered by their dependencies, so a file can only include files which come before it
+		for (auto f : array(file.includes)) {
+			if (f >= index) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	[[nodiscard]] Type const& type(TypeRef ref) const { return array(header.types)[ref.index()]; }
+
+	// structs can only contain scalars, enums and other structs, tables can contain anything
+	[[nodiscard]] bool valid(Field const& field, Kind kind) const {
+		if (!valid(field.name) || !valid(field.typeName) || !valid(field.type) || !valid(field.defaultValue) ||
+		    !valid(field.nestedFlatbuffer)) {
+			return false;
+		}
+		if (field.type.isPrimitive()) {
+			auto base = field.type.baseType();
+			return base != BaseType::None && (kind == Kind::Table || (base != BaseType::String && !field.isArray()));
+		}
+		auto fieldKind = type(field.type).kind;
+		return kind == Kind::Table || (!field.isArray() && (fieldKind == Kind::Enum || fieldKind == Kind::Struct));
+	}
+
+	[[nodiscard]] bool valid(Type const& type) const {
+		if (!valid(type.name) || !valid(type.underlyingTypeName) || type.file >= header.files.size ||
+		    type.kind > Kind::Table || type.underlyingType > BaseType::String || !valid(type.vtable) ||
+		    !valid(type.fields) || !valid(type.values) || !valid(type.members)) {
+			return false;
+		}
+		// every type only has the records of its kind
+		bool hasFields = type.kind == Kind::Struct || type.kind == Kind::Table;
+		if ((!hasFields && type.fields.size > 0) || (type.kind != Kind::Enum && type.values.size > 0) ||
+		    (type.kind != Kind::Union && type.members.size > 0)) {
+			return false;
+		}
+		if (hasFields && (type.alignment == 0 || type.alignment > sizeof(uint64_t) ||
+		                  (type.alignment & (type.alignment - 1)) != 0)) {
+			return false;
+		}
+		// the underlying type of an enum is an integer
+		if (type.kind == Kind::Enum &&
+		    (type.underlyingType < BaseType::Byte || type.underlyingType > BaseType::ULong)) {
+			return false;
+		}
+		// every field of a table has a vtable entry
+		if (type.kind == Kind::Table && uint64_t(type.vtable.size) != uint64_t(type.fields.size) + 2) {
+			return false;
+		}
+		for (auto const& field : array(type.fields)) {
+			if (!valid(field, type.kind)) {
+				return false;
+			}
+		}
+		for (auto const& value : array(type.values)) {
+			if (!valid(value.name)) {
+				return false;
+			}
+		}
+		// union members are tables
+		for (auto const& member : array(type.members)) {
+			if (!valid(member.name) || member.type.isPrimitive() || !valid(member.type) ||
+			    this->type(member.type).kind != Kind::Table) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// the size and the alignment of a field in the inline data of a struct or table. Only called for valid types.
+	[[nodiscard]] std::pair<uint32_t, uint32_t> layout(Field const& field) const {
+		if (field.isArray()) {
+			return { sizeof(uoffset_t), sizeof(uoffset_t) };
+		}
+		auto base = field.type.baseType();
+		if (!field.type.isPrimitive()) {
+			auto const& t = type(field.type);
+			switch (t.kind) {
+			case Kind::Enum:
+				base = t.underlyingType;
+				break;
+			case Kind::Struct:
+				return { t.staticSize, t.alignment };
+			case Kind::Table:
+				return { sizeof(uoffset_t), sizeof(uoffset_t) };
+			case Kind::Union:
+				return { sizeof(uint32_t) + sizeof(uoffset_t), sizeof(uint32_t) };
+			}
+		}
+		switch (base) {
+		case BaseType::Bool:
+		case BaseType::Byte:
+		case BaseType::UByte:
+			return { 1, 1 };
+		case BaseType::Short:
+		case BaseType::UShort:
+			return { 2, 2 };
+		case BaseType::Long:
+		case BaseType::ULong:
+		case BaseType::Double:
+			return { 8, 8 };
+		default:
+			return { 4, 4 };
+		}
+	}
+
+	// every field lies within the inline data: struct fields are laid out in declaration order, each aligned to its
+	// natural alignment, the fields of tables are where the vtable says. Only called for valid types.
+	[[nodiscard]] bool validLayout(Type const& type) const {
+		auto fields = array(type.fields);
+		if (type.kind == Kind::Struct) {
+			uint64_t offset = 0;
+			for (auto const& field : fields) {
+				auto [size, alignment] = layout(field);
+				offset += (alignment - offset % alignment) % alignment + size;
+			}
+			return offset <= type.staticSize;
+		}
+		if (type.kind != Kind::Table) {
+			return true;
+		}
+		auto vtable = array(type.vtable);
+		if (vtable[0] != voffset_t(2 * vtable.size()) || vtable[1] < voffset_t(sizeof(soffset_t))) {
+			return false;
+		}
+		for (uint32_t i = 0; i < fields.size(); ++i) {
+			auto offset = vtable[2 + i];
+			if (offset != 0 && (offset < voffset_t(sizeof(soffset_t)) ||
+			                    uint64_t(offset) + layout(fields[i]).first > uint64_t(vtable[1]))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// structs can't contain themselves, not even through other structs
+	[[nodiscard]] bool acyclic() const {
+		auto types = array(header.types);
+		enum State : uint8_t { Unvisited, Visiting, Visited };
+		std::vector<State> states(types.size(), Unvisited);
+		// the struct and the index of the next field to look at
+		std::vector<std::pair<uint32_t, uint32_t>> stack;
+		for (uint32_t root = 0; root < types.size(); ++root) {
+			if (types[root].kind != Kind::Struct || states[root] != Unvisited) {
+				continue;
+			}
+			states[root] = Visiting;
+			stack.emplace_back(root, 0);
+			while (!stack.empty()) {
+				auto [current, next] = stack.back();
+				auto fields = array(types[current].fields);
+				if (next == fields.size()) {
+					states[current] = Visited;
+					stack.pop_back();
+					continue;
+				}
+				++stack.back().second;
+				auto ref = fields[next].type;
+				if (ref.isPrimitive() || types[ref.index()].kind != Kind::Struct) {
+					continue;
+				}
+				if (states[ref.index()] == Visiting) {
+					return false;
+				}
+				if (states[ref.index()] == Unvisited) {
+					states[ref.index()] = Visiting;
+					stack.emplace_back(ref.index(), 0);
+				}
+			}
+		}
+		return true;
+	}
+};
+
+} // namespace
+
+std::optional<Schema> Schema::open(void const* buffer, std::size_t size) {
+	auto data = static_cast<char const*>(buffer);
+	if (size < sizeof(Header) || reinterpret_cast<uintptr_t>(data) % alignof(EnumValue) != 0) {
+		return {};
+	}
+	auto const& header = *reinterpret_cast<Header const*>(data);
+	if (header.magic != magic || header.version != version || header.size > size) {
+		return {};
+	}
+	Validator validator(data, header);
+	if (!validator.valid(header.files) || !validator.valid(header.types) || !validator.valid(header.strings) ||
+	    header.root >= header.files.size) {
+		return {};
+	}
+	auto files = validator.array(header.files);
+	for (uint32_t i = 0; i < files.size(); ++i) {
+		if (!validator.valid(files[i], i)) {
+			return {};
+		}
+	}
+	auto types = validator.array(header.types);
+	for (auto const& type : types) {
+		if (!validator.valid(type)) {
+			return {};
+		}
+	}
+	// layouts reference other types, so they are checked once all types are known to be valid
+	for (auto const& type : types) {
+		if (!validator.validLayout(type)) {
+			return {};
+		}
+	}
+	if (!validator.acyclic()) {
+		return {};
+	}
+	return Schema(data);
+}
+
+std::string Schema::qualifiedName(Type const& type) const {
+	std::string res;
+	for (auto const& part : (*this)[files()[type.file].namespacePath]) {
+		res.append((*this)[part]);
+		res.push_back('.');
+	}
+	res.append((*this)[type.name]);
+	return res;
+}
+
+Type const* Schema::findType(std::string_view qualifiedName) const {
+	for (auto const& type : types()) {
+		auto name = (*this)[type.name];
+		// compare the name first, it is much more selective than the namespace
+		if (qualifiedName.size() < name.size() ||
+		    qualifiedName.substr(qualifiedName.size() - name.size()) != name) {
+			continue;
+		}
+		auto prefix = qualifiedName.substr(0, qualifiedName.size() - name.size());
+		bool matches = true;
+		for (auto const& part : (*this)[files()[type.file].namespacePath]) {
+			auto p = (*this)[part];
+			if (prefix.substr(0, p.size()) != p || prefix.size() <= p.size() || prefix[p.size()] != '.') {
+				matches = false;
+				break;
+			}
+			prefix.remove_prefix(p.size() + 1);
+		}
+		if (matches && prefix.empty()) {
+			return &type;
+		}
+	}
+	return nullptr;
+}
+
+std::string_view Schema::name(BaseType type) {
+	using namespace std::string_view_literals;
+	constexpr std::string_view names[] = { ""sv,     "bool"sv, "byte"sv, "ubyte"sv,  "short"sv, "ushort"sv, "int"sv,
+		                                   "uint"sv, "long"sv, "ulong"sv, "float"sv, "double"sv, "string"sv };
+	return names[unsigned(type)];
+}
+
+SchemaFile::SchemaFile(char const* path) {
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error(std::string("can't open binary schema ") + path);
+	}
+	struct stat st {};
+	if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		throw std::runtime_error(std::string("can't read binary schema ") + path);
+	}
+	length = st.st_size;
+	mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		mapping = nullptr;
+		throw std::runtime_error(std::string("can't map binary schema ") + path);
+	}
+	// mappings are page aligned, so the alignment requirement is always met
+	loaded = Schema::open(mapping, length);
+	if (!loaded) {
+		::munmap(mapping, length);
+		mapping = nullptr;
+		throw std::runtime_error(std::string("invalid binary schema ") + path);
+	}
+}
+
+SchemaFile::~SchemaFile() {
+	if (mapping) {
+		::munmap(mapping, length);
+	}
+}
+
+} // namespace flowflat::schema
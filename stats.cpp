@@ -0,0 +1,83 @@
+#include "flowflat/stats.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace flowflat::stats {
+
+namespace detail {
+
+std::atomic<Hook const*> hook{ nullptr };
+
+} // namespace detail
+
+namespace {
+
+struct Registry {
+	std::mutex mutex;
+	// deque: registered counters never move
+	std::deque<Counters> counters;
+	std::map<std::string, Counters*, std::less<>> types;
+	// hooks are never freed, a hook which is replaced while another thread calls it stays valid
+	std::deque<detail::Hook> hooks;
+};
+
+Registry& registry() {
+	static Registry res;
+	return res;
+}
+
+} // namespace
+
+Counters& registerType(std::string_view type) {
+	auto& r = registry();
+	std::lock_guard lock(r.mutex);
+	if (auto iter = r.types.find(type); iter != r.types.end()) {
+		return *iter->second;
+	}
+	auto& res = r.counters.emplace_back();
+	r.types.emplace(std::string(type), &res);
+	return res;
+}
+
+std::vector<Snapshot> snapshot() {
+	std::vector<Snapshot> res;
+	if constexpr (enabled) {
+		auto& r = registry();
+		std::lock_guard lock(r.mutex);
+		for (auto const& [type, c] : r.types) {
+			res.push_back(Snapshot{ type,
+			                        c->messages.load(std::memory_order_relaxed),
+			                        c->bytes.load(std::memory_order_relaxed),
+			                        c->allocations.load(std::memory_order_relaxed),
+			                        c->vtableHits.load(std::memory_order_relaxed),
+			                        c->decodes.load(std::memory_order_relaxed),
+			                        c->verifyFailures.load(std::memory_order_relaxed) });
+		}
+	}
+	return res;
+}
+
+void reset() {
+	auto& r = registry();
+	std::lock_guard lock(r.mutex);
+	for (auto& c : r.counters) {
+		for (auto* counter :
+		     { &c.messages, &c.bytes, &c.allocations, &c.vtableHits, &c.decodes, &c.verifyFailures }) {
+			counter->store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void setTraceHook(TraceHook hook, void* context) {
+	if constexpr (enabled) {
+		auto& r = registry();
+		std::lock_guard lock(r.mutex);
+		detail::hook.store(hook ? &r.hooks.emplace_back(detail::Hook{ hook, context }) : nullptr,
+		                   std::memory_order_release);
+	}
+}
+
+} // namespace flowflat::stats
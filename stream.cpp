@@ -0,0 +1,60 @@
+#include "flowflat/stream.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace flowflat {
+
+StreamReader::StreamReader(std::size_t maxSize) : capacity(maxSize) {
+	// pages are only committed when a chunk is written to them
+	auto res = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (res == MAP_FAILED) {
+		throw std::runtime_error("can't reserve memory for stream");
+	}
+	base = static_cast<char*>(res);
+}
+
+StreamReader::~StreamReader() {
+	::munmap(base, capacity);
+}
+
+void StreamReader::append(char const* data, std::size_t size) {
+	if (size > capacity - received) {
+		throw std::runtime_error("stream is larger than its maximum size");
+	}
+	std::memcpy(base + received, data, size);
+	received += size;
+}
+
+char const* StreamReader::rootTable() const {
+	if (received < sizeof(uoffset_t)) {
+		return nullptr;
+	}
+	auto table = follow(base);
+	if (!arrived(table, sizeof(soffset_t))) {
+		return nullptr;
+	}
+	// the vtable is written before the table
+	auto vtable = table - load<soffset_t>(table);
+	if (!arrived(vtable, 2 * sizeof(voffset_t)) || !arrived(table, std::size_t(load<voffset_t>(vtable + 2)))) {
+		return nullptr;
+	}
+	return table;
+}
+
+void StreamReader::discard(char const* begin, char const* end) {
+	static auto const pageSize = std::size_t(::sysconf(_SC_PAGESIZE));
+	if (begin < base || end <= begin) {
+		return;
+	}
+	auto first = (std::size_t(begin - base) + pageSize - 1) / pageSize * pageSize;
+	auto last = std::min(std::size_t(end - base), capacity) / pageSize * pageSize;
+	if (first < last) {
+		::madvise(base + first, last - first, MADV_DONTNEED);
+	}
+}
+
+} // namespace flowflat
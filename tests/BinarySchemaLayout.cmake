@@ -0,0 +1,30 @@
+# Checks that code generated from a binary schema uses the layout the binary schema was compiled with, even if that
+# layout came from a layout profile which isn't passed again.
+#
+# cmake -D FLOWFLATC=<flowflatc> -D SCHEMA=<schema.fbs> -D PROFILE=<layout profile> -D WORK_DIR=<dir>
+#       -P BinarySchemaLayout.cmake
+
+get_filename_component(STEM ${SCHEMA} NAME_WE)
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/plain ${WORK_DIR}/profiled ${WORK_DIR}/loaded)
+
+function(compile dir)
+    execute_process(COMMAND ${FLOWFLATC} -s ${WORK_DIR}/${dir} -i ${WORK_DIR}/${dir} ${ARGN}
+            OUTPUT_QUIET RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "flowflatc ${ARGN} failed: ${result}")
+    endif()
+    file(STRINGS ${WORK_DIR}/${dir}/${STEM}.h vtables REGEX "flowFlatVTable\\[\\] =")
+    set(${dir} "${vtables}" PARENT_SCOPE)
+endfunction()
+
+compile(plain ${SCHEMA})
+compile(profiled --layout-profile ${PROFILE} -b ${WORK_DIR}/profiled ${SCHEMA})
+compile(loaded ${WORK_DIR}/profiled/${STEM}.bfbs)
+
+if(plain STREQUAL profiled)
+    message(FATAL_ERROR "the layout profile didn't change the layout")
+endif()
+if(NOT loaded STREQUAL profiled)
+    message(FATAL_ERROR "the binary schema changed the layout\nexpected: ${profiled}\ngot: ${loaded}")
+endif()
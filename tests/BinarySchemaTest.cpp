@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <flowflat/reflection.h>
+#include <flowflat/schema.h>
+
+#include "flatbuffers/Compiler.h"
+#include "Check.h"
+#include "tests.h"
+
+namespace schema = flowflat::schema;
+namespace fs = boost::filesystem;
+
+namespace {
+
+std::string readFile(fs::path const& file) {
+	std::ifstream in(file.string(), std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeFile(fs::path const& file, std::string const& contents) {
+	std::ofstream out(file.string(), std::ios::binary | std::ios::trunc);
+	out.write(contents.data(), std::streamsize(contents.size()));
+}
+
+// compiles input (a schema or a binary schema) and writes its binary schema to dir
+void compile(fs::path const& input, fs::path const& dir) {
+	flatbuffers::Compiler compiler({});
+	compiler.compile(input.string());
+	fs::create_directories(dir);
+	compiler.writeBinarySchemas(dir.string());
+}
+
+// whether loading the binary schema and writing it again fails with a compiler error
+bool rejected(std::string const& contents) {
+	writeFile("corrupt.bfbs", contents);
+	try {
+		compile("corrupt.bfbs", "corrupt");
+	} catch (flatbuffers::Error&) {
+		return true;
+	}
+	return false;
+}
+
+std::size_t offset(std::string const& contents, void const* p) {
+	return std::size_t(static_cast<char const*>(p) - contents.data());
+}
+
+// a copy of contents where value replaces member, a record (or a member of one) in contents
+template <class T>
+std::string patched(std::string const& contents, T const& member, T value) {
+	auto res = contents;
+	std::memcpy(res.data() + offset(contents, &member), &value, sizeof(T));
+	return res;
+}
+
+// Schema::open rejects the binary schema and so does the compiler
+bool invalid(std::string const& contents) {
+	return !schema::Schema::open(contents.data(), contents.size()) && rejected(contents);
+}
+
+void roundTrip(std::string const& contents) {
+	// writing a loaded binary schema reproduces it
+	compile("compiled/tests.bfbs", "loaded");
+	CHECK(readFile("loaded/tests.bfbs") == contents);
+
+	// the layout in the binary schema is the layout of the generated code
+	auto loaded = schema::Schema::open(contents.data(), contents.size());
+	CHECK(loaded);
+	flowflat::reflection::Reflection reflection(*loaded);
+	auto type = reflection.findType("tests.Node");
+	CHECK(type && reflection.rootType() == type);
+	CHECK(std::equal(std::begin(tests::Node::flowFlatVTable), std::end(tests::Node::flowFlatVTable),
+	                 type->vtable.begin(), type->vtable.end()));
+	tests::Node node;
+	node.id = 42;
+	node.name = "node";
+	flowflat::NewWriter w;
+	node.write(w);
+	auto table = flowflat::reflection::Reflection::root(w.data(), *type);
+	CHECK(std::get<int64_t>(table.get("id")) == 42 && table.string(*type->field("name")) == "node");
+}
+
+// types which are well-formed records, but which don't make sense for their kind
+void mistyped(std::string const& contents) {
+	using schema::BaseType;
+	using schema::TypeRef;
+	auto loaded = *schema::Schema::open(contents.data(), contents.size());
+	auto const& color = *loaded.findType("tests.Color");
+	auto const& payload = *loaded.findType("tests.Payload");
+	auto const& vec3 = *loaded.findType("tests.Vec3");
+	auto const& box = *loaded.findType("tests.Box");
+	auto const& leaf = *loaded.findType("tests.Leaf");
+	auto const& node = *loaded.findType("tests.Node");
+	auto index = [&](schema::Type const& type) { return TypeRef::type(uint32_t(&type - loaded.types().begin())); };
+	auto const& member = loaded[payload.members][0];
+	auto const& x = loaded[vec3.fields][0];
+	auto const& id = loaded[node.fields][0];
+
+	// union members which aren't tables
+	CHECK(invalid(patched(contents, member.type, TypeRef::primitive(BaseType::Int))));
+	CHECK(invalid(patched(contents, member.type, TypeRef::primitive(BaseType::None))));
+	CHECK(invalid(patched(contents, member.type, index(vec3))));
+	CHECK(invalid(patched(contents, member.type, index(payload))));
+	// fields without a type
+	CHECK(invalid(patched(contents, id.type, TypeRef::primitive(BaseType::None))));
+	CHECK(invalid(patched(contents, x.type, TypeRef::primitive(BaseType::None))));
+	// struct fields which reference other objects
+	CHECK(invalid(patched(contents, x.type, TypeRef::primitive(BaseType::String))));
+	CHECK(invalid(patched(contents, x.type, index(leaf))));
+	CHECK(invalid(patched(contents, x.type, index(payload))));
+	CHECK(invalid(patched(contents, x.flags, uint16_t(schema::Field::IsArray))));
+	// enums which aren't integers
+	CHECK(invalid(patched(contents, color.underlyingType, BaseType::Float)));
+	CHECK(invalid(patched(contents, color.underlyingType, BaseType::String)));
+	CHECK(invalid(patched(contents, color.underlyingType, BaseType::None)));
+	// types with records of another kind
+	CHECK(invalid(patched(contents, color.kind, schema::Kind::Union)));
+	CHECK(invalid(patched(contents, payload.kind, schema::Kind::Enum)));
+	CHECK(invalid(patched(contents, vec3.kind, schema::Kind::Union)));
+	// struct layouts which don't fit
+	CHECK(invalid(patched(contents, vec3.alignment, 0u)));
+	CHECK(invalid(patched(contents, vec3.alignment, 3u)));
+	CHECK(invalid(patched(contents, vec3.staticSize, vec3.staticSize - 1)));
+	CHECK(invalid(patched(contents, box.staticSize, box.staticSize - 8)));
+	// a struct which contains itself
+	CHECK(invalid(patched(contents, loaded[box.fields][0].type, index(box))));
+	// and something which is fine
+	CHECK(schema::Schema::open(patched(contents, color.underlyingType, BaseType::Byte).data(), contents.size()));
+}
+
+void corrupted(std::string const& contents) {
+	// truncated schemas
+	for (std::size_t size = 0; size < contents.size(); size += 7) {
+		CHECK(!schema::Schema::open(contents.data(), size));
+		CHECK(rejected(contents.substr(0, size)));
+	}
+
+	auto loaded = *schema::Schema::open(contents.data(), contents.size());
+	auto const& node = *loaded.findType("tests.Node");
+
+	// schemas of another version
+	auto bad = contents;
+	flowflat::store(bad.data() + offsetof(schema::Header, version), schema::version - 1);
+	CHECK(rejected(bad));
+	// a table with a vtable entry missing
+	bad = contents;
+	flowflat::store(bad.data() + offset(contents, &node.vtable.size), node.vtable.size - 1);
+	CHECK(!schema::Schema::open(bad.data(), bad.size()) && rejected(bad));
+	// a field which lies outside of the inline data
+	auto vtable = loaded[node.vtable];
+	CHECK(invalid(patched(contents, vtable[2], vtable[1])));
+	CHECK(invalid(patched(contents, vtable[2], flowflat::voffset_t(vtable[1] - 4))));
+	// a string which isn't terminated
+	bad = contents;
+	bad[offset(contents, loaded[node.name].data()) + node.name.size] = 'x';
+	CHECK(!schema::Schema::open(bad.data(), bad.size()) && rejected(bad));
+
+	mistyped(contents);
+
+	// random corruption is either rejected or results in a schema which can be used
+	std::mt19937 rng(7);
+	for (int i = 0; i < 500; ++i) {
+		bad = contents;
+		for (int flips = 1 + rng() % 3; flips > 0; --flips) {
+			bad[rng() % bad.size()] = char(rng());
+		}
+		if (auto s = schema::Schema::open(bad.data(), bad.size())) {
+			flowflat::reflection::Reflection reflection(*s);
+			(void)reflection.rootType();
+		}
+		(void)rejected(bad);
+	}
+}
+
+} // namespace
+
+// argv[1] is tests.fbs
+int main(int argc, char const* argv[]) {
+	CHECK(argc == 2);
+	compile(argv[1], "compiled");
+	auto contents = readFile("compiled/tests.bfbs");
+	roundTrip(contents);
+	corrupted(contents);
+}
@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Check.h"
+#include "tests.h"
+
+// tests.fbs generated with --borrowed: strings and vectors of scalars don't own their contents
+namespace {
+
+bool within(void const* p, flowflat::NewWriter const& w) {
+	auto c = static_cast<char const*>(p);
+	return c >= w.data() && c < w.data() + w.size();
+}
+
+} // namespace
+
+int main() {
+	// the values are owned by the caller while the table is written
+	std::string text(1000, 'x');
+	std::vector<unsigned char> bytes(300, 7);
+	std::string names[] = { "first", "second" };
+	tests::Bulk bulk;
+	bulk.text = std::string_view(text).substr(0, 500);
+	bulk.bytes = bytes;
+	bulk.names = { names[0], names[1], "" };
+	bulk.points = { tests::Vec3{ 1, 2, 3 } };
+	bulk.flags = { true, false };
+	bulk.nodes.emplace_back().name = names[1];
+	flowflat::NewWriter w;
+	bulk.write(w);
+	CHECK(tests::Bulk::verify(w.data(), w.size()));
+
+	// read values point into the buffer
+	auto read = tests::Bulk::read(w.data());
+	CHECK(read.text == bulk.text && within(read.text.data(), w));
+	CHECK(read.bytes.size() == bytes.size() && within(read.bytes.data(), w));
+	CHECK(std::memcmp(read.bytes.data(), bytes.data(), bytes.size()) == 0);
+	CHECK(read.names.size() == 3 && read.names[1] == "second" && within(read.names[0].data(), w));
+	CHECK(read.nodes.size() == 1 && read.nodes[0].name == "second" && within(read.nodes[0].name.data(), w));
+	CHECK(read.points.size() == 1 && read.points[0].z == 3 && read.flags == bulk.flags);
+
+	// writing the borrowed values again gives the same buffer
+	flowflat::NewWriter again;
+	read.write(again);
+	CHECK(again.size() == w.size() && std::memcmp(again.data(), w.data(), w.size()) == 0);
+
+	auto lazy = tests::Bulk::lazy(w.data());
+	CHECK(lazy.text() == bulk.text && within(lazy.text().data(), w) && lazy.bytes()[299] == 7);
+	CHECK(lazy.materialize().names[0] == "first");
+
+	// absent values are empty
+	tests::Bulk empty;
+	flowflat::NewWriter e;
+	empty.write(e);
+	auto r = tests::Bulk::read(e.data());
+	CHECK(r.text.empty() && r.bytes.empty() && r.names.empty());
+}
@@ -0,0 +1,11 @@
+#ifndef FLATBUFFER_CHECK_H
+#define FLATBUFFER_CHECK_H
+#include <cstdio>
+#include <cstdlib>
+
+// like assert, but independent of NDEBUG
+#define CHECK(condition)                                                                                               \
+	((condition) ? void(0)                                                                                             \
+	             : (std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition), std::abort()))
+
+#endif // FLATBUFFER_CHECK_H
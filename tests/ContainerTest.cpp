@@ -0,0 +1,157 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <flowflat/container.h>
+
+#include "Check.h"
+#include "tests.h"
+
+namespace container = flowflat::container;
+
+namespace {
+
+constexpr char const* path = "container_test.ffc";
+constexpr char const* corruptPath = "container_test_corrupt.ffc";
+
+std::string readFile(char const* file) {
+	std::ifstream in(file, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeFile(char const* file, std::string const& contents) {
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	out.write(contents.data(), std::streamsize(contents.size()));
+}
+
+template <class F>
+bool throws(F f) {
+	try {
+		f();
+	} catch (std::runtime_error&) {
+		return true;
+	}
+	return false;
+}
+
+void writeNodes(char const* file, int count, bool checksums) {
+	container::Writer w(file, checksums);
+	for (int i = 0; i < count; ++i) {
+		tests::Node node;
+		node.id = i;
+		node.name = std::string(i % 37, 'x');
+		node.tags = { std::to_string(i) };
+		node.write(w);
+	}
+	w.close();
+}
+
+void roundTrip() {
+	std::remove(path);
+	writeNodes(path, 1000, true);
+	{
+		container::Reader r(path);
+		CHECK(r.size() == 1000 && r.hasChecksums());
+		for (std::size_t i = 0; i < r.size(); ++i) {
+			auto node = r.verifiedView<tests::Node>(i);
+			CHECK(node && node->id() == long(i) && node->name().size() == i % 37);
+			CHECK(reinterpret_cast<uintptr_t>(r.record(i).data()) % container::recordAlignment == 0);
+		}
+	}
+	{
+		// appending keeps the records and the checksum setting
+		container::Writer w(path, false);
+		tests::Node node;
+		node.id = -1;
+		node.write(w);
+		w.close();
+	}
+	container::Reader r(path);
+	CHECK(r.size() == 1001 && r.hasChecksums() && r.checksumMatches(1000));
+	CHECK(r.view<tests::Node>(1000).id() == -1 && r.view<tests::Node>(5).id() == 5);
+	CHECK(container::crc32c("123456789", 9) == 0xe3069283);
+}
+
+void corruptRecords() {
+	std::remove(path);
+	writeNodes(path, 10, true);
+	auto contents = readFile(path);
+	auto indexPosition = flowflat::load<uint64_t>(contents.data() + contents.size() - container::trailerSize);
+	auto entry = [&](std::size_t i) { return contents.data() + indexPosition + i * sizeof(uint64_t); };
+
+	// a flipped byte in a buffer is caught by the checksum
+	{
+		auto bad = contents;
+		auto position = flowflat::load<uint64_t>(entry(3));
+		bad[position + container::recordHeaderSize + 6] ^= 0x55;
+		writeFile(corruptPath, bad);
+		container::Reader r(corruptPath);
+		CHECK(!r.checksumMatches(3) && !r.verifiedView<tests::Node>(3) && r.verifiedView<tests::Node>(4));
+	}
+	// index entries which don't point to a record
+	for (uint64_t position : { uint64_t(0),
+	                           uint64_t(container::headerSize + 4),
+	                           indexPosition,
+	                           indexPosition + sizeof(uint64_t),
+	                           ~uint64_t(7) }) {
+		auto bad = contents;
+		flowflat::store(bad.data() + (entry(2) - contents.data()), position);
+		writeFile(corruptPath, bad);
+		container::Reader r(corruptPath);
+		CHECK(throws([&]() { (void)r.record(2); }));
+		CHECK(throws([&]() { (void)r.verifiedView<tests::Node>(2); }));
+		CHECK(r.verifiedView<tests::Node>(1));
+	}
+	// a record which is larger than the space before the index
+	{
+		auto bad = contents;
+		auto position = flowflat::load<uint64_t>(entry(9));
+		flowflat::store(bad.data() + position, uint32_t(indexPosition - position));
+		writeFile(corruptPath, bad);
+		container::Reader r(corruptPath);
+		CHECK(throws([&]() { (void)r.record(9); }));
+	}
+}
+
+void corruptTrailer() {
+	std::remove(path);
+	writeNodes(path, 3, false);
+	auto contents = readFile(path);
+	// a container which wasn't closed or got truncated
+	for (std::size_t size = 1; size < contents.size(); ++size) {
+		writeFile(corruptPath, contents.substr(0, size));
+		CHECK(throws([]() { container::Reader r(corruptPath); }));
+	}
+	auto trailer = contents.size() - container::trailerSize;
+	// index positions and record counts which don't match the file
+	for (auto [offset, value] : { std::pair<std::size_t, uint64_t>(0, 8),
+	                              std::pair<std::size_t, uint64_t>(0, trailer),
+	                              std::pair<std::size_t, uint64_t>(0, ~uint64_t(7)),
+	                              std::pair<std::size_t, uint64_t>(8, 4),
+	                              std::pair<std::size_t, uint64_t>(8, uint64_t(1) << 61) }) {
+		auto bad = contents;
+		flowflat::store(bad.data() + trailer + offset, value);
+		writeFile(corruptPath, bad);
+		CHECK(throws([]() { container::Reader r(corruptPath); }));
+	}
+	// files which aren't containers are left alone
+	std::string junk = "this is not a container, but it is long enough to be one";
+	writeFile(corruptPath, junk);
+	CHECK(throws([]() { container::Reader r(corruptPath); }));
+	CHECK(throws([]() { container::Writer w(corruptPath); }));
+	CHECK(readFile(corruptPath) == junk);
+}
+
+} // namespace
+
+int main() {
+	roundTrip();
+	corruptRecords();
+	corruptTrailer();
+	std::remove(path);
+	std::remove(corruptPath);
+}
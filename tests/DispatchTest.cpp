@@ -0,0 +1,88 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "Check.h"
+#include "tests.h"
+
+// the dispatcher of tests.fbs (generated for root types with a file identifier)
+namespace {
+
+// the ids of the nodes the visitor was called with
+struct Visited {
+	int calls = 0;
+	long id = 0;
+
+	template <class View>
+	void operator()(View view) {
+		static_assert(std::is_same_v<View, tests::Node::View>);
+		++calls;
+		id = view.id();
+	}
+};
+
+tests::Node node() {
+	tests::Node node;
+	node.id = 42;
+	node.name = "node";
+	return node;
+}
+
+std::string write(flowflat::Framing const& framing) {
+	flowflat::NewWriter w;
+	node().write(w, framing);
+	return std::string(w.data(), w.size());
+}
+
+void known() {
+	// write uses the identifier of the root type
+	flowflat::NewWriter w;
+	node().write(w);
+	CHECK(tests::Node::hasIdentifier(w.data()));
+	auto buffer = std::string(w.data(), w.size());
+	Visited visited;
+	CHECK(tests::TestsRoots::dispatch(buffer.data(), visited));
+	CHECK(tests::TestsRoots::dispatchVerified(buffer.data(), buffer.size(), visited));
+	CHECK(visited.calls == 2 && visited.id == 42);
+
+	auto frame = write(flowflat::Framing{ tests::Node::flowFlatIdentifier, true });
+	Visited prefixed;
+	CHECK(tests::TestsRoots::dispatchSizePrefixed(frame.data(), frame.size(), prefixed));
+	CHECK(prefixed.calls == 1 && prefixed.id == 42);
+}
+
+void unknown() {
+	// 'ABCD'
+	constexpr uint32_t other = 0x44434241;
+	auto buffer = write(flowflat::Framing{ other, false });
+	auto frame = write(flowflat::Framing{ other, true });
+	Visited visited;
+	CHECK(!tests::Node::hasIdentifier(buffer.data()));
+	CHECK(!tests::TestsRoots::dispatch(buffer.data(), visited));
+	CHECK(!tests::TestsRoots::dispatchVerified(buffer.data(), buffer.size(), visited));
+	CHECK(!tests::TestsRoots::dispatchSizePrefixed(frame.data(), frame.size(), visited));
+	CHECK(visited.calls == 0);
+}
+
+// the identifier is known, but the buffer is cut short
+void truncated() {
+	auto buffer = write(flowflat::Framing{ tests::Node::flowFlatIdentifier, false });
+	auto frame = write(flowflat::Framing{ tests::Node::flowFlatIdentifier, true });
+	Visited visited;
+	for (std::size_t size = 0; size < buffer.size(); ++size) {
+		CHECK(!tests::TestsRoots::dispatchVerified(buffer.data(), size, visited));
+	}
+	for (std::size_t size = 0; size < frame.size(); ++size) {
+		CHECK(!tests::TestsRoots::dispatchSizePrefixed(frame.data(), size, visited));
+	}
+	CHECK(visited.calls == 0);
+}
+
+} // namespace
+
+int main() {
+	known();
+	unknown();
+	truncated();
+}
@@ -0,0 +1,39 @@
+#ifndef FLATBUFFER_FIXTURES_H
+#define FLATBUFFER_FIXTURES_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "tests.h"
+
+namespace fixtures {
+
+// the length of tag k of item i
+inline std::size_t tagSize(uint32_t i, uint32_t k) {
+	return k + i % 5;
+}
+
+// item i has the id i, a name of i % 13 characters and i % 4 tags
+inline tests::Snapshot snapshot(uint32_t numItems, std::size_t (*tagSize)(uint32_t, uint32_t) = fixtures::tagSize) {
+	tests::Snapshot snapshot;
+	snapshot.title = "snapshot";
+	for (uint32_t i = 0; i < numItems; ++i) {
+		tests::Item item;
+		item.id = i;
+		item.name = std::string(i % 13, 'n');
+		for (uint32_t k = 0; k < i % 4; ++k) {
+			item.tags.push_back(std::string(tagSize(i, k), 't'));
+		}
+		snapshot.items.push_back(item);
+	}
+	return snapshot;
+}
+
+inline bool equal(flowflat::NewWriter const& lhs, flowflat::NewWriter const& rhs) {
+	return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+} // namespace fixtures
+
+#endif // FLATBUFFER_FIXTURES_H
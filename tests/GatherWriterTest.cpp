@@ -0,0 +1,68 @@
+#include <cstddef>
+#include <string>
+
+#include <flowflat/gather.h>
+
+#include "Check.h"
+#include "tests.h"
+
+namespace {
+
+constexpr std::size_t threshold = 64;
+
+// n payloads are gathered: names[i] for i >= threshold, bytes and text
+tests::Bulk bulk(std::size_t numNames) {
+	tests::Bulk bulk;
+	for (std::size_t i = 0; i < numNames; ++i) {
+		bulk.names.push_back(std::string(i, char('a' + i % 26)));
+	}
+	for (int i = 0; i < 1000; ++i) {
+		bulk.bytes.push_back(uint8_t(i));
+	}
+	bulk.points.resize(10);
+	bulk.flags = { true, false, true };
+	bulk.text = std::string(5000, 'x');
+	return bulk;
+}
+
+std::string newWriter(tests::Bulk const& bulk) {
+	flowflat::NewWriter w;
+	bulk.write(w);
+	return std::string(w.data(), w.size());
+}
+
+// the gathered buffer is the buffer of NewWriter, every gathered payload is an iovec of its own which points into the
+// serialized object
+void gathered(flowflat::GatherWriter& w, std::size_t numNames) {
+	auto b = bulk(numNames);
+	b.write(w);
+	auto expected = newWriter(b);
+	CHECK(w.flatten() == expected);
+	CHECK(w.size() == expected.size());
+	auto payloads = 2 + (numNames > threshold ? numNames - threshold : 0);
+	auto const& iovecs = w.iovecs();
+	CHECK(iovecs.size() == 2 * payloads + 1);
+	CHECK(iovecs[1].iov_base == b.bytes.data() && iovecs[1].iov_len == b.bytes.size());
+	CHECK(iovecs[iovecs.size() - 2].iov_base == b.text.data() && iovecs[iovecs.size() - 2].iov_len == b.text.size());
+	for (std::size_t i = threshold; i < numNames; ++i) {
+		auto const& iovec = iovecs[3 + 2 * (i - threshold)];
+		CHECK(iovec.iov_base == b.names[i].data() && iovec.iov_len == i);
+	}
+}
+
+} // namespace
+
+int main() {
+	// reusing the writer replaces the buffer
+	flowflat::GatherWriter w(threshold);
+	for (std::size_t numNames : { 0, 64, 65, 200, 10 }) {
+		gathered(w, numNames);
+	}
+
+	// nothing reaches the threshold
+	flowflat::GatherWriter large(1 << 20);
+	auto b = bulk(100);
+	b.write(large);
+	CHECK(large.iovecs().size() == 1);
+	CHECK(large.flatten() == newWriter(b));
+}
@@ -0,0 +1,150 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <flowflat/json.h>
+#include <flowflat/schema.h>
+
+#include "Check.h"
+#include "tests.h"
+
+namespace json = flowflat::json;
+namespace reflection = flowflat::reflection;
+
+namespace {
+
+template <class F>
+bool parseError(F f) {
+	try {
+		f();
+	} catch (json::ParseError&) {
+		return true;
+	}
+	return false;
+}
+
+// the bytes of the nested buffer are only checked by the verifier
+std::string nodeJson(reflection::TypeInfo const& type, bool withNested) {
+	tests::Node node;
+	node.id = -7;
+	node.name = "a \"quoted\"\n name \xc3\xa4";
+	node.pos = tests::Vec3{ 0.1, -2.5e-300, 1e300 };
+	node.tags = { "a", "", "ccc" };
+	for (int i = 0; i < 3; ++i) {
+		tests::Leaf leaf;
+		leaf.value = i;
+		node.leaves.push_back(leaf);
+	}
+	if (withNested) {
+		flowflat::NewWriter nested;
+		tests::Fan0().write(nested);
+		node.fan.assign(nested.data(), nested.data() + nested.size());
+	}
+	flowflat::NewWriter w;
+	node.write(w);
+	return json::toJson(reflection::Reflection::root(w.data(), type));
+}
+
+std::string snapshotJson(reflection::TypeInfo const& type) {
+	tests::Snapshot snapshot;
+	snapshot.title = "snapshot";
+	for (int i = 0; i < 100; ++i) {
+		tests::Item item;
+		item.id = i;
+		item.name = std::string(i % 5, 'n');
+		item.tags = { std::to_string(i), std::string(i % 3, 't') };
+		snapshot.items.push_back(item);
+	}
+	flowflat::NewWriter w;
+	snapshot.write(w);
+	return json::toJson(reflection::Reflection::root(w.data(), type));
+}
+
+// converts text to binary and back, checking that the buffer is valid
+template <class T>
+std::string roundTrip(reflection::TypeInfo const& type, std::string const& text) {
+	auto buffer = json::toBinary(type, text);
+	CHECK(T::verify(buffer.data(), buffer.size()));
+	return json::toJson(reflection::Reflection::root(buffer.data(), type));
+}
+
+void roundTrips(reflection::TypeInfo const& node, reflection::TypeInfo const& snapshot) {
+	auto text = nodeJson(node, true);
+	CHECK(roundTrip<tests::Node>(node, text) == text);
+	// scalars and structs are part of the inline data, so they are always present in the buffer
+	CHECK(roundTrip<tests::Node>(node, "{}") == R"({"id":0,"pos":{"x":0,"y":0,"z":0}})");
+	CHECK(roundTrip<tests::Node>(node, R"( { "id" : 1 , "tags" : [ ] , "name" : null } )") ==
+	      R"({"id":1,"pos":{"x":0,"y":0,"z":0},"tags":[]})");
+	text = snapshotJson(snapshot);
+	CHECK(roundTrip<tests::Snapshot>(snapshot, text) == text);
+}
+
+// the writer uses nan, inf and -inf for floats which aren't finite, the parser reads them back
+void nonFinite(reflection::TypeInfo const& node) {
+	constexpr auto inf = std::numeric_limits<double>::infinity();
+	tests::Node n;
+	n.pos = tests::Vec3{ std::numeric_limits<double>::quiet_NaN(), inf, -inf };
+	flowflat::NewWriter w;
+	n.write(w);
+	auto text = json::toJson(reflection::Reflection::root(w.data(), node));
+	CHECK(text.find(R"("pos":{"x":nan,"y":inf,"z":-inf})") != std::string::npos);
+	CHECK(roundTrip<tests::Node>(node, text) == text);
+	auto buffer = json::toBinary(node, text);
+	auto pos = tests::Node::view(buffer.data()).pos();
+	CHECK(std::isnan(pos.x) && pos.y == inf && pos.z == -inf);
+	buffer = json::toBinary(node, R"({"pos": {"x": +inf, "y": 1, "z": 2}})");
+	CHECK(tests::Node::view(buffer.data()).pos().x == inf);
+}
+
+void malformed(reflection::TypeInfo const& node) {
+	auto text = nodeJson(node, false);
+	// every proper prefix is invalid
+	for (std::size_t size = 0; size < text.size(); ++size) {
+		CHECK(parseError([&]() { (void)json::toBinary(node, text.substr(0, size)); }));
+	}
+	for (auto invalid : { R"({"id": "x"})",
+	                      R"({"id": 1.5})",
+	                      R"({"id": nan})",
+	                      R"({"pos": {"x": infinity, "y": 1, "z": 2}})",
+	                      R"({"id": 99999999999999999999})",
+	                      R"({"name": 5})",
+	                      R"({"name": "\ud800"})",
+	                      R"({"tags": [1]})",
+	                      R"({"tags": ["a",]})",
+	                      R"({"leaves": [{"value": 1}, 2]})",
+	                      R"({"pos": {"x": 1, "w": 2}})",
+	                      R"({"unknown": 1})",
+	                      R"({"id": 1} {})",
+	                      R"([])" }) {
+		CHECK(parseError([&]() { (void)json::toBinary(node, invalid); }));
+	}
+	// random corruption either fails to parse or produces a valid buffer
+	std::mt19937 rng(5);
+	for (int i = 0; i < 2000; ++i) {
+		auto bad = text;
+		for (int flips = 1 + rng() % 3; flips > 0; --flips) {
+			bad[rng() % bad.size()] = "{}[]\",:0-e.a\\ "[rng() % 15];
+		}
+		try {
+			auto buffer = json::toBinary(node, bad);
+			CHECK(tests::Node::verify(buffer.data(), buffer.size()));
+		} catch (json::ParseError&) {
+		}
+	}
+}
+
+} // namespace
+
+// argv[1] is tests.bfbs
+int main(int argc, char const* argv[]) {
+	CHECK(argc == 2);
+	flowflat::schema::SchemaFile file(argv[1]);
+	reflection::Reflection schema(file.schema());
+	auto node = schema.findType("tests.Node");
+	auto snapshot = schema.findType("tests.Snapshot");
+	CHECK(node && snapshot);
+	roundTrips(*node, *snapshot);
+	nonFinite(*node);
+	malformed(*node);
+}
@@ -0,0 +1,36 @@
+#include <iterator>
+
+#include "Check.h"
+#include "tests.h"
+
+// tests.fbs generated with --layout-profile tests/layout.prof
+int main() {
+	// the hot fields come first, the hottest one right after the vtable offset
+	auto const& vtable = tests::Node::flowFlatVTable;
+	constexpr unsigned name = 1;
+	constexpr unsigned fan = 5;
+	CHECK(vtable[2 + fan] == sizeof(flowflat::soffset_t));
+	CHECK(vtable[2 + name] == sizeof(flowflat::soffset_t) + sizeof(flowflat::uoffset_t));
+	for (unsigned field = 0; field + 2 < std::size(vtable); ++field) {
+		CHECK(field == name || field == fan || vtable[2 + field] > vtable[2 + name]);
+	}
+
+	// buffers with this layout work like any other
+	tests::Node node;
+	node.id = 3;
+	node.name = "node";
+	node.pos = tests::Vec3{ 1, 2, 3 };
+	node.tags = { "t" };
+	node.leaves.resize(2);
+	flowflat::NewWriter nested;
+	tests::Fan0().write(nested);
+	node.fan.assign(nested.data(), nested.data() + nested.size());
+	flowflat::NewWriter w;
+	node.write(w);
+	CHECK(tests::Node::verify(w.data(), w.size()));
+	auto view = tests::Node::view(w.data());
+	CHECK(view.id() == 3 && view.name() == "node" && view.pos().z == 3 && view.tags()[0] == "t");
+	CHECK(view.leaves().size() == 2 && view.fan().size() == node.fan.size());
+	auto read = tests::Node::read(w.data());
+	CHECK(read.fan == node.fan && read.tags == node.tags);
+}
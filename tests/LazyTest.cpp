@@ -0,0 +1,61 @@
+#include <cstring>
+#include <string>
+
+#include "Check.h"
+#include "tests.h"
+
+namespace {
+
+tests::Node node() {
+	tests::Node node;
+	node.id = 7;
+	node.name = "a name which doesn't fit into the small string buffer";
+	node.pos = tests::Vec3{ 1, 2, 3 };
+	node.tags = { "a", "", "ccc" };
+	for (int i = 0; i < 5; ++i) {
+		node.leaves.emplace_back().value = i;
+	}
+	flowflat::NewWriter nested;
+	tests::Fan0().write(nested);
+	node.fan.assign(nested.data(), nested.data() + nested.size());
+	return node;
+}
+
+bool sameBuffer(tests::Node const& lhs, tests::Node const& rhs) {
+	flowflat::NewWriter l;
+	lhs.write(l);
+	flowflat::NewWriter r;
+	rhs.write(r);
+	return l.size() == r.size() && std::memcmp(l.data(), r.data(), l.size()) == 0;
+}
+
+} // namespace
+
+int main() {
+	auto n = node();
+	flowflat::NewWriter w;
+	n.write(w);
+
+	// every field is decoded once, later accesses return the cached value
+	auto lazy = tests::Node::lazy(w.data());
+	CHECK(lazy.id() == 7 && lazy.pos().y == 2);
+	auto const& name = lazy.name();
+	CHECK(name == n.name && &lazy.name() == &name && name.data() == lazy.name().data());
+	auto const& tags = lazy.tags();
+	CHECK(tags == n.tags && &lazy.tags() == &tags);
+	auto const& leaves = lazy.leaves();
+	CHECK(leaves.size() == 5 && &lazy.leaves() == &leaves);
+	for (int i = 0; i < 5; ++i) {
+		CHECK(leaves[i].value() == i);
+	}
+	CHECK(&lazy.fan() == &lazy.fan() && lazy.fan() == n.fan);
+
+	// copies share nothing with the original
+	auto copy = lazy;
+	CHECK(copy.name() == name && &copy.name() != &name);
+
+	// materialize decodes what wasn't accessed yet and reuses the rest
+	CHECK(sameBuffer(tests::Node::lazy(w.data()).materialize(), n));
+	CHECK(sameBuffer(lazy.materialize(), n));
+	CHECK(sameBuffer(lazy.materialize(), tests::Node::read(w.data())));
+}
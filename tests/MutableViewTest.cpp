@@ -0,0 +1,58 @@
+#include <vector>
+
+#include "Check.h"
+#include "tests.h"
+
+namespace {
+
+template <class T>
+std::vector<char> bytes(T const& table) {
+	flowflat::NewWriter w;
+	table.write(w);
+	return std::vector<char>(w.data(), w.data() + w.size());
+}
+
+void mutate() {
+	tests::Node node;
+	node.id = 1;
+	node.name = "node";
+	node.pos = tests::Vec3{ 1, 2, 3 };
+	auto buffer = bytes(node);
+	auto m = tests::Node::mutableView(buffer.data());
+	CHECK(m.mutate_id(-77) && m.mutate_pos(tests::Vec3{ 4, 5, 6 }));
+	CHECK(tests::Node::verify(buffer.data(), buffer.size()));
+	auto v = tests::Node::view(buffer.data());
+	CHECK(v.id() == -77 && v.pos().x == 4 && v.pos().z == 6 && v.name() == "node");
+
+	tests::Counter counter;
+	counter.value = 1;
+	counter.child.value = 2;
+	buffer = bytes(counter);
+	auto c = tests::Counter::mutableView(buffer.data());
+	CHECK(c.mutate_extra(3) && c.mutable_child().mutate_value(4));
+	auto cv = tests::Counter::view(buffer.data());
+	CHECK(cv.value() == 1 && cv.extra() == 3 && cv.child().value() == 4);
+
+	// no buffer at all
+	CHECK(!tests::Node::MutableView().mutate_id(3));
+}
+
+// fields which are missing in the buffer can't be set
+void elided() {
+	tests::Leaf leaf;
+	leaf.value = 5;
+	auto buffer = bytes(leaf);
+	auto old = buffer;
+	auto c = tests::Counter::mutableView(buffer.data());
+	CHECK(!c.mutate_extra(3));
+	CHECK(!c.mutable_child().mutate_value(4));
+	CHECK(buffer == old);
+	CHECK(c.mutate_value(6) && tests::Leaf::view(buffer.data()).value() == 6);
+}
+
+} // namespace
+
+int main() {
+	mutate();
+	elided();
+}
@@ -0,0 +1,36 @@
+#include <string>
+
+#include <flowflat/gather.h>
+
+#include "Check.h"
+#include "Fixtures.h"
+#include "tests.h"
+
+int main() {
+	for (uint32_t numItems : { 0, 1, 7, 20011 }) {
+		auto s = fixtures::snapshot(numItems);
+		flowflat::NewWriter sequential;
+		s.write(sequential);
+		CHECK(tests::Snapshot::verify(sequential.data(), sequential.size()));
+		flowflat::NewWriter sequentialPrefixed;
+		s.writeSizePrefixed(sequentialPrefixed);
+		for (unsigned threads : { 1, 2, 3, 8 }) {
+			// the buffer doesn't depend on the number of threads
+			flowflat::NewWriter out;
+			flowflat::ParallelWriter parallel(out, threads);
+			s.write(parallel);
+			CHECK(fixtures::equal(out, sequential));
+			flowflat::NewWriter prefixed;
+			flowflat::ParallelWriter parallelPrefixed(prefixed, threads);
+			s.writeSizePrefixed(parallelPrefixed);
+			CHECK(fixtures::equal(prefixed, sequentialPrefixed));
+			CHECK(tests::Snapshot::verifySizePrefixed(prefixed.data(), prefixed.size()));
+			// scatter-gather writers keep gathering (the title reaches the threshold)
+			flowflat::GatherWriter gather(8);
+			flowflat::ParallelWriter parallelGather(gather, threads);
+			s.write(parallelGather);
+			CHECK(gather.flatten() == std::string(sequential.data(), sequential.size()));
+			CHECK(gather.iovecs().size() > 1);
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "Check.h"
+#include "tests.h"
+
+// tests.fbs generated with --pmr: tables use std::pmr containers and pass their allocator on to everything they own
+namespace {
+
+// counts the allocations which reach it
+class Counting : public std::pmr::memory_resource {
+public:
+	std::size_t allocations = 0;
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+		++allocations;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+	[[nodiscard]] bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+		return this == &other;
+	}
+};
+
+// longer than the small string buffer, so every string allocates
+std::string longString(char const* prefix) {
+	return std::string(prefix) + std::string(40, '.');
+}
+
+tests::Snapshot snapshot() {
+	tests::Snapshot snapshot;
+	snapshot.title = longString("title");
+	for (int i = 0; i < 10; ++i) {
+		auto& item = snapshot.items.emplace_back();
+		item.id = i;
+		item.name = longString("name");
+		item.tags.emplace_back(longString("tag"));
+	}
+	return snapshot;
+}
+
+} // namespace
+
+int main() {
+	flowflat::NewWriter w;
+	snapshot().write(w);
+	auto title = longString("title");
+	tests::Tagged tagged;
+	tests::Item item;
+	item.name = longString("item");
+	tagged.payload = item;
+	flowflat::NewWriter taggedBuffer;
+	tagged.write(taggedBuffer);
+
+	Counting arena;
+	Counting other;
+	Counting fallback;
+	std::pmr::set_default_resource(&fallback);
+	{
+		// everything read() decodes comes from the given allocator
+		auto read = tests::Snapshot::read(w.data(), &arena);
+		CHECK(fallback.allocations == 0 && arena.allocations > 0);
+		CHECK(std::string_view(read.title) == title && read.items.size() == 10);
+		CHECK(read.items.get_allocator().resource() == &arena);
+		CHECK(read.items[3].name.get_allocator().resource() == &arena);
+		CHECK(read.items[3].tags[0].get_allocator().resource() == &arena);
+
+		// copies with another allocator move everything to it
+		auto before = arena.allocations;
+		tests::Snapshot copy(read, &other);
+		CHECK(arena.allocations == before && copy.items[9].tags[0].get_allocator().resource() == &other);
+		CHECK(copy.items[9].tags[0] == read.items[9].tags[0]);
+
+		// containers of tables pass their allocator on
+		std::pmr::vector<tests::Snapshot> snapshots(&other);
+		snapshots.push_back(read);
+		CHECK(snapshots[0].items[0].name.get_allocator().resource() == &other);
+
+		// so do unions
+		auto readTagged = tests::Tagged::read(taggedBuffer.data(), &arena);
+		CHECK(std::get<tests::Item>(readTagged.payload).name.get_allocator().resource() == &arena);
+
+		auto lazy = tests::Snapshot::lazy(w.data(), &arena);
+		CHECK(lazy.items()[2].name() == read.items[2].name);
+		CHECK(lazy.materialize().items[2].tags.get_allocator().resource() == &arena);
+		CHECK(fallback.allocations == 0);
+	}
+	std::pmr::set_default_resource(nullptr);
+}
@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <flowflat/profile.h>
+
+#include "Check.h"
+#include "Fixtures.h"
+#include "tests.h"
+
+// tests.fbs generated with --profile-access
+namespace {
+
+namespace profile = flowflat::profile;
+
+// 999 if the field wasn't found
+uint64_t accesses(std::string_view table, std::string_view field) {
+	for (auto const& t : profile::snapshot()) {
+		for (auto const& f : t.fields) {
+			if (t.table == table && f.field == field) {
+				return f.accesses;
+			}
+		}
+	}
+	return 999;
+}
+
+uint64_t decodes(std::string_view table) {
+	for (auto const& t : profile::snapshot()) {
+		if (t.table == table) {
+			return t.decodes;
+		}
+	}
+	return 999;
+}
+
+} // namespace
+
+int main() {
+	flowflat::NewWriter w;
+	fixtures::snapshot(10).write(w);
+	auto view = tests::Snapshot::view(w.data());
+
+	// accesses of views are counted on every thread
+	long ids = 0;
+	for (auto item : view.items()) {
+		ids += item.id();
+	}
+	std::thread([view]() {
+		for (auto item : view.items()) {
+			(void)item.name();
+		}
+	}).join();
+	CHECK(ids == 45);
+	CHECK(accesses("tests.Snapshot", "items") == 2 && accesses("tests.Snapshot", "title") == 0);
+	CHECK(accesses("tests.Item", "id") == 10 && accesses("tests.Item", "name") == 10);
+	CHECK(accesses("tests.Item", "tags") == 0);
+
+	// a lazy table accesses a field when it decodes it
+	auto lazy = tests::Snapshot::lazy(w.data());
+	(void)lazy.title();
+	(void)lazy.title();
+	CHECK(accesses("tests.Snapshot", "title") == 1);
+
+	// read() counts decodes, but no accesses
+	auto read = tests::Snapshot::read(w.data());
+	CHECK(read.items.size() == 10);
+	CHECK(decodes("tests.Snapshot") == 1 && decodes("tests.Item") == 10);
+	CHECK(accesses("tests.Item", "tags") == 0 && accesses("tests.Snapshot", "items") == 2);
+
+	// the dump is what flowflatc --layout-profile reads
+	std::ostringstream out;
+	profile::dump(out);
+	auto dump = out.str();
+	CHECK(dump.find("tests.Item.id 10\n") != std::string::npos);
+	CHECK(dump.find("tests.Snapshot.items 2\n") != std::string::npos);
+
+	profile::reset();
+	CHECK(accesses("tests.Item", "id") == 0 && decodes("tests.Item") == 0);
+}
@@ -0,0 +1,137 @@
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "Fixtures.h"
+#include "tests.h"
+
+namespace {
+
+// large payloads, vectors of every kind and vectors within the elements of vectors
+tests::Bulk bulk() {
+	tests::Bulk bulk;
+	for (int i = 0; i < 5000; ++i) {
+		bulk.points.push_back(tests::Vec3{ double(i), -double(i), 0.5 });
+	}
+	for (int i = 0; i < 10000; ++i) {
+		bulk.flags.push_back(i % 3 == 0);
+	}
+	for (int i = 0; i < 300000; ++i) {
+		bulk.bytes.push_back(uint8_t(i * 7));
+	}
+	for (int i = 0; i < 3000; ++i) {
+		bulk.names.push_back(std::string(i % 37, char('a' + i % 26)));
+	}
+	for (int i = 0; i < 500; ++i) {
+		tests::Node node;
+		node.id = i;
+		node.name = std::string(i % 50, 'n');
+		node.tags.assign(i % 20, std::string(i % 7, 't'));
+		node.leaves.resize(i % 30);
+		bulk.nodes.push_back(node);
+	}
+	// one copy is larger than every budget below but the last
+	bulk.text = std::string(200000, 'x');
+	return bulk;
+}
+
+constexpr char pattern = char(0xa5);
+
+// fills its buffers with a pattern, so the bytes a step wrote can be counted
+class PatternWriter : public flowflat::Writer {
+public:
+	std::vector<char> buffer;
+
+	char* allocateBuffer(int bytes) override {
+		buffer.assign(bytes, pattern);
+		return buffer.data();
+	}
+};
+
+// What a step can do beyond its budget: finish the inline data of the tables it started and the headers of the strings
+// and vectors they reference (their contents are deferred).
+constexpr std::size_t slack = 512;
+
+// the buffer is the same as without steps, and every step sizes or writes about bytesPerStep bytes at most
+template <class T>
+void resume(T const& root, std::size_t elementsPerStep, std::size_t bytesPerStep, flowflat::Framing const& framing) {
+	flowflat::NewWriter sequential;
+	root.write(sequential, framing);
+	PatternWriter out;
+	auto resumable = root.writeResumable(out, elementsPerStep, bytesPerStep, framing);
+	std::size_t sizingSteps = 0;
+	std::vector<char> before;
+	for (bool more = true; more;) {
+		more = resumable.step();
+		if (out.buffer.empty()) {
+			++sizingSteps;
+			continue;
+		}
+		if (before.empty()) {
+			before.assign(out.buffer.size(), pattern);
+		}
+		std::size_t written = 0;
+		for (std::size_t i = 0; i < before.size(); ++i) {
+			written += before[i] != out.buffer[i];
+		}
+		CHECK(written <= bytesPerStep + slack);
+		before = out.buffer;
+	}
+	CHECK(resumable.done() && !resumable.step());
+	CHECK(out.buffer.size() == std::size_t(sequential.size()));
+	CHECK(std::memcmp(out.buffer.data(), sequential.data(), out.buffer.size()) == 0);
+	// the sizing pass is split as well: every byte of the buffer (but padding) is sized by some step
+	CHECK(sizingSteps * (bytesPerStep + slack) >= out.buffer.size() / 2);
+}
+
+} // namespace
+
+int main() {
+	for (uint32_t numItems : { 0, 5, 1000, 20011 }) {
+		auto s = fixtures::snapshot(numItems);
+		flowflat::NewWriter sequential;
+		s.write(sequential);
+		flowflat::NewWriter sequentialPrefixed;
+		s.writeSizePrefixed(sequentialPrefixed);
+		for (std::size_t elementsPerStep : { 1, 7, 100, 100000 }) {
+			if (elementsPerStep == 1 && numItems > 1000) {
+				continue;
+			}
+			// the buffer is the same as without steps, and a step writes at most elementsPerStep items
+			flowflat::NewWriter out;
+			auto resumable = s.writeResumable(out, elementsPerStep, std::size_t(1) << 30);
+			std::size_t steps = 1;
+			while (resumable.step()) {
+				++steps;
+			}
+			CHECK(resumable.done() && !resumable.step());
+			CHECK(steps >= 2 * (numItems / elementsPerStep));
+			CHECK(fixtures::equal(out, sequential));
+
+			flowflat::NewWriter prefixed;
+			auto resumablePrefixed =
+			    s.writeResumable(prefixed, elementsPerStep, std::size_t(1) << 30, flowflat::Framing{ {}, true });
+			while (resumablePrefixed.step()) {
+			}
+			CHECK(fixtures::equal(prefixed, sequentialPrefixed));
+			CHECK(tests::Snapshot::verifySizePrefixed(prefixed.data(), prefixed.size()));
+		}
+	}
+
+	// steps bounded by bytes
+	auto s = fixtures::snapshot(1000);
+	for (std::size_t bytesPerStep : { 64, 1000 }) {
+		resume(s, 100000, bytesPerStep, {});
+		resume(s, 3, bytesPerStep, flowflat::Framing{ {}, true });
+	}
+	auto b = bulk();
+	for (auto [elementsPerStep, bytesPerStep] : { std::pair<std::size_t, std::size_t>{ 7, 4096 },
+	                                              { 100, 1 << 16 },
+	                                              { 1000000, 1 << 16 },
+	                                              { 1000000, std::size_t(1) << 30 } }) {
+		resume(b, elementsPerStep, bytesPerStep, {});
+	}
+	resume(b, 100, 1 << 16, flowflat::Framing{ {}, true });
+}
@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <string_view>
+
+#include <flowflat/stats.h>
+
+#include "Check.h"
+#include "Fixtures.h"
+#include "tests.h"
+
+// linked against the runtime with FLOWFLAT_STATS defined
+namespace {
+
+namespace stats = flowflat::stats;
+
+struct Events {
+	int begins = 0;
+	int ends = 0;
+};
+
+void trace(void* context, stats::Event event, std::string_view type) {
+	CHECK(type == "tests.Snapshot");
+	auto& events = *static_cast<Events*>(context);
+	++(event == stats::Event::EncodeBegin || event == stats::Event::DecodeBegin ? events.begins : events.ends);
+}
+
+stats::Snapshot counted(std::string_view type) {
+	for (auto const& s : stats::snapshot()) {
+		if (s.type == type) {
+			return s;
+		}
+	}
+	return stats::Snapshot{};
+}
+
+} // namespace
+
+int main() {
+	static_assert(stats::enabled);
+	constexpr uint32_t numItems = 3000;
+	auto s = fixtures::snapshot(numItems);
+	Events events;
+	stats::setTraceHook(trace, &events);
+
+	// sequential, parallel and resumable serialization count the same
+	flowflat::NewWriter sequential;
+	s.write(sequential);
+	flowflat::NewWriter parallel;
+	flowflat::ParallelWriter parallelWriter(parallel, 4);
+	s.write(parallelWriter);
+	flowflat::NewWriter resumed;
+	auto resumable = s.writeResumable(resumed, 100, 1 << 12);
+	while (resumable.step()) {
+	}
+	CHECK(fixtures::equal(sequential, parallel) && fixtures::equal(sequential, resumed));
+
+	CHECK(tests::Snapshot::verify(sequential.data(), sequential.size()));
+	CHECK(!tests::Snapshot::verify(sequential.data(), 10));
+	auto read = tests::Snapshot::read(sequential.data());
+	CHECK(read.items.size() == numItems);
+
+	auto c = counted("tests.Snapshot");
+	CHECK(c.messages == 3 && c.allocations == 3 && c.bytes == 3 * uint64_t(sequential.size()));
+	// every item finds the vtable of Item, the root the one of Snapshot
+	CHECK(c.vtableHits == 3 * (numItems + 1));
+	CHECK(c.decodes == 1 && c.verifyFailures == 1);
+	CHECK(events.begins == 4 && events.ends == 4);
+
+	stats::setTraceHook(nullptr);
+	s.write(sequential);
+	CHECK(events.begins == 4 && counted("tests.Snapshot").messages == 4);
+	stats::reset();
+	c = counted("tests.Snapshot");
+	CHECK(c.type == "tests.Snapshot" && c.messages == 0 && c.bytes == 0 && c.vtableHits == 0);
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include <flowflat/stream.h>
+
+#include "Check.h"
+#include "Fixtures.h"
+#include "tests.h"
+
+namespace {
+
+constexpr uint32_t numItems = 2000;
+
+// large tags, so items span many chunks
+std::size_t tagSize(uint32_t i, uint32_t) {
+	return i % 7 * 100;
+}
+
+std::string snapshot() {
+	flowflat::NewWriter w;
+	fixtures::snapshot(numItems, tagSize).write(w);
+	return std::string(w.data(), w.size());
+}
+
+struct Result {
+	uint32_t visited = 0;
+	bool done = false;
+	// pollVerified found an invalid item
+	bool invalid = false;
+};
+
+// feeds the first size bytes of buffer (all if size isn't set) to a stream reader in random chunks and polls the items
+// after every chunk
+Result stream(std::string const& buffer, bool verify, std::optional<std::size_t> size = {}) {
+	std::mt19937 rng(3);
+	auto total = size.value_or(buffer.size());
+	flowflat::StreamReader reader(std::size_t(1) << 32);
+	std::optional<flowflat::StreamedTables<tests::Item>> items;
+	Result res;
+	auto visitor = [&res](uint32_t i, tests::Item::View item) {
+		CHECK(i == res.visited && item.id() == long(i) && item.name().size() == i % 13);
+		CHECK(item.tags().size() == i % 4);
+		for (auto tag : item.tags()) {
+			CHECK(tag.size() == tagSize(i, 0));
+		}
+		++res.visited;
+	};
+	for (std::size_t position = 0; !reader.complete();) {
+		auto chunk = std::min<std::size_t>(1 + rng() % 3000, total - position);
+		reader.append(buffer.data() + position, chunk);
+		position += chunk;
+		if (position == total) {
+			reader.finish();
+		}
+		if (!items && reader.rootTable()) {
+			auto snapshot = tests::Snapshot::View(reader.rootTable());
+			CHECK(snapshot.title() == "snapshot");
+			items.emplace(reader, snapshot.items());
+		}
+		if (!items) {
+			continue;
+		}
+		if (!verify) {
+			items->poll(visitor);
+			continue;
+		}
+		try {
+			items->pollVerified(visitor);
+		} catch (std::runtime_error&) {
+			res.invalid = true;
+			return res;
+		}
+	}
+	res.done = items && items->done();
+	return res;
+}
+
+void roundTrip() {
+	auto buffer = snapshot();
+	for (bool verify : { false, true }) {
+		auto res = stream(buffer, verify);
+		CHECK(res.visited == numItems && res.done && !res.invalid);
+	}
+}
+
+void corrupted() {
+	auto buffer = snapshot();
+	auto items = tests::Snapshot::view(buffer.data()).items();
+	auto at = [&buffer](char const* p) { return std::size_t(p - buffer.data()); };
+
+	// a name which is longer than its item
+	auto bad = buffer;
+	flowflat::store(bad.data() + at(items[100].name().data()) - sizeof(uint32_t), uint32_t(1) << 20);
+	auto res = stream(bad, true);
+	CHECK(res.invalid && res.visited == 100);
+
+	// a vector of tags which is longer than its item
+	bad = buffer;
+	auto tags = items[203].tags();
+	CHECK(tags.size() == 3);
+	flowflat::store(bad.data() + at(tags.data()) - sizeof(uint32_t), uint32_t(1) << 16);
+	res = stream(bad, true);
+	CHECK(res.invalid && res.visited == 203);
+
+	// a tag which references the data of a later item, which didn't necessarily arrive when item 203 is visited
+	bad = buffer;
+	auto distance = at(items[205].data()) - at(items[203].data());
+	flowflat::store(bad.data() + at(tags.data()),
+	                flowflat::uoffset_t(flowflat::load<flowflat::uoffset_t>(tags.data()) + distance));
+	res = stream(bad, true);
+	CHECK(res.invalid && res.visited == 203);
+
+	// the stream ends in the middle of the last item
+	auto last = at(items[numItems - 1].data());
+	res = stream(buffer, true, last + 8);
+	CHECK(res.invalid && res.visited == numItems - 1);
+	// or before the last item started, then the item before it never ends
+	res = stream(buffer, true, last - 1);
+	CHECK(!res.invalid && !res.done && res.visited == numItems - 2);
+}
+
+// the fields of the root after the vector are still there when all items were visited
+void trailingField() {
+	tests::Report report;
+	for (int i = 0; i < 100; ++i) {
+		tests::Item item;
+		item.id = i;
+		item.name = std::string(100, 'n');
+		report.items.push_back(item);
+	}
+	report.summary = std::string(20000, 's');
+	flowflat::NewWriter w;
+	report.write(w);
+	auto view = tests::Report::view(w.data());
+	CHECK(view.summary().data() > view.items()[99].name().data());
+
+	flowflat::StreamReader reader(std::size_t(1) << 32);
+	reader.append(w.data(), w.size());
+	reader.finish();
+	auto root = tests::Report::View(reader.rootTable());
+	flowflat::StreamedTables<tests::Item> items(reader, root.items());
+	CHECK(items.poll([](uint32_t, tests::Item::View) {}) == 100 && items.done());
+	CHECK(root.summary() == report.summary);
+}
+
+} // namespace
+
+int main() {
+	roundTrip();
+	corrupted();
+	trailingField();
+}
@@ -0,0 +1,153 @@
+#include <cstring>
+#include <string>
+
+#include "Check.h"
+#include "tests.h"
+
+namespace {
+
+constexpr uint32_t fanTables(uint32_t n) {
+	return 1 + n + n * n + n * n * n + n * n * n * n;
+}
+
+// a Fan0 buffer where all n elements of every kids vector reference the same table, so verifying it visits
+// fanTables(n) tables while the buffer only holds five
+std::string fanOut(uint32_t n) {
+	auto append = [](std::string& buffer, auto value) {
+		buffer.append(reinterpret_cast<char const*>(&value), sizeof(value));
+	};
+	std::string buffer;
+	append(buffer, flowflat::uoffset_t(12));
+	// every fan table and the leaf have the same vtable
+	buffer.append(reinterpret_cast<char const*>(tests::Fan0::flowFlatVTable), sizeof(tests::Fan0::flowFlatVTable));
+	buffer.resize(12);
+	for (int level = 0; level < 5; ++level) {
+		auto table = buffer.size();
+		append(buffer, flowflat::soffset_t(table - 4));
+		if (level == 4) {
+			append(buffer, int32_t(42));
+			break;
+		}
+		append(buffer, flowflat::uoffset_t(4));
+		append(buffer, n);
+		auto next = buffer.size() + sizeof(flowflat::uoffset_t) * n;
+		for (uint32_t i = 0; i < n; ++i) {
+			append(buffer, flowflat::uoffset_t(next - buffer.size()));
+		}
+	}
+	return buffer;
+}
+
+bool verifyFan(std::string const& buffer, std::size_t maxTables) {
+	flowflat::Verifier v(buffer.data(), buffer.size(), 64, maxTables);
+	return tests::Fan0::verify(v, v.root()) && v.ok();
+}
+
+tests::Node node() {
+	tests::Node node;
+	node.id = 7;
+	node.name = "node";
+	node.pos = tests::Vec3{ 1, 2, 3 };
+	node.tags = { "a", "", "ccc" };
+	for (int i = 0; i < 5; ++i) {
+		tests::Leaf leaf;
+		leaf.value = i;
+		node.leaves.push_back(leaf);
+	}
+	auto fan = fanOut(2);
+	node.fan.assign(fan.begin(), fan.end());
+	return node;
+}
+
+void roundTrip() {
+	flowflat::NewWriter w;
+	node().write(w);
+	CHECK(tests::Node::verify(w.data(), w.size()));
+	auto view = tests::Node::view(w.data());
+	CHECK(view.id() == 7 && view.name() == "node" && view.pos().z == 3);
+	CHECK(view.tags().size() == 3 && view.tags()[2] == "ccc");
+	CHECK(view.leaves().size() == 5 && view.leaves()[4].value() == 4);
+	CHECK(view.fan_nested_root().kids()[1].kids()[0].kids().size() == 2);
+
+	tests::Node empty;
+	flowflat::NewWriter ew;
+	empty.write(ew);
+	CHECK(tests::Node::verify(ew.data(), ew.size()));
+	CHECK(!tests::Node::verify(ew.data(), 0));
+}
+
+void truncated() {
+	flowflat::NewWriter w;
+	node().write(w);
+	for (std::size_t size = 0; size < std::size_t(w.size()); ++size) {
+		CHECK(!tests::Node::verify(w.data(), size));
+	}
+}
+
+void corrupted() {
+	flowflat::NewWriter w;
+	node().write(w);
+	std::string buffer(w.data(), w.size());
+	// a root offset which points outside of the buffer
+	auto bad = buffer;
+	flowflat::store(bad.data(), flowflat::uoffset_t(buffer.size()));
+	CHECK(!tests::Node::verify(bad.data(), bad.size()));
+	// a string which isn't terminated
+	auto name = tests::Node::view(buffer.data()).name();
+	bad = buffer;
+	bad[name.data() - buffer.data() + name.size()] = 'x';
+	CHECK(!tests::Node::verify(bad.data(), bad.size()));
+	// a vector which is longer than the buffer
+	auto tags = tests::Node::view(buffer.data()).tags();
+	bad = buffer;
+	flowflat::store(bad.data() + (tags.data() - buffer.data()) - sizeof(uint32_t), uint32_t(1) << 30);
+	CHECK(!tests::Node::verify(bad.data(), bad.size()));
+	// a table in the nested buffer whose vtable lies before the nested buffer
+	auto fan = tests::Node::view(buffer.data()).fan();
+	bad = buffer;
+	auto root = bad.data() + (reinterpret_cast<char const*>(fan.data()) - buffer.data()) + 12;
+	flowflat::store(root, flowflat::soffset_t(1000));
+	CHECK(!tests::Node::verify(bad.data(), bad.size()));
+}
+
+void tableBudget() {
+	// the default budget stops the verifier long before it visits all 64^4 leaves
+	auto fan = fanOut(64);
+	CHECK(!tests::Fan0::verify(fan.data(), fan.size()));
+
+	fan = fanOut(4);
+	CHECK(tests::Fan0::verify(fan.data(), fan.size()));
+	CHECK(verifyFan(fan, fanTables(4)));
+	CHECK(!verifyFan(fan, fanTables(4) - 1));
+
+	// a nested buffer gets the budget the outer verifier has left
+	flowflat::NewWriter w;
+	node().write(w);
+	auto verifyNode = [&](std::size_t maxTables) {
+		flowflat::Verifier v(w.data(), w.size(), 64, maxTables);
+		return tests::Node::verify(v, v.root()) && v.ok();
+	};
+	auto tables = 1 + 5 + fanTables(2);
+	CHECK(verifyNode(tables));
+	CHECK(!verifyNode(tables - 1));
+}
+
+void depthLimit() {
+	auto fan = fanOut(1);
+	auto verifyDepth = [&](unsigned maxDepth) {
+		flowflat::Verifier v(fan.data(), fan.size(), maxDepth);
+		return tests::Fan0::verify(v, v.root()) && v.ok();
+	};
+	CHECK(verifyDepth(5));
+	CHECK(!verifyDepth(4));
+}
+
+} // namespace
+
+int main() {
+	roundTrip();
+	truncated();
+	corrupted();
+	tableBudget();
+	depthLimit();
+}